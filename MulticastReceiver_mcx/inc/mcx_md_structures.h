@@ -98,6 +98,35 @@ struct OrderModifySamePriority {
   PriceType price;
 };
 
+struct OrderDelete {
+  MessageHeader header;
+  UTCTimestamp exchange_ts;
+  UTCTimestamp transaction_ts;
+  int64_t security_id;
+  UTCTimestamp reserve2;
+  QuantityType display_qty;
+  uint8_t side;
+  uint8_t order_type;
+  std::array<char, 6> pad6;
+  PriceType price;
+};
+
+// full and partial executions share the same wire layout, only the template id differs.
+struct OrderExecution {
+  MessageHeader header;
+  uint8_t side;
+  uint8_t order_type;
+  uint8_t algo_trade_indicator;
+  std::array<char, 5> pad5;
+  PriceType price;
+  UTCTimestamp reserve2;
+  int64_t security_id;
+  uint32_t trade_match_id;
+  std::array<char, 4> pad4;
+  QuantityType last_qty;
+  PriceType last_px;
+};
+
 //@TODO: more msg structures can be added if required to parse.
 
 // Constants and enums for market states
@@ -135,5 +164,9 @@ inline bool isValidTemplateId(uint16_t id) {
 static_assert(sizeof(MessageHeader) == 8, "MessageHeader size mismatch");
 static_assert(sizeof(PacketHeader) == 32, "PacketHeader size mismatch");
 static_assert(sizeof(HeartBeat) == 16, "HeartBeat size mismatch");
+static_assert(sizeof(OrderAdd) == 56, "OrderAdd size mismatch");
+static_assert(sizeof(OrderModify) == 80, "OrderModify size mismatch");
+static_assert(sizeof(OrderDelete) == 64, "OrderDelete size mismatch");
+static_assert(sizeof(OrderExecution) == 64, "OrderExecution size mismatch");
 
 #pragma pack(pop)
@@ -0,0 +1,548 @@
+#include "mcx_md_structures.h"
+#include <arpa/inet.h>
+#include <netinet/in.h>
+#include <sys/socket.h>
+#include <unistd.h>
+#include <algorithm>
+#include <array>
+#include <chrono>
+#include <cstring>
+#include <iostream>
+#include <signal.h>
+#include <spdlog/sinks/stdout_color_sinks.h>
+#include <spdlog/spdlog.h>
+#include <thread>
+#include <vector>
+#include <yaml-cpp/yaml.h>
+
+using namespace std::chrono;
+
+// Global flags for signal handling
+volatile sig_atomic_t running = 1;
+volatile sig_atomic_t force_gap = 0;
+volatile sig_atomic_t force_reorder = 0;
+
+void signalHandler(int /*signum*/) { running = 0; }
+
+// SIGUSR1 -> one gap, SIGUSR2 -> one reorder + duplicate, picked up by the next batch.
+void faultSignalHandler(int signum) {
+  if (signum == SIGUSR1) force_gap = 1;
+  else force_reorder = 1;
+}
+
+/**
+ * Synthetic MCX (EOBI style) multicast publisher.
+ * Emits PacketHeader + order add/modify/delete/execution sequences and
+ * standalone heartbeats so mcx_receiver can be load tested without the exchange.
+ */
+class MCXTrafficGenerator {
+private:
+  struct Config {
+    std::string multicast_group;
+    uint16_t port;
+    std::string interface_ip;
+    int ttl;
+
+    int32_t market_segment_id;
+    uint8_t partition_id;
+    uint32_t securities;
+    int64_t base_security_id;
+    PriceType base_price;
+    PriceType tick_size;
+
+    uint64_t target_rate;
+    uint32_t msgs_per_packet;
+    uint32_t batch_size;
+    uint64_t duration_sec;
+    uint32_t heartbeat_interval_ms;
+    uint32_t stats_interval_ms;
+
+    std::array<uint32_t, 5> mix; // add, modify, delete, partial, full
+
+    uint32_t gap_ppm;
+    uint32_t gap_packets;
+    uint32_t reorder_ppm;
+    uint32_t duplicate_ppm;
+
+    std::string log_level;
+  };
+
+  enum class Kind : uint8_t { Add, Modify, Delete, PartialExecution, FullExecution };
+
+  // resting order the generator knows about, so modifies/deletes/executions reference real state.
+  struct LiveOrder {
+    int64_t security_id;
+    PriceType price;
+    QuantityType quantity;
+    UTCTimestamp priority_ts;
+    uint8_t side;
+  };
+
+  // xorshift64*, cheap enough to call several times per message on the hot path.
+  struct FastRng {
+    uint64_t state;
+    uint64_t next() {
+      state ^= state >> 12;
+      state ^= state << 25;
+      state ^= state >> 27;
+      return state * 0x2545F4914F6CDD1Dull;
+    }
+    uint32_t below(uint32_t n) { return static_cast<uint32_t>((next() >> 32) * n >> 32); }
+    bool chance(uint32_t ppm) { return ppm && below(1000000) < ppm; }
+  };
+
+  static constexpr size_t kMaxDatagram = 1472; // fits a 1500 byte MTU
+  static constexpr size_t kMaxMsgSize = sizeof(OrderModify);
+  static constexpr size_t kMaxLiveOrders = 200000;
+
+  Config config_;
+  std::shared_ptr<spdlog::logger> logger_;
+  int sd_{-1};
+  sockaddr_in dest_{};
+  FastRng rng_{0x9E3779B97F4A7C15ull};
+  std::vector<LiveOrder> live_orders_;
+  std::array<uint32_t, 5> mix_cumulative_{};
+  uint32_t mix_total_{0};
+
+  uint32_t packet_seq_{0};
+  uint32_t msg_seq_{0};
+  uint32_t trade_match_id_{0};
+  UTCTimestamp now_ns_{0};
+  uint32_t pending_gap_{0};
+
+  // one datagram buffer per batch slot; duplicates re-use the slot's iovec.
+  std::vector<std::array<char, kMaxDatagram>> buffers_;
+  std::vector<iovec> iovecs_;
+  std::vector<mmsghdr> msgs_;
+
+  struct Stats {
+    uint64_t msgs;
+    uint64_t packets;
+    uint64_t gaps;
+    uint64_t dropped_packets;
+    uint64_t reorders;
+    uint64_t duplicates;
+    uint64_t send_errors;
+  };
+  Stats stats_{};
+
+  void setupLogger() {
+    auto console_sink = std::make_shared<spdlog::sinks::stdout_color_sink_mt>();
+    logger_ = std::make_shared<spdlog::logger>("mcx_traffic_gen", console_sink);
+    logger_->set_level(spdlog::level::from_str(config_.log_level));
+    spdlog::set_default_logger(logger_);
+  }
+
+  void loadConfig(const std::string &config_path) {
+    try {
+      auto yaml = YAML::LoadFile(config_path);
+
+      config_.multicast_group = yaml["connection"]["multicast_group"].as<std::string>();
+      config_.port = yaml["connection"]["port"].as<uint16_t>();
+      config_.interface_ip = yaml["connection"]["interface_ip"].as<std::string>("127.0.0.1");
+      config_.ttl = yaml["connection"]["ttl"].as<int>(0);
+
+      auto feed = yaml["feed"];
+      config_.market_segment_id = feed["market_segment_id"].as<int32_t>(1);
+      config_.partition_id = static_cast<uint8_t>(feed["partition_id"].as<int>(1));
+      config_.securities = std::max(1u, feed["securities"].as<uint32_t>(500));
+      config_.base_security_id = feed["base_security_id"].as<int64_t>(400000);
+      config_.base_price = feed["base_price"].as<int64_t>(5000000);
+      config_.tick_size = feed["tick_size"].as<int64_t>(100);
+
+      auto gen = yaml["generator"];
+      config_.target_rate = gen["target_rate"].as<uint64_t>(1000000);
+      config_.msgs_per_packet = gen["msgs_per_packet"].as<uint32_t>(8);
+      config_.batch_size = std::max(1u, gen["batch_size"].as<uint32_t>(64));
+      config_.duration_sec = gen["duration_sec"].as<uint64_t>(0);
+      config_.heartbeat_interval_ms = gen["heartbeat_interval_ms"].as<uint32_t>(1000);
+      config_.stats_interval_ms = std::max(1u, gen["stats_interval_ms"].as<uint32_t>(1000));
+
+      auto mix = yaml["mix"];
+      config_.mix = {mix["add"].as<uint32_t>(40), mix["modify"].as<uint32_t>(25),
+                     mix["delete"].as<uint32_t>(20), mix["partial_execution"].as<uint32_t>(5),
+                     mix["full_execution"].as<uint32_t>(10)};
+
+      auto faults = yaml["faults"];
+      config_.gap_ppm = faults["gap_ppm"].as<uint32_t>(0);
+      config_.gap_packets = std::max(1u, faults["gap_packets"].as<uint32_t>(1));
+      config_.reorder_ppm = faults["reorder_ppm"].as<uint32_t>(0);
+      config_.duplicate_ppm = faults["duplicate_ppm"].as<uint32_t>(0);
+
+      config_.log_level = yaml["logging"]["log_level"].as<std::string>("info");
+    } catch (const YAML::Exception &e) {
+      throw std::runtime_error("Failed to parse config: " + std::string(e.what()));
+    }
+
+    setupLogger();
+
+    // every message must fit behind the packet header inside one datagram.
+    const auto max_per_packet = static_cast<uint32_t>((kMaxDatagram - sizeof(PacketHeader)) / kMaxMsgSize);
+    if (config_.msgs_per_packet == 0 || config_.msgs_per_packet > max_per_packet) {
+      logger_->warn("msgs_per_packet {} out of range, clamping to {}", config_.msgs_per_packet, max_per_packet);
+      config_.msgs_per_packet = std::clamp(config_.msgs_per_packet, 1u, max_per_packet);
+    }
+
+    for (size_t i = 0; i < config_.mix.size(); ++i) {
+      mix_total_ += config_.mix[i];
+      mix_cumulative_[i] = mix_total_;
+    }
+    if (mix_total_ == 0) {
+      throw std::runtime_error("Message mix weights are all zero");
+    }
+
+    logger_->info("Loaded config - Group: {}, Port: {}, IP: {}, Rate: {} msgs/s, {} msgs/packet, batch {}",
+                  config_.multicast_group, config_.port, config_.interface_ip, config_.target_rate,
+                  config_.msgs_per_packet, config_.batch_size);
+  }
+
+  void openSocket() {
+    sd_ = socket(AF_INET, SOCK_DGRAM, 0);
+    if (sd_ < 0) {
+      throw std::runtime_error("Socket creation failed");
+    }
+
+    in_addr iface{};
+    iface.s_addr = inet_addr(config_.interface_ip.c_str());
+    if (setsockopt(sd_, IPPROTO_IP, IP_MULTICAST_IF, &iface, sizeof(iface)) < 0) {
+      close(sd_);
+      throw std::runtime_error("Failed to set IP_MULTICAST_IF");
+    }
+
+    unsigned char ttl = static_cast<unsigned char>(config_.ttl);
+    unsigned char loop = 1;
+    setsockopt(sd_, IPPROTO_IP, IP_MULTICAST_TTL, &ttl, sizeof(ttl));
+    setsockopt(sd_, IPPROTO_IP, IP_MULTICAST_LOOP, &loop, sizeof(loop));
+
+    int sndbuf = 8 * 1024 * 1024;
+    setsockopt(sd_, SOL_SOCKET, SO_SNDBUF, &sndbuf, sizeof(sndbuf));
+
+    dest_.sin_family = AF_INET;
+    dest_.sin_port = htons(config_.port);
+    dest_.sin_addr.s_addr = inet_addr(config_.multicast_group.c_str());
+  }
+
+  Kind pickKind() {
+    if (live_orders_.empty()) return Kind::Add;
+    if (live_orders_.size() >= kMaxLiveOrders) return Kind::Delete;
+
+    const uint32_t roll = rng_.below(mix_total_);
+    size_t i = 0;
+    while (roll >= mix_cumulative_[i]) ++i;
+    return static_cast<Kind>(i);
+  }
+
+  void fillHeader(MessageHeader &header, size_t body_len, TemplateId template_id) {
+    header.body_len = static_cast<uint16_t>(body_len);
+    header.template_id = static_cast<uint16_t>(template_id);
+    header.msg_seq_num = ++msg_seq_;
+  }
+
+  size_t writeAdd(char *out) {
+    LiveOrder order{};
+    order.security_id = config_.base_security_id + rng_.below(config_.securities);
+    order.side = static_cast<uint8_t>(rng_.below(2) ? Side::Buy : Side::Sell);
+    // rest a few ticks away from the mid so both sides of the book fill up.
+    const PriceType offset = config_.tick_size * (1 + rng_.below(10));
+    order.price = config_.base_price + (order.side == static_cast<uint8_t>(Side::Buy) ? -offset : offset);
+    order.quantity = 1 + rng_.below(100);
+    order.priority_ts = now_ns_ + msg_seq_;
+    live_orders_.push_back(order);
+
+    auto *msg = reinterpret_cast<OrderAdd *>(out);
+    std::memset(msg, 0, sizeof(OrderAdd));
+    fillHeader(msg->header, sizeof(OrderAdd), TemplateId::ORDER_ADD);
+    msg->exchange_ts = now_ns_;
+    msg->security_id = order.security_id;
+    msg->reserve2 = order.priority_ts;
+    msg->quantity = order.quantity;
+    msg->side = order.side;
+    msg->order_type = 2; // limit
+    msg->price = order.price;
+    return sizeof(OrderAdd);
+  }
+
+  size_t writeModify(char *out) {
+    auto &order = live_orders_[rng_.below(static_cast<uint32_t>(live_orders_.size()))];
+
+    auto *msg = reinterpret_cast<OrderModify *>(out);
+    std::memset(msg, 0, sizeof(OrderModify));
+    fillHeader(msg->header, sizeof(OrderModify), TemplateId::ORDER_MODIFY);
+    msg->exchange_ts = now_ns_;
+    msg->reserve2 = order.priority_ts;
+    msg->prev_price = order.price;
+    msg->prev_quantity = order.quantity;
+    msg->security_id = order.security_id;
+
+    order.price += config_.tick_size * (static_cast<PriceType>(rng_.below(3)) - 1);
+    order.quantity = 1 + rng_.below(100);
+    order.priority_ts = now_ns_ + msg_seq_;
+
+    msg->reserve4 = order.priority_ts;
+    msg->display_qty = order.quantity;
+    msg->side = order.side;
+    msg->order_type = 2;
+    msg->price = order.price;
+    return sizeof(OrderModify);
+  }
+
+  size_t writeDelete(char *out) {
+    const auto idx = rng_.below(static_cast<uint32_t>(live_orders_.size()));
+    const LiveOrder order = live_orders_[idx];
+    live_orders_[idx] = live_orders_.back();
+    live_orders_.pop_back();
+
+    auto *msg = reinterpret_cast<OrderDelete *>(out);
+    std::memset(msg, 0, sizeof(OrderDelete));
+    fillHeader(msg->header, sizeof(OrderDelete), TemplateId::ORDER_DELETE);
+    msg->exchange_ts = now_ns_;
+    msg->transaction_ts = now_ns_;
+    msg->security_id = order.security_id;
+    msg->reserve2 = order.priority_ts;
+    msg->display_qty = order.quantity;
+    msg->side = order.side;
+    msg->order_type = 2;
+    msg->price = order.price;
+    return sizeof(OrderDelete);
+  }
+
+  size_t writeExecution(char *out, bool full) {
+    const auto idx = rng_.below(static_cast<uint32_t>(live_orders_.size()));
+    LiveOrder &order = live_orders_[idx];
+    if (order.quantity <= 1) full = true;
+
+    const QuantityType last_qty = full ? order.quantity : 1 + rng_.below(static_cast<uint32_t>(order.quantity - 1));
+
+    auto *msg = reinterpret_cast<OrderExecution *>(out);
+    std::memset(msg, 0, sizeof(OrderExecution));
+    fillHeader(msg->header, sizeof(OrderExecution),
+               full ? TemplateId::FULL_ORDER_EXECUTION : TemplateId::PARTIAL_ORDER_EXECUTION);
+    msg->side = order.side;
+    msg->order_type = 2;
+    msg->price = order.price;
+    msg->reserve2 = order.priority_ts;
+    msg->security_id = order.security_id;
+    msg->trade_match_id = ++trade_match_id_;
+    msg->last_qty = last_qty;
+    msg->last_px = order.price;
+
+    if (full) {
+      live_orders_[idx] = live_orders_.back();
+      live_orders_.pop_back();
+    } else {
+      order.quantity -= last_qty;
+    }
+    return sizeof(OrderExecution);
+  }
+
+  size_t writeMessage(char *out) {
+    switch (pickKind()) {
+    case Kind::Add: return writeAdd(out);
+    case Kind::Modify: return writeModify(out);
+    case Kind::Delete: return writeDelete(out);
+    case Kind::PartialExecution: return writeExecution(out, false);
+    case Kind::FullExecution: return writeExecution(out, true);
+    }
+    return 0;
+  }
+
+  // builds PacketHeader + msgs_per_packet messages, returns the datagram length.
+  size_t buildPacket(char *out) {
+    auto *packet = reinterpret_cast<PacketHeader *>(out);
+    std::memset(packet, 0, sizeof(PacketHeader));
+    packet->header.body_len = sizeof(PacketHeader);
+    packet->header.template_id = static_cast<uint16_t>(TemplateId::PACKET_HEADER);
+    packet->header.msg_seq_num = ++packet_seq_;
+    packet->appl_seq_num = packet_seq_;
+    packet->market_segment_id = config_.market_segment_id;
+    packet->partition_id = config_.partition_id;
+    packet->completion_indicator = 1;
+    packet->transaction_ts = now_ns_;
+
+    size_t len = sizeof(PacketHeader);
+    for (uint32_t i = 0; i < config_.msgs_per_packet; ++i) {
+      len += writeMessage(out + len);
+    }
+    return len;
+  }
+
+  void sendHeartbeat() {
+    HeartBeat hb{};
+    hb.header.body_len = sizeof(HeartBeat);
+    hb.header.template_id = static_cast<uint16_t>(TemplateId::HEART_BEAT);
+    hb.header.msg_seq_num = packet_seq_;
+    hb.last_msg_seq_num_processed = packet_seq_;
+    if (sendto(sd_, &hb, sizeof(hb), 0, reinterpret_cast<sockaddr *>(&dest_), sizeof(dest_)) < 0) {
+      ++stats_.send_errors;
+    }
+  }
+
+  // generates one batch of datagrams, applying gaps/reorders/duplicates, and ships it with sendmmsg.
+  // returns the number of messages generated (dropped ones included, they consumed sequence numbers).
+  uint64_t sendBatch() {
+    now_ns_ = static_cast<UTCTimestamp>(duration_cast<nanoseconds>(system_clock::now().time_since_epoch()).count());
+
+    if (force_gap) {
+      force_gap = 0;
+      pending_gap_ += config_.gap_packets;
+      ++stats_.gaps;
+    }
+    bool reorder_now = force_reorder;
+    bool duplicate_now = force_reorder;
+    force_reorder = 0;
+
+    uint64_t generated = 0;
+    size_t count = 0;
+    for (uint32_t slot = 0; slot < config_.batch_size; ++slot) {
+      const size_t len = buildPacket(buffers_[slot].data());
+      generated += config_.msgs_per_packet;
+
+      if (pending_gap_ == 0 && rng_.chance(config_.gap_ppm)) {
+        pending_gap_ = config_.gap_packets;
+        ++stats_.gaps;
+      }
+      if (pending_gap_ > 0) {
+        --pending_gap_;
+        ++stats_.dropped_packets;
+        continue;
+      }
+
+      iovecs_[slot].iov_base = buffers_[slot].data();
+      iovecs_[slot].iov_len = len;
+      msgs_[count].msg_hdr.msg_iov = &iovecs_[slot];
+      ++count;
+
+      if (count > 1 && (reorder_now || rng_.chance(config_.reorder_ppm))) {
+        std::swap(msgs_[count - 1].msg_hdr.msg_iov, msgs_[count - 2].msg_hdr.msg_iov);
+        reorder_now = false;
+        ++stats_.reorders;
+      }
+      if (duplicate_now || rng_.chance(config_.duplicate_ppm)) {
+        msgs_[count].msg_hdr.msg_iov = msgs_[count - 1].msg_hdr.msg_iov;
+        ++count;
+        duplicate_now = false;
+        ++stats_.duplicates;
+      }
+    }
+
+    size_t offset = 0;
+    while (offset < count) {
+      int sent = sendmmsg(sd_, msgs_.data() + offset, static_cast<unsigned int>(count - offset), 0);
+      if (sent < 0) {
+        if (errno == EINTR) continue;
+        ++stats_.send_errors;
+        logger_->error("sendmmsg failed: {}", strerror(errno));
+        break;
+      }
+      stats_.msgs += static_cast<uint64_t>(sent) * config_.msgs_per_packet;
+      stats_.packets += sent;
+      offset += sent;
+    }
+    return generated;
+  }
+
+  void logStats(const Stats &prev, double elapsed_sec) {
+    logger_->info("rate: {:.0f} msgs/s {:.0f} pkts/s | total msgs={} pkts={} gaps={} dropped={} reorders={} dups={} errors={}",
+                  (stats_.msgs - prev.msgs) / elapsed_sec, (stats_.packets - prev.packets) / elapsed_sec,
+                  stats_.msgs, stats_.packets, stats_.gaps, stats_.dropped_packets, stats_.reorders,
+                  stats_.duplicates, stats_.send_errors);
+  }
+
+public:
+  MCXTrafficGenerator(const std::string &config_path) {
+    loadConfig(config_path);
+    live_orders_.reserve(kMaxLiveOrders);
+
+    // a duplicate adds one extra mmsghdr per datagram in the worst case.
+    buffers_.resize(config_.batch_size);
+    iovecs_.resize(config_.batch_size);
+    msgs_.resize(2 * config_.batch_size);
+    for (auto &m : msgs_) {
+      std::memset(&m, 0, sizeof(m));
+      m.msg_hdr.msg_name = &dest_;
+      m.msg_hdr.msg_namelen = sizeof(dest_);
+      m.msg_hdr.msg_iovlen = 1;
+    }
+  }
+
+  ~MCXTrafficGenerator() {
+    if (sd_ >= 0) close(sd_);
+  }
+
+  void start() {
+    openSocket();
+    logger_->info("MCX traffic generator started, publishing to {}:{} via {}", config_.multicast_group,
+                  config_.port, config_.interface_ip);
+
+    const auto start = steady_clock::now();
+    const auto heartbeat_interval = milliseconds(config_.heartbeat_interval_ms);
+    const auto stats_interval = milliseconds(config_.stats_interval_ms);
+    auto next_heartbeat = start + heartbeat_interval;
+    auto next_stats = start + stats_interval;
+    auto last_stats_time = start;
+    Stats last_stats = stats_;
+    uint64_t generated = 0;
+
+    while (running) {
+      auto now = steady_clock::now();
+
+      // pace against the absolute schedule so short stalls are caught up instead of accumulated.
+      if (config_.target_rate) {
+        const auto due = start + duration_cast<steady_clock::duration>(
+                                     duration<double>(static_cast<double>(generated) / config_.target_rate));
+        if (due > now) {
+          if (due - now > microseconds(200)) {
+            std::this_thread::sleep_for(due - now - microseconds(100));
+          }
+          while (running && steady_clock::now() < due) {
+          }
+          now = steady_clock::now();
+        }
+      }
+
+      generated += sendBatch();
+
+      if (config_.heartbeat_interval_ms && now >= next_heartbeat) {
+        sendHeartbeat();
+        next_heartbeat += heartbeat_interval;
+      }
+      if (now >= next_stats) {
+        logStats(last_stats, duration<double>(now - last_stats_time).count());
+        last_stats = stats_;
+        last_stats_time = now;
+        next_stats = now + stats_interval;
+      }
+      if (config_.duration_sec && now - start >= seconds(config_.duration_sec)) {
+        break;
+      }
+    }
+
+    const double elapsed = duration<double>(steady_clock::now() - start).count();
+    logger_->info("Shutting down MCX traffic generator after {:.2f}s, average {:.0f} msgs/s", elapsed,
+                  stats_.msgs / elapsed);
+    logStats(Stats{}, elapsed);
+  }
+};
+
+int main(int argc, char *argv[]) {
+  if (argc != 2) {
+    std::cerr << "Usage: " << argv[0] << " <traffic_gen_config.yaml>" << std::endl;
+    return 1;
+  }
+
+  // Setup signal handling
+  signal(SIGINT, signalHandler);
+  signal(SIGTERM, signalHandler);
+  signal(SIGUSR1, faultSignalHandler);
+  signal(SIGUSR2, faultSignalHandler);
+
+  try {
+    MCXTrafficGenerator generator(argv[1]);
+    generator.start();
+  } catch (const std::exception &e) {
+    std::cerr << "Error: " << e.what() << std::endl;
+    return 1;
+  }
+
+  return 0;
+}
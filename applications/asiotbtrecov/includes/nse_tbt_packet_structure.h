@@ -20,6 +20,8 @@ struct RecoveryConfig {
   uint32_t timeout_ms;
   uint32_t max_retries;
   uint32_t buffer_size;
+  uint32_t retry_backoff_ms;     // first reconnect delay, doubled per retry
+  uint32_t retry_backoff_max_ms; // cap on the reconnect delay
 };
 
 // Recovery request parameters
@@ -96,6 +98,12 @@ enum class MessageType : uint8_t {
     Recovery = 'Y'
 };
 
+// msg_len covers the whole message, StreamHeader included, and the message
+// type byte directly follows the header.
+inline MessageType messageType(const uint8_t* msg) {
+    return static_cast<MessageType>(msg[sizeof(StreamHeader)]);
+}
+
 // Map segment string to enum
 static const std::unordered_map<std::string, elaeo::recovery::Segment>
     segment_map = {{"CM", elaeo::recovery::Segment::CM},
@@ -2,8 +2,15 @@
 #pragma once
 #include "nse_tbt_packet_structure.h"
 #include <asio.hpp>
+#include <asio/awaitable.hpp>
 #include <asio/steady_timer.hpp>
+#include <asio/strand.hpp>
+#include <cstddef>
+#include <deque>
+#include <functional>
+#include <future>
 #include <memory>
+#include <span>
 #include <vector>
 #include <string>
 #include <spdlog/logger.h>
@@ -11,44 +18,63 @@
 namespace elaeo::recovery {
 
 // recovery client singleton.
+//
+// Keeps one connection per segment open and serves the requests of that segment
+// one after the other from a queue. Every session is a coroutine running on the
+// client's strand, so requestRecovery() may be called from any thread.
 class TbtRecoveryClient : public std::enable_shared_from_this<TbtRecoveryClient> {
 public:
   //single static instance.
-  static std::shared_ptr<TbtRecoveryClient> create(asio::io_context &ioc, const std::string &config_file) 
+  static std::shared_ptr<TbtRecoveryClient> create(asio::io_context &ioc, const std::string &config_file)
   {
     return std::shared_ptr<TbtRecoveryClient>( new TbtRecoveryClient(ioc, config_file));
   }
 
-  using RecoveryCallback = std::function<void(uint32_t seq_num, const std::vector<uint8_t> &data)>;
+  ~TbtRecoveryClient();
+
+  // One complete message, StreamHeader included, valid only during the callback
+  using MessageView = std::span<const std::byte>;
+  using RecoveryCallback = std::function<void(const StreamHeader &header, MessageView message)>;
 
   bool initialize();
-  bool requestRecovery(const RecoveryRequest &request);
+
+  // Queue a recovery request on its segment's session. The future becomes true once
+  // end_seq has been delivered, false if the request failed or timed out.
+  std::future<bool> requestRecovery(const RecoveryRequest &request);
+
+  // Callback is invoked on the io_context thread, set it before queueing requests
   void setCallback(RecoveryCallback callback) { m_callback = callback; }
 
+  // Close every session, requests still queued complete with false
+  void stop();
+
 private:
+  struct Session;
+
+  struct PendingRequest {
+    RecoveryRequest request;
+    std::promise<bool> result;
+  };
+
   // private constructor.
   explicit TbtRecoveryClient(asio::io_context &ioc, const std::string &config_file);
 
-  void doConnect(const std::string &host, uint16_t port);
-  void startRead();
-  void readHeader();
-  void readPayload(const StreamHeader &header);
-  void handleMessage(const StreamHeader &header,
-                     const std::vector<uint8_t> &payload);
+  Session &session(Segment segment, const RecoveryConfig &config);
+  asio::awaitable<void> runSession(Session &session);
+  asio::awaitable<bool> connect(Session &session);
+  asio::awaitable<bool> serve(Session &session, const RecoveryRequest &request);
+  bool handleMessage(Session &session, const StreamHeader &header, const uint8_t *msg, size_t length,
+                     const RecoveryRequest &request, bool &done);
 
   asio::io_context &m_ioc;
-  asio::ip::tcp::socket m_socket;
-  asio::steady_timer m_timer;
+  asio::strand<asio::io_context::executor_type> m_strand;
 
   std::string m_config_file;
   std::unordered_map<Segment, RecoveryConfig> m_configs;
+  std::unordered_map<Segment, std::unique_ptr<Session>> m_sessions;
   RecoveryCallback m_callback;
-  uint32_t m_end_seq;
   std::shared_ptr<spdlog::logger> m_logger;
-  std::vector<uint8_t> m_read_buffer;
-  std::vector<uint8_t> m_header_buffer;
-  std::vector<uint8_t> m_payload_buffer;
-  elaeo::recovery::RecoveryRequestPacket m_current_req_packet;
+  bool m_stopped = false;
 };
 
 } // namespace elaeo::recovery
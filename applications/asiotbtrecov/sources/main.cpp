@@ -1,17 +1,22 @@
 #include <asio.hpp>
 #include "tbt_recovery_client.h"
+#include <future>
 #include <iostream>
+#include <spdlog/spdlog.h>
 #include <string>
+#include <thread>
 #include <unordered_map>
 #include <stdexcept>
+#include <vector>
 
 void printUsage(const char* program) {
-  std::cout << "Usage help: " << program << " <config_file> <segment> <stream_id> <start_seq> <end_seq>\n";
+  std::cout << "Usage help: " << program << " <config_file> <segment> <stream_id> <start_seq> <end_seq> [<stream_id> <start_seq> <end_seq> ...]\n";
   std::cout << "Segments: CM, FO, CD, CO\n";
+  std::cout << "Every extra range is queued on the same segment session\n";
 }
 
 int main(int argc, char* argv[]) {
-  if (argc != 6) {
+  if (argc < 6 || (argc - 3) % 3 != 0) {
     printUsage(argv[0]);
     return 1;
   }
@@ -21,11 +26,6 @@ int main(int argc, char* argv[]) {
     // Parse command line arguments
     std::string config_file = argv[1];
     std::string segment_str = argv[2];
-    uint16_t stream_id = std::stoi(argv[3]);
-    uint32_t start_seq = std::stoul(argv[4]);
-    uint32_t end_seq = std::stoul(argv[5]);
-
-
 
     auto segment_it = elaeo::recovery::segment_map.find(segment_str.c_str());
     // check if the segment is valid.
@@ -52,33 +52,38 @@ int main(int argc, char* argv[]) {
     // Run in separate thread to prevent blocking
     std::thread ioc_thread([&ioc]() { ioc.run(); });
     
-    // Set Callback to print recovered packets. @TODO find where is this callback called?
-    client->setCallback([](uint32_t seq_num, const std::vector<uint8_t>& data) {
-      std::cout << "Recovered packet: seq=" << seq_num << " size=" << data.size() << std::endl;
+    // Set Callback to print recovered packets, it runs on the io_context thread
+    client->setCallback([](const elaeo::recovery::StreamHeader& header,
+                           elaeo::recovery::TbtRecoveryClient::MessageView message) {
+      std::cout << "Recovered packet: seq=" << header.seq_no << " size=" << message.size() << std::endl;
     });
 
-    // Request Recovery
-    elaeo::recovery::RecoveryRequest request{
-      segment_it->second,
-      stream_id,
-      start_seq,
-      end_seq
-    };
-
-    if (!client->requestRecovery(request)) {
-      std::cerr << "Recovery request failed" << std::endl;
-      return 1;
+    // Queue every requested range, the session serves them back to back on one connection
+    std::vector<std::future<bool>> results;
+    for (int arg = 3; arg + 2 < argc; arg += 3) {
+      elaeo::recovery::RecoveryRequest request{
+        segment_it->second,
+        static_cast<uint16_t>(std::stoi(argv[arg])),
+        static_cast<uint32_t>(std::stoul(argv[arg + 1])),
+        static_cast<uint32_t>(std::stoul(argv[arg + 2]))
+      };
+      results.push_back(client->requestRecovery(request));
     }
 
-    // Stop io_context once recovery is complete
-    // asio::post(ioc, [&ioc]() { ioc.stop(); });
+    int failed = 0;
+    for (auto& result : results) {
+      failed += result.get() ? 0 : 1;
+    }
+    if (failed) {
+      std::cerr << failed << " of " << results.size() << " recovery requests failed" << std::endl;
+    }
 
-    // async run for the recovery
-    // ioc.run();
-    // spdlog::shutdown();
+    // everything has completed, let the io_context run out
+    client->stop();
     work.reset();
     ioc_thread.join();
-    return 0;
+    spdlog::shutdown();
+    return failed ? 1 : 0;
   }
   catch (const std::exception& e) {
     std::cerr << "Error: " << e.what() << std::endl;
@@ -1,5 +1,11 @@
 #include "tbt_recovery_client.h"
 #include "nse_tbt_packet_structure.h"
+#include <asio/co_spawn.hpp>
+#include <asio/detached.hpp>
+#include <asio/redirect_error.hpp>
+#include <asio/use_awaitable.hpp>
+#include <algorithm>
+#include <cstring>
 #include <fmt/format.h>
 #include <iostream>
 #include <spdlog/sinks/daily_file_sink.h>
@@ -9,87 +15,29 @@
 
 namespace elaeo::recovery {
 
-TbtRecoveryClient::TbtRecoveryClient(asio::io_context &ioc, const std::string &config_file) : m_ioc(ioc), m_socket(ioc), m_timer(ioc), m_config_file(config_file) {}
-
-void TbtRecoveryClient::doConnect(const std::string &host, uint16_t port) {
-  m_logger->debug("Attempting connection to {}:{}...", host, port);
-  asio::ip::tcp::resolver resolver(m_ioc);
-  auto endpoints = resolver.resolve(host, std::to_string(port));
-
-  auto self = shared_from_this(); //capturing it via a shared ptr in the callback so that the client doesn't get destroyed when the callbacks are working. 
-
-  asio::async_connect(
-    m_socket, endpoints,
-    [this, self](const asio::error_code &ec, const asio::ip::tcp::endpoint &) {
-      m_logger->info("Successfully connected to TBT Recovery Server.");
-      m_logger->debug("Sending recovery request packet...");
-      if (!ec) {
-        asio::async_write(m_socket, asio::buffer(&m_current_req_packet, sizeof(RecoveryRequestPacket)),
-                          [this](asio::error_code ec, size_t /*bytes*/) {
-                          if (!ec){
-                          m_logger->debug("Recovery request sent successfully. Starting data read...");
-                          startRead();
-                          }
-                          else {
-                          m_logger->error("Write failed: {}", ec.message());
-                          m_socket.close();
-                          }
-                          });
-      } else {
-        m_logger->error("Connect failed: {}", ec.message());
-        m_socket.close();
-      }
-    });
-}
-
-void TbtRecoveryClient::startRead() { 
-  m_logger->debug("Waiting for the recovery response packet...");
-  readHeader(); }
+// Connection, request queue and receive buffer of one segment
+struct TbtRecoveryClient::Session {
+  Session(asio::strand<asio::io_context::executor_type> &strand, Segment seg, const RecoveryConfig &cfg)
+      : segment(seg), config(cfg), socket(strand), wakeup(strand), deadline(strand), buffer(cfg.buffer_size) {}
 
-void TbtRecoveryClient::readHeader() {
-  auto self = shared_from_this();
-  auto header_buffer = std::make_shared<StreamHeader>();
+  Segment segment;
+  RecoveryConfig config;
+  asio::ip::tcp::socket socket;
+  asio::steady_timer wakeup;   // parked while the queue is empty, cancelled to wake the session
+  asio::steady_timer deadline; // one per request, cancels the socket when it expires
+  std::deque<PendingRequest> queue;
+  uint64_t attempt = 0; // tags deadline expiries so a late one can't hit the next request
+  bool timed_out = false;
 
-  m_timer.expires_after(std::chrono::seconds(5)); // 5-second timeout
-  m_timer.async_wait([this, self](const asio::error_code &ec) {
-    if (!ec) {
-      m_logger->error("Timeout waiting for TBT header");
-      m_socket.close();
-    }
-  });
+  // messages are framed in place, [head, tail) holds the unconsumed bytes
+  std::vector<uint8_t> buffer;
+  size_t head = 0;
+  size_t tail = 0;
+};
 
-  asio::async_read(m_socket,
-                   asio::buffer(header_buffer.get(), sizeof(StreamHeader)),
-                   [this, header_buffer](const asio::error_code &ec, std::size_t bytes_transferred) {
-                   if (!ec && bytes_transferred == sizeof(StreamHeader)) {
-                   m_logger->debug("Received TBT Header: Seq={}, Stream ID={}, Msg Len={}", header_buffer->seq_no, header_buffer->stream_id, header_buffer->msg_len);
-                   m_timer.cancel();
-                   readPayload(*header_buffer);
-                   } else {
-                   m_logger->error("Header read failed: {}", ec.message());
-                   }
-                   });
-}
+TbtRecoveryClient::TbtRecoveryClient(asio::io_context &ioc, const std::string &config_file) : m_ioc(ioc), m_strand(asio::make_strand(ioc)), m_config_file(config_file) {}
 
-void TbtRecoveryClient::readPayload(const StreamHeader &header) {
-  auto self = shared_from_this();
-  m_logger->debug("Reading payload for sequence {} (size: {})", header.seq_no, header.msg_len);
-  m_read_buffer.resize(header.msg_len);
-
-  asio::async_read(m_socket, asio::buffer(m_read_buffer),
-                   [this, self, header](const asio::error_code &ec, std::size_t bytes_transferred) {
-                   if (!ec && bytes_transferred == header.msg_len) {
-                   handleMessage(header, m_read_buffer);
-
-                   // Continue reading if not reached end sequence
-                   if (header.seq_no < m_end_seq) {
-                   readHeader();
-                   }
-                   } else {
-                   m_logger->error("Payload read failed: {}", ec.message());
-                   }
-                   });
-}
+TbtRecoveryClient::~TbtRecoveryClient() = default;
 
 bool TbtRecoveryClient::initialize() {
   try {
@@ -128,6 +76,8 @@ bool TbtRecoveryClient::initialize() {
       cfg.timeout_ms = config["recovery"]["timeout_ms"].as<uint32_t>();
       cfg.max_retries = config["recovery"]["max_retries"].as<uint32_t>();
       cfg.buffer_size = config["recovery"]["buffer_size"].as<uint32_t>();
+      cfg.retry_backoff_ms = config["recovery"]["retry_backoff_ms"].as<uint32_t>(100);
+      cfg.retry_backoff_max_ms = config["recovery"]["retry_backoff_max_ms"].as<uint32_t>(5000);
 
       // ... populate cfg from YAML ...
       // use of operator[] on a const unordered_map is not allowed because: operator[] can modify the map by inserting elements if the key doesn't exist. With a const map, only const operations are allowed
@@ -154,46 +104,224 @@ bool TbtRecoveryClient::initialize() {
     return false;
   }
 }
-bool TbtRecoveryClient::requestRecovery(const RecoveryRequest &request) {
+std::future<bool> TbtRecoveryClient::requestRecovery(const RecoveryRequest &request) {
+  std::promise<bool> result;
+  auto future = result.get_future();
+
   auto it = m_configs.find(request.segment);
   if (it == m_configs.end()) {
     m_logger->error("Invalid segment requested");
-    return false;
+    result.set_value(false);
+    return future;
+  }
+
+  m_logger->debug("Queueing Recovery request. segment:{}, stream:{}, start_seq:{}, end_seq:{}", static_cast<int>(request.segment), request.stream_id, request.start_seq, request.end_seq);
+
+  // hop onto the strand, the sessions are only ever touched from there
+  asio::post(m_strand, [this, self = shared_from_this(), request, config = it->second, result = std::move(result)]() mutable {
+    if (m_stopped) {
+      result.set_value(false);
+      return;
+    }
+    auto &s = session(request.segment, config);
+    s.queue.push_back(PendingRequest{request, std::move(result)});
+    s.wakeup.cancel();
+  });
+  return future;
+}
+
+void TbtRecoveryClient::stop() {
+  asio::post(m_strand, [this, self = shared_from_this()]() {
+    m_stopped = true;
+    for (auto &[segment, s] : m_sessions) {
+      asio::error_code ec;
+      s->socket.close(ec);
+      s->wakeup.cancel();
+      s->deadline.cancel();
+    }
+  });
+}
+
+TbtRecoveryClient::Session &TbtRecoveryClient::session(Segment segment, const RecoveryConfig &config) {
+  auto it = m_sessions.find(segment);
+  if (it != m_sessions.end()) {
+    return *it->second;
   }
 
-  const auto &config = it->second;
-  m_end_seq = request.end_seq;
+  auto &s = *m_sessions.emplace(segment, std::make_unique<Session>(m_strand, segment, config)).first->second;
+  asio::co_spawn(m_strand, [self = shared_from_this(), &s]() { return self->runSession(s); }, asio::detached);
+  return s;
+}
 
-  m_logger->info("Connecting to recovery server {}:{} for segment {}", config.server_ip, config.server_port, static_cast<int>(request.segment));
-  m_logger->debug("Building Recovery request. segment:{}, stream:{}, start_seq:{}, end_seq:{}", static_cast<int>(request.segment), request.stream_id, request.start_seq, request.end_seq);
+asio::awaitable<void> TbtRecoveryClient::runSession(Session &s) {
+  while (!m_stopped) {
+    if (s.queue.empty()) {
+      asio::error_code ec;
+      s.wakeup.expires_at(asio::steady_timer::time_point::max());
+      co_await s.wakeup.async_wait(asio::redirect_error(asio::use_awaitable, ec));
+      continue;
+    }
 
-  // Prepare and send request
-  m_current_req_packet = { 'R', request.stream_id, request.start_seq, request.end_seq };
-  m_logger->debug("recovery request=> msg_type:{}, stream_id:{}, start_seq:{}, end_seq:{}", m_current_req_packet.msg_type, m_current_req_packet.stream_id, m_current_req_packet.start_seq, m_current_req_packet.end_seq);
-  // Connect and send request asynchronously
-  doConnect(config.server_ip, config.server_port);
+    auto pending = std::move(s.queue.front());
+    s.queue.pop_front();
+    const bool ok = co_await serve(s, pending.request);
+    pending.result.set_value(ok);
+  }
 
-  return true;
+  for (auto &pending : s.queue) {
+    pending.result.set_value(false);
+  }
+  s.queue.clear();
+}
+
+asio::awaitable<bool> TbtRecoveryClient::connect(Session &s) {
+  m_logger->info("Connecting to recovery server {}:{} for segment {}", s.config.server_ip, s.config.server_port, static_cast<int>(s.segment));
+
+  asio::error_code ec;
+  asio::ip::tcp::resolver resolver(m_strand);
+  auto endpoints = co_await resolver.async_resolve(s.config.server_ip, std::to_string(s.config.server_port),
+                                                   asio::redirect_error(asio::use_awaitable, ec));
+  if (!ec) {
+    co_await asio::async_connect(s.socket, endpoints, asio::redirect_error(asio::use_awaitable, ec));
+  }
+  if (ec) {
+    m_logger->error("Connect failed: {}", ec.message());
+    s.socket.close(ec);
+    co_return false;
+  }
+
+  s.socket.set_option(asio::ip::tcp::no_delay(true), ec);
+  m_logger->info("Successfully connected to TBT Recovery Server.");
+  co_return true;
 }
 
-void TbtRecoveryClient::handleMessage(const StreamHeader& header, const std::vector<uint8_t>& payload) {
-    if (payload.empty()) return;
+asio::awaitable<bool> TbtRecoveryClient::serve(Session &s, const RecoveryRequest &request) {
+  const RecoveryRequestPacket packet{'R', request.stream_id, request.start_seq, request.end_seq};
+  m_logger->debug("recovery request=> msg_type:{}, stream_id:{}, start_seq:{}, end_seq:{}", packet.msg_type, packet.stream_id, packet.start_seq, packet.end_seq);
+
+  // The server may have dropped an idle connection; that only shows up once we
+  // write or read on it, so a request that got no bytes back is retried on a
+  // fresh connection.
+  const uint32_t attempts = s.config.max_retries + 1;
+  for (uint32_t attempt = 0; attempt < attempts && !m_stopped; ++attempt) {
+    asio::error_code ec;
+    if (!s.socket.is_open() && !co_await connect(s)) {
+      // back off exponentially between reconnects, a restarting server isn't hammered
+      const uint64_t delay_ms = std::min<uint64_t>(static_cast<uint64_t>(s.config.retry_backoff_ms) << std::min(attempt, 16u),
+                                                   s.config.retry_backoff_max_ms);
+      asio::steady_timer backoff(m_strand, std::chrono::milliseconds(delay_ms));
+      co_await backoff.async_wait(asio::redirect_error(asio::use_awaitable, ec));
+      continue;
+    }
+
+    co_await asio::async_write(s.socket, asio::buffer(&packet, sizeof(packet)), asio::redirect_error(asio::use_awaitable, ec));
+    if (ec) {
+      m_logger->warn("Write failed: {}, reconnecting", ec.message());
+      s.socket.close(ec);
+      continue;
+    }
 
-    uint8_t msg_type = payload[0];
+    // a single deadline covers the whole request
+    s.timed_out = false;
+    s.deadline.expires_after(std::chrono::milliseconds(s.config.timeout_ms));
+    s.deadline.async_wait([&s, id = ++s.attempt](const asio::error_code &ec) {
+      if (!ec && id == s.attempt) {
+        s.timed_out = true;
+        s.socket.cancel();
+      }
+    });
 
-    switch (msg_type) {
-        case static_cast<uint8_t>(MessageType::NewOrder): {
-            const OrderMessage* order = reinterpret_cast<const OrderMessage*>(payload.data());
-            m_logger->info("NewOrder: Seq={}, OrderId={}", header.seq_no, order->order_id);
+    s.head = 0;
+    s.tail = 0;
+    size_t received = 0;
+    bool done = false;
+    bool failed = false;
 
-            // Call callback with sequence number and raw packet. check to see if the callback is indeed set.
-            if (m_callback) {
-                m_callback(header.seq_no, payload);
-            }
-            break;
+    while (!done && !failed) {
+      // move a trailing partial message to the front once the tail is full
+      if (s.tail == s.buffer.size()) {
+        std::memmove(s.buffer.data(), s.buffer.data() + s.head, s.tail - s.head);
+        s.tail -= s.head;
+        s.head = 0;
+      }
+
+      // one batched read, as many messages as the socket has ready
+      const size_t bytes = co_await s.socket.async_read_some(asio::buffer(s.buffer.data() + s.tail, s.buffer.size() - s.tail),
+                                                             asio::redirect_error(asio::use_awaitable, ec));
+      if (ec) {
+        failed = true;
+        break;
+      }
+      s.tail += bytes;
+      received += bytes;
+
+      while (!done && !failed && s.tail - s.head >= sizeof(StreamHeader)) {
+        const uint8_t *msg = s.buffer.data() + s.head;
+        const auto *header = reinterpret_cast<const StreamHeader *>(msg);
+        if (header->msg_len <= sizeof(StreamHeader) || header->msg_len > s.buffer.size()) {
+          m_logger->error("Invalid TBT message length {} for sequence {}", header->msg_len, header->seq_no);
+          failed = true;
+          break;
         }
-        default:
-            m_logger->warn("Unknown Message Type: {}", msg_type);
+        if (s.tail - s.head < header->msg_len) {
+          break;
+        }
+        s.head += header->msg_len;
+        failed = !handleMessage(s, *header, msg, header->msg_len, request, done);
+      }
+    }
+    s.deadline.cancel();
+    ++s.attempt;
+
+    if (done) {
+      co_return true;
+    }
+
+    // the stream position is unknown now, start the next request on a new connection
+    s.socket.close(ec);
+    if (s.timed_out) {
+      m_logger->error("Recovery request stream:{} [{}, {}] timed out after {}ms", request.stream_id, request.start_seq, request.end_seq, s.config.timeout_ms);
+      co_return false;
+    }
+    if (received > 0 || m_stopped) {
+      m_logger->error("Recovery request stream:{} [{}, {}] failed after {} bytes", request.stream_id, request.start_seq, request.end_seq, received);
+      co_return false;
     }
+    m_logger->warn("Connection closed before any response, reconnecting");
+  }
+  co_return false;
+}
+
+bool TbtRecoveryClient::handleMessage(Session &s, const StreamHeader &header, const uint8_t *msg, size_t length,
+                                      const RecoveryRequest &request, bool &done) {
+  switch (messageType(msg)) {
+    case MessageType::Recovery: {
+      if (length < sizeof(RecoveryResponse)) {
+        m_logger->error("Truncated recovery response ({} bytes)", length);
+        return false;
+      }
+      const auto *response = reinterpret_cast<const RecoveryResponse *>(msg);
+      if (response->req_status != 0) {
+        m_logger->error("Recovery request failed with status {}", response->req_status);
+        return false;
+      }
+      m_logger->info("TBT Recovery Response Success for segment {}", static_cast<int>(s.segment));
+      return true;
+    }
+    case MessageType::NewOrder: {
+      const OrderMessage *order = reinterpret_cast<const OrderMessage *>(msg);
+      m_logger->debug("NewOrder: Seq={}, OrderId={}", header.seq_no, order->order_id);
+      break;
+    }
+    default:
+      m_logger->debug("Message Type: {} Seq={}", static_cast<char>(messageType(msg)), header.seq_no);
+  }
+
+  // Call callback with the header and a view of the whole message. check to see if the callback is indeed set.
+  if (m_callback) {
+    m_callback(header, MessageView(reinterpret_cast<const std::byte *>(msg), length));
+  }
+  done = header.seq_no >= request.end_seq;
+  return true;
 }
 } // namespace elaeo::recovery
@@ -0,0 +1,34 @@
+#pragma once
+#include <mutex>
+#include "snapshot_source.h"
+
+// Replays snapshots captured to disk (solace_recovery --save), one raw binary
+// attachment per queue in <directory>/<queue name>.bin. Every queue is
+// delivered from its own thread like the concurrent browser flows, after an
+// optional round trip latency and paced to an optional link rate. Handler
+// calls are serialized like those of the Solace context thread.
+class FileSnapshotSource : public SnapshotSource {
+public:
+    struct Config {
+        std::string directory = "snapshots";
+        uint32_t latencyMs = 0;       // before each snapshot, like the broker round trip
+        uint64_t bytesPerSec = 0;     // delivery rate per queue, 0 = as fast as possible
+    };
+
+    explicit FileSnapshotSource(Config config) : m_config(std::move(config)) {}
+
+    bool initialize() override;
+    bool fetch(const std::vector<std::string>& queues, const Handler& handler, int timeoutMs) override;
+    bool payload(const Message& message, const uint8_t*& data, size_t& length) const override;
+    void release(const Message& message) override;
+    void shutdown() override {}
+    const char* name() const override { return "file"; }
+
+    static std::string path(const std::string& directory, const std::string& queue);
+
+private:
+    bool deliver(size_t queue, const std::string& queueName, const Handler& handler);
+
+    Config m_config;
+    std::mutex m_handlerMutex;
+};
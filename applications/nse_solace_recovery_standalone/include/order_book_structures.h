@@ -14,11 +14,41 @@ struct SolaceSnapshotHeader {
 struct OrderBookRecord {
     char msgType;
     uint64_t timestamp;            // Unique order ID
-    uint64_t orderId;              // Unique order ID
+    uint64_t orderId;              // Unique order ID, the integer value (TBT carries it as a double)
     int token;                     // symbol
     char orderType;                // side (buy/sell)
     uint32_t price;                // price
     uint32_t quantity;             // Quantity
 };
 
+// NSE TBT messages, replayed on top of a snapshot. msgLen covers the whole
+// message, header included, and msgType directly follows the header.
+struct TbtStreamHeader {
+    uint16_t msgLen;
+    uint16_t streamId;
+    uint32_t seqNo;
+};
+
+struct TbtOrderMessage {
+    TbtStreamHeader header;
+    char msgType;                  // 'N', 'M', 'X', spreads 'G', 'H', 'J'
+    uint64_t timestamp;
+    double orderId;
+    uint32_t token;
+    char orderType;                // 'B' / 'S'
+    int32_t price;
+    uint32_t quantity;
+};
+
+struct TbtTradeMessage {
+    TbtStreamHeader header;
+    char msgType;                  // 'T', spreads 'K'
+    uint64_t timestamp;
+    double buyOrderId;
+    double sellOrderId;
+    uint32_t token;
+    uint32_t tradePrice;
+    uint32_t tradeQuantity;
+};
+
 #pragma pack(pop)
@@ -0,0 +1,72 @@
+#pragma once
+#include <cstdint>
+#include <memory>
+#include <mutex>
+#include <unordered_map>
+#include <vector>
+#include <orderbook/order_book.h>
+#include "order_book_structures.h"
+
+// Cold start of order books from Solace snapshots plus TBT replay.
+//
+// A stream's snapshot is bulk loaded into that stream's own OrderBook, sized
+// up front from numRecs so neither the order store nor the indexes grow while
+// loading. Live TBT messages of a stream that arrive before its snapshot are
+// buffered; once the snapshot is in, the buffer is replayed from
+// lastSeqNumber + 1 and the stream goes live, applying messages as they come.
+//
+// Snapshot records carry order ids as integers and TBT messages as doubles;
+// both are normalized to one key (the integer converted to double, keyed on
+// its bits), so replayed messages find the orders the snapshot loaded.
+//
+// Streams are independent: snapshots of different streams may be loaded from
+// different threads at once, while calls for one stream are serialized.
+class SnapshotBootstrap {
+public:
+    using OrderBook = elaeo::business::orderbook::OrderBook;
+
+    struct StreamStats {
+        uint32_t lastSeqNumber = 0;   // of the snapshot
+        uint32_t nextSeqNumber = 0;   // next TBT sequence expected once live
+        uint64_t loaded = 0;          // snapshot records in the book
+        uint64_t duplicates = 0;      // snapshot records repeating an order id
+        uint64_t replayed = 0;        // buffered TBT applied after the snapshot
+        uint64_t stale = 0;           // TBT already covered by the snapshot
+        uint64_t applied = 0;         // TBT applied live
+        uint64_t unknownOrders = 0;   // TBT for orders the book doesn't have
+        uint64_t gaps = 0;            // sequence jumps seen once live
+        double loadMs = 0;
+        double replayMs = 0;
+    };
+
+    // Load one stream's snapshot, header followed by its records; false if it
+    // is malformed or the stream already has one
+    bool loadSnapshot(const uint8_t* data, size_t length);
+
+    // Feed one whole live TBT message of any stream
+    void onTbtMessage(const uint8_t* msg, size_t length);
+
+    bool isLive(uint16_t streamId) const;
+
+    // Book and stats of a stream, nullptr / false before its first snapshot or
+    // TBT message. Only read them while nothing is fed for that stream.
+    const OrderBook* book(uint16_t streamId) const;
+    bool stats(uint16_t streamId, StreamStats& stats) const;
+
+private:
+    struct Stream {
+        mutable std::mutex mutex;
+        bool live = false;
+        std::unique_ptr<OrderBook> book;
+        std::vector<uint8_t> pending;   // TBT buffered ahead of the snapshot, back to back
+        StreamStats stats;
+    };
+
+    Stream& stream(uint16_t streamId);
+    const Stream* findStream(uint16_t streamId) const;
+    // false for a stale (already in the snapshot) or truncated message
+    bool apply(Stream& stream, const uint8_t* msg, size_t length);
+
+    mutable std::mutex m_mutex;
+    std::unordered_map<uint16_t, std::unique_ptr<Stream>> m_streams;
+};
@@ -0,0 +1,41 @@
+#pragma once
+#include <cstddef>
+#include <cstdint>
+#include <functional>
+#include <string>
+#include <vector>
+
+// Where order book snapshots come from: the exchange's Solace LVQs, or a
+// local stand-in replaying captured snapshots from disk for tests and
+// benchmarks without a broker.
+class SnapshotSource {
+public:
+    // A delivered snapshot, still in the source's own buffer. handle is the
+    // source's (the Solace message for the Solace source).
+    struct Message {
+        size_t queue = 0;        // index into the fetched queues
+        void* handle = nullptr;
+    };
+
+    // Called once per delivered snapshot with ownership of it, one call at a
+    // time. Implementations return immediately and hand the message on; the
+    // receiver reads it with payload() and must release() it when done.
+    using Handler = std::function<void(const Message& message)>;
+
+    virtual ~SnapshotSource() = default;
+
+    virtual bool initialize() = 0;
+
+    // Deliver the snapshot of every queue to handler. Returns once all of
+    // them were delivered or failed, or after timeoutMs; false if any queue
+    // is left without a snapshot.
+    virtual bool fetch(const std::vector<std::string>& queues, const Handler& handler, int timeoutMs) = 0;
+
+    // The binary attachment of a delivered message, read in place
+    virtual bool payload(const Message& message, const uint8_t*& data, size_t& length) const = 0;
+    virtual void release(const Message& message) = 0;
+
+    virtual void shutdown() = 0;
+
+    virtual const char* name() const = 0;
+};
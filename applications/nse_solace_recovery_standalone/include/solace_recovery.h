@@ -1,44 +1,76 @@
 #pragma once
+#include <atomic>
+#include <cstdint>
+#include <memory>
+#include <mutex>
 #include <string>
+#include <thread>
 #include <vector>
-#include <solclient/solClient.h>
-#include <solclient/solClientMsg.h>
 #include "order_book_structures.h"
+#include "snapshot_bootstrap.h"
+#include "snapshot_source.h"
+#include "spsc_queue.h"
 
 class SolaceRecovery {
 public:
-    SolaceRecovery();
+    // What one LVQ's snapshot held
+    struct QueueResult {
+        std::string queueName;
+        bool received = false;
+        uint16_t streamId = 0;
+        uint32_t lastSeqNumber = 0;
+        uint32_t numRecs = 0;      // as announced by the header
+        uint32_t records = 0;      // actually present in the message
+        bool loaded = false;       // into the stream's book
+        double loadMs = 0;
+    };
+
+    // Queues, the snapshot source and its settings come from config_file
+    explicit SolaceRecovery(const std::string& config_file);
     ~SolaceRecovery();
-    
+
     bool initialize();
-    void recoverAllQueues();
+
+    // Fetch every queue's snapshot at once and wait until all of them were
+    // parsed and loaded (or the timeout passes); false if any queue came back empty
+    bool recoverAllQueues();
     void shutdown();
 
+    // Print every record of every snapshot
+    void setVerbose(bool verbose) { m_verbose = verbose; }
+
+    // Write each received snapshot to <directory>/<queue>.bin, replayable by the file source
+    void setSaveDirectory(const std::string& directory) { m_saveDirectory = directory; }
+
+    const std::vector<QueueResult>& results() const { return m_results; }
+
+    // Books built from the snapshots; feed live TBT through onTbtMessage() to
+    // replay it from each snapshot's lastSeqNumber + 1
+    SnapshotBootstrap& bootstrap() { return m_bootstrap; }
+
 private:
-    static const char* SOLACE_HOST;
-    static const char* SOLACE_VPN;
-    static const char* SOLACE_USERNAME;
-    static const char* SOLACE_PASSWORD;
-    static const std::vector<std::string> QUEUE_NAMES;
-    
-    void processQueue(const std::string& queueName);
-    void processMessage(solClient_opaqueMsg_pt msg);
+    bool loadConfig(const std::string& config_file);
+    void startParsers(size_t count);
+    void stopParsers();
+    void parserLoop(size_t parser);
+    void processSnapshot(size_t queue, const uint8_t* data, size_t length);
+    void saveSnapshot(size_t queue, const uint8_t* data, size_t length);
     void printOrderBook(const uint8_t* data, size_t length);
     void hexDump(const uint8_t* data, size_t length);
 
-    solClient_opaqueContext_pt m_context;
-    solClient_opaqueSession_pt m_session;
-    
-    static solClient_rxMsgCallback_returnCode_t messageReceiveCallback( solClient_opaqueSession_pt opaqueSession_p,
-        solClient_opaqueMsg_pt msg_p,
-        void* user_p);
-
-    static void eventCallback(solClient_opaqueSession_pt opaqueSession_p,
-                            solClient_session_eventCallbackInfo_pt eventInfo_p,
-                            void* user_p);
-
-   static void flowEventCallback(
-        solClient_opaqueFlow_pt opaqueFlow_p,
-        solClient_flow_eventCallbackInfo_pt eventInfo_p,
-        void* user_p);
+    std::unique_ptr<SnapshotSource> m_source;
+    std::vector<std::string> m_queueNames;
+    int m_snapshotTimeoutMs = 10000;
+    std::vector<int> m_parserCpus;   // one pinned parser per cpu, none = unpinned
+    bool m_verbose = false;
+    std::string m_saveDirectory;
+    SnapshotBootstrap m_bootstrap;
+    std::vector<QueueResult> m_results;
+
+    // parser pool fed by the source, one ring per parser holding the source's
+    // messages until they are parsed in place and released
+    std::vector<std::thread> m_parsers;
+    std::vector<std::unique_ptr<SpscQueue<SnapshotSource::Message>>> m_snapshots;
+    std::atomic<bool> m_stopping{false};
+    std::mutex m_printMutex;
 };
@@ -0,0 +1,79 @@
+#pragma once
+#include <condition_variable>
+#include <memory>
+#include <mutex>
+#include <solclient/solClient.h>
+#include <solclient/solClientMsg.h>
+#include "snapshot_source.h"
+
+// Browses the exchange's last value queues over Solace, one non blocking
+// browser flow per queue so all binds and snapshots are in flight together.
+// An LVQ only ever holds its latest message, so a queue is done once that
+// one snapshot arrived or its bind failed.
+//
+// Snapshots are taken over from the API (SOLCLIENT_CALLBACK_TAKE_MSG) and
+// handed on as the bare message pointer, so the context thread neither copies
+// nor parses them; their attachment is read in place by whoever releases them.
+class SolaceSnapshotSource : public SnapshotSource {
+public:
+    struct Config {
+        std::string host;
+        std::string vpn;
+        std::string username;
+        std::string password;
+        uint32_t windowSize = 255;    // browser messages in flight, the API maximum
+    };
+
+    explicit SolaceSnapshotSource(Config config);
+    ~SolaceSnapshotSource() override;
+
+    bool initialize() override;
+    bool fetch(const std::vector<std::string>& queues, const Handler& handler, int timeoutMs) override;
+    bool payload(const Message& message, const uint8_t*& data, size_t& length) const override;
+    void release(const Message& message) override;
+    void shutdown() override;
+    const char* name() const override { return "solace"; }
+
+private:
+    // One browser flow per queue, the callbacks' user pointer
+    struct FlowState {
+        SolaceSnapshotSource* owner;
+        size_t queue;
+        std::string queueName;
+        solClient_opaqueFlow_pt flow = nullptr;
+        bool delivered = false;   // context thread only
+        bool done = false;        // snapshot received, or the bind failed
+    };
+
+    bool openFlow(FlowState& state);
+    void closeFlows();
+    void finishFlow(FlowState& state);
+
+    Config m_config;
+    solClient_opaqueContext_pt m_context;
+    solClient_opaqueSession_pt m_session;
+
+    const Handler* m_handler = nullptr;
+    std::vector<std::unique_ptr<FlowState>> m_flows;
+    size_t m_pending = 0;         // flows not done yet
+    size_t m_delivered = 0;
+    std::mutex m_mutex;
+    std::condition_variable m_done;
+
+    static solClient_rxMsgCallback_returnCode_t messageReceiveCallback( solClient_opaqueSession_pt opaqueSession_p,
+        solClient_opaqueMsg_pt msg_p,
+        void* user_p);
+
+    static solClient_rxMsgCallback_returnCode_t flowMessageCallback(solClient_opaqueFlow_pt opaqueFlow_p,
+        solClient_opaqueMsg_pt msg_p,
+        void* user_p);
+
+    static void eventCallback(solClient_opaqueSession_pt opaqueSession_p,
+                            solClient_session_eventCallbackInfo_pt eventInfo_p,
+                            void* user_p);
+
+   static void flowEventCallback(
+        solClient_opaqueFlow_pt opaqueFlow_p,
+        solClient_flow_eventCallbackInfo_pt eventInfo_p,
+        void* user_p);
+};
@@ -0,0 +1,76 @@
+#include "file_snapshot_source.h"
+#include <atomic>
+#include <chrono>
+#include <filesystem>
+#include <fstream>
+#include <iostream>
+#include <memory>
+#include <thread>
+
+bool FileSnapshotSource::initialize() {
+    std::error_code ec;
+    if (!std::filesystem::is_directory(m_config.directory, ec)) {
+        std::cerr << "Snapshot directory " << m_config.directory << " doesn't exist\n";
+        return false;
+    }
+    return true;
+}
+
+std::string FileSnapshotSource::path(const std::string& directory, const std::string& queue) {
+    return directory + "/" + queue + ".bin";
+}
+
+bool FileSnapshotSource::fetch(const std::vector<std::string>& queues, const Handler& handler, int /*timeoutMs*/) {
+    // A file always arrives, there is nothing to time out on
+    std::atomic<size_t> delivered{0};
+    std::vector<std::thread> threads;
+    threads.reserve(queues.size());
+    for (size_t i = 0; i < queues.size(); ++i) {
+        threads.emplace_back([this, i, &queues, &handler, &delivered] {
+            if (deliver(i, queues[i], handler)) {
+                ++delivered;
+            }
+        });
+    }
+    for (auto& thread : threads) {
+        thread.join();
+    }
+    return delivered == queues.size();
+}
+
+bool FileSnapshotSource::deliver(size_t queue, const std::string& queueName, const Handler& handler) {
+    const std::string file = path(m_config.directory, queueName);
+    std::ifstream in(file, std::ios::binary | std::ios::ate);
+    if (!in) {
+        std::cerr << "No captured snapshot for queue " << queueName << " (" << file << ")\n";
+        return false;
+    }
+    // owned by the receiver once delivered, freed by release()
+    auto data = std::make_unique<std::vector<uint8_t>>(static_cast<size_t>(in.tellg()));
+    in.seekg(0);
+    if (!in.read(reinterpret_cast<char*>(data->data()), static_cast<std::streamsize>(data->size()))) {
+        std::cerr << "Failed to read " << file << "\n";
+        return false;
+    }
+
+    auto due = std::chrono::steady_clock::now() + std::chrono::milliseconds(m_config.latencyMs);
+    if (m_config.bytesPerSec) {
+        due += std::chrono::microseconds(data->size() * 1000000 / m_config.bytesPerSec);
+    }
+    std::this_thread::sleep_until(due);
+
+    std::lock_guard<std::mutex> lock(m_handlerMutex);
+    handler(Message{queue, data.release()});
+    return true;
+}
+
+bool FileSnapshotSource::payload(const Message& message, const uint8_t*& data, size_t& length) const {
+    const auto* buffer = static_cast<const std::vector<uint8_t>*>(message.handle);
+    data = buffer->data();
+    length = buffer->size();
+    return true;
+}
+
+void FileSnapshotSource::release(const Message& message) {
+    delete static_cast<std::vector<uint8_t>*>(message.handle);
+}
@@ -1,17 +1,45 @@
 #include "solace_recovery.h"
+#include <cstring>
 #include <iostream>
+#include <string>
 
-int main() {
-    SolaceRecovery recovery;
-    
-    if (!recovery.initialize()) {
-        std::cerr << "Failed to initialize Solace recovery\n";
+void printUsage(const char* program) {
+    std::cout << "Usage: " << program << " <config_file> [--verbose] [--save <directory>]\n";
+    std::cout << "--verbose: print every snapshot record\n";
+    std::cout << "--save: write each snapshot to <directory>/<queue>.bin for the file source to replay\n";
+}
+
+int main(int argc, char* argv[]) {
+    if (argc < 2) {
+        printUsage(argv[0]);
         return 1;
     }
 
-    std::cout << "Starting order book recovery...\n";
-    recovery.recoverAllQueues();
-    std::cout << "Recovery complete\n";
+    try {
+        SolaceRecovery recovery(argv[1]);
+        for (int i = 2; i < argc; ++i) {
+            if (std::strcmp(argv[i], "--verbose") == 0) {
+                recovery.setVerbose(true);
+            } else if (std::strcmp(argv[i], "--save") == 0 && i + 1 < argc) {
+                recovery.setSaveDirectory(argv[++i]);
+            } else {
+                printUsage(argv[0]);
+                return 1;
+            }
+        }
+
+        if (!recovery.initialize()) {
+            std::cerr << "Failed to initialize Solace recovery\n";
+            return 1;
+        }
 
-    return 0;
+        std::cout << "Starting order book recovery...\n";
+        const bool ok = recovery.recoverAllQueues();
+        std::cout << "Recovery complete\n";
+
+        return ok ? 0 : 1;
+    } catch (const std::exception& e) {
+        std::cerr << "Error: " << e.what() << "\n";
+        return 1;
+    }
 }
@@ -0,0 +1,212 @@
+#include "snapshot_bootstrap.h"
+#include <algorithm>
+#include <chrono>
+#include <cstring>
+
+using elaeo::business::orderbook::BookType;
+using elaeo::business::orderbook::Side;
+
+namespace {
+// Books of a stream are sized for at most this many tokens up front
+const size_t MAX_PRESIZED_TOKENS = 1 << 16;
+
+// The one order id key of a book. TBT carries order ids as doubles, snapshot
+// records as integers; the integer is converted to double the way the
+// exchange converts it, so ids past 2^53 round alike, and the double's bits
+// are the key.
+uint64_t orderKey(double orderId) {
+    uint64_t key;
+    std::memcpy(&key, &orderId, sizeof(key));
+    return key;
+}
+
+uint64_t orderKey(uint64_t orderId) {
+    return orderKey(static_cast<double>(orderId));
+}
+
+Side side(char orderType) {
+    return orderType == 'B' ? Side::Buy : Side::Sell;
+}
+
+BookType bookType(char msgType) {
+    return msgType == 'G' || msgType == 'H' || msgType == 'J' || msgType == 'K' ? BookType::Spread
+                                                                                 : BookType::Outright;
+}
+
+double elapsedMs(std::chrono::steady_clock::time_point start) {
+    return std::chrono::duration<double, std::milli>(std::chrono::steady_clock::now() - start).count();
+}
+} // namespace
+
+bool SnapshotBootstrap::loadSnapshot(const uint8_t* data, size_t length) {
+    if (length < sizeof(SolaceSnapshotHeader)) {
+        return false;
+    }
+    SolaceSnapshotHeader header;
+    std::memcpy(&header, data, sizeof(header));
+    const size_t present = (length - sizeof(SolaceSnapshotHeader)) / sizeof(OrderBookRecord);
+    const size_t count = std::min<size_t>(header.numRecs, present);
+
+    Stream& s = stream(header.streamId);
+    std::lock_guard<std::mutex> lock(s.mutex);
+    if (s.live) {
+        return false;
+    }
+
+    auto start = std::chrono::steady_clock::now();
+    s.book = std::make_unique<OrderBook>(std::max<size_t>(count, 1),
+                                         std::min(count, MAX_PRESIZED_TOKENS) + 1);
+    const uint8_t* record = data + sizeof(SolaceSnapshotHeader);
+    for (size_t i = 0; i < count; ++i, record += sizeof(OrderBookRecord)) {
+        OrderBookRecord rec;
+        std::memcpy(&rec, record, sizeof(rec));
+        const auto result = s.book->load(orderKey(rec.orderId), static_cast<uint32_t>(rec.token),
+                                         side(rec.orderType), static_cast<int32_t>(rec.price), rec.quantity,
+                                         bookType(rec.msgType));
+        if (result == OrderBook::Result::Ok) {
+            ++s.stats.loaded;
+        } else {
+            ++s.stats.duplicates;
+        }
+    }
+    s.book->refreshTops();
+    s.stats.lastSeqNumber = header.lastSeqNumber;
+    s.stats.nextSeqNumber = header.lastSeqNumber + 1;
+    s.stats.loadMs = elapsedMs(start);
+
+    // Catch up on what arrived while the snapshot was in flight
+    start = std::chrono::steady_clock::now();
+    for (size_t offset = 0; offset < s.pending.size();) {
+        TbtStreamHeader tbtHeader;
+        std::memcpy(&tbtHeader, s.pending.data() + offset, sizeof(tbtHeader));
+        if (apply(s, s.pending.data() + offset, tbtHeader.msgLen)) {
+            ++s.stats.replayed;
+        }
+        offset += tbtHeader.msgLen;
+    }
+    s.pending.clear();
+    s.pending.shrink_to_fit();
+    s.stats.replayMs = elapsedMs(start);
+
+    s.live = true;
+    return true;
+}
+
+void SnapshotBootstrap::onTbtMessage(const uint8_t* msg, size_t length) {
+    if (length <= sizeof(TbtStreamHeader)) {
+        return;
+    }
+    TbtStreamHeader header;
+    std::memcpy(&header, msg, sizeof(header));
+    if (header.msgLen != length) {
+        return;
+    }
+
+    Stream& s = stream(header.streamId);
+    std::lock_guard<std::mutex> lock(s.mutex);
+    if (!s.live) {
+        s.pending.insert(s.pending.end(), msg, msg + length);
+        return;
+    }
+    if (apply(s, msg, length)) {
+        ++s.stats.applied;
+    }
+}
+
+bool SnapshotBootstrap::apply(Stream& s, const uint8_t* msg, size_t length) {
+    TbtStreamHeader header;
+    std::memcpy(&header, msg, sizeof(header));
+    if (header.seqNo < s.stats.nextSeqNumber) {
+        ++s.stats.stale;
+        return false;
+    }
+    if (header.seqNo > s.stats.nextSeqNumber) {
+        ++s.stats.gaps;
+    }
+    s.stats.nextSeqNumber = header.seqNo + 1;
+
+    OrderBook& book = *s.book;
+    const char msgType = static_cast<char>(msg[sizeof(TbtStreamHeader)]);
+    switch (msgType) {
+    case 'N': case 'M': case 'X':
+    case 'G': case 'H': case 'J': {
+        if (length < sizeof(TbtOrderMessage)) {
+            return false;
+        }
+        TbtOrderMessage order;
+        std::memcpy(&order, msg, sizeof(order));
+        const uint64_t key = orderKey(order.orderId);
+        if (msgType == 'X' || msgType == 'J') {
+            if (book.cancel(key) == OrderBook::Result::UnknownOrder) {
+                ++s.stats.unknownOrders;
+            }
+        } else if (msgType == 'M' || msgType == 'H') {
+            // a modify of an order the snapshot didn't have can only mean it rests at the new values
+            if (book.modify(key, order.price, order.quantity) == OrderBook::Result::UnknownOrder) {
+                book.add(key, order.token, side(order.orderType), order.price, order.quantity, bookType(msgType));
+                ++s.stats.unknownOrders;
+            }
+        } else if (book.add(key, order.token, side(order.orderType), order.price, order.quantity,
+                            bookType(msgType)) == OrderBook::Result::Duplicate) {
+            book.modify(key, order.price, order.quantity);
+        }
+        return true;
+    }
+    case 'T': case 'K': {
+        if (length < sizeof(TbtTradeMessage)) {
+            return false;
+        }
+        TbtTradeMessage trade;
+        std::memcpy(&trade, msg, sizeof(trade));
+        // a zero id is the side that didn't rest in the book
+        for (double orderId : {trade.buyOrderId, trade.sellOrderId}) {
+            if (orderId != 0 && book.execute(orderKey(orderId), trade.tradeQuantity) ==
+                                    OrderBook::Result::UnknownOrder) {
+                ++s.stats.unknownOrders;
+            }
+        }
+        return true;
+    }
+    default:
+        return true; // heartbeats and the like only advance the sequence
+    }
+}
+
+bool SnapshotBootstrap::isLive(uint16_t streamId) const {
+    const Stream* s = findStream(streamId);
+    if (!s) {
+        return false;
+    }
+    std::lock_guard<std::mutex> lock(s->mutex);
+    return s->live;
+}
+
+const SnapshotBootstrap::OrderBook* SnapshotBootstrap::book(uint16_t streamId) const {
+    const Stream* s = findStream(streamId);
+    return s ? s->book.get() : nullptr;
+}
+
+bool SnapshotBootstrap::stats(uint16_t streamId, StreamStats& stats) const {
+    const Stream* s = findStream(streamId);
+    if (!s) {
+        return false;
+    }
+    std::lock_guard<std::mutex> lock(s->mutex);
+    stats = s->stats;
+    return true;
+}
+
+SnapshotBootstrap::Stream& SnapshotBootstrap::stream(uint16_t streamId) {
+    std::lock_guard<std::mutex> lock(m_mutex);
+    auto& s = m_streams[streamId];
+    if (!s) {
+        s = std::make_unique<Stream>();
+    }
+    return *s;
+}
+
+const SnapshotBootstrap::Stream* SnapshotBootstrap::findStream(uint16_t streamId) const {
+    std::lock_guard<std::mutex> lock(m_mutex);
+    auto it = m_streams.find(streamId);
+    return it == m_streams.end() ? nullptr : it->second.get();
+}
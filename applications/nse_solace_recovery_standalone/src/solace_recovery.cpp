@@ -1,184 +1,249 @@
 #include "solace_recovery.h"
+#include <algorithm>
+#include <chrono>
+#include <cstdlib>
+#include <cstring>
+#include <filesystem>
+#include <fstream>
 #include <iostream>
 #include <iomanip>
-#include <unistd.h>
-
-// Hard-coded Solace configuration based on NSE specs
-const char* SolaceRecovery::SOLACE_HOST = "tcp://172.28.124.40:10986";
-const char* SolaceRecovery::SOLACE_VPN = "od_fo_prod";
-const char* SolaceRecovery::SOLACE_USERNAME = "member_fo_prod";
-const char* SolaceRecovery::SOLACE_PASSWORD = "YoEvx#9675";
-
-const std::vector<std::string> SolaceRecovery::QUEUE_NAMES = {
-    "lvq.nse.fo.od.1.orderbook",
-    // "lvq.nse.fo.od.2.orderbook",
-    // "lvq.nse.fo.od.3.orderbook",
-    // "lvq.nse.fo.od.4.orderbook",
-    // @TODO: Add all queue names here
-};
+#include <pthread.h>
+#include <stdexcept>
+#include <yaml-cpp/yaml.h>
+#include "file_snapshot_source.h"
+#include "solace_snapshot_source.h"
+
+namespace {
+// Kept out of the checked-in config: $SOLACE_PASSWORD, else the first line of
+// solace.password_file
+bool loadPassword(const YAML::Node& solace, std::string& password) {
+    if (const char* env = std::getenv("SOLACE_PASSWORD"); env && *env) {
+        password = env;
+        return true;
+    }
+    const std::string passwordFile = solace["password_file"].as<std::string>("");
+    if (passwordFile.empty()) {
+        std::cerr << "No Solace password: set SOLACE_PASSWORD or solace.password_file\n";
+        return false;
+    }
+    std::ifstream file(passwordFile);
+    if (!file || !std::getline(file, password) || password.empty()) {
+        std::cerr << "No Solace password in " << passwordFile << ", expected it on the first line\n";
+        return false;
+    }
+    return true;
+}
+} // namespace
 
-SolaceRecovery::SolaceRecovery() : m_context(nullptr), m_session(nullptr) {}
+SolaceRecovery::SolaceRecovery(const std::string& config_file) {
+    if (!loadConfig(config_file)) {
+        throw std::runtime_error("Failed to load config from " + config_file);
+    }
+}
 
 SolaceRecovery::~SolaceRecovery() {
     shutdown();
 }
 
-bool SolaceRecovery::initialize() {
-    if (solClient_initialize(SOLCLIENT_LOG_DEFAULT_FILTER, nullptr) != SOLCLIENT_OK) {
-        std::cerr << "Failed to initialize Solace client\n";
-        return false;
-    }
+bool SolaceRecovery::loadConfig(const std::string& config_file) {
+    try {
+        YAML::Node config = YAML::LoadFile(config_file);
+        m_queueNames = config["queues"].as<std::vector<std::string>>();
+        m_snapshotTimeoutMs = config["snapshot_timeout_ms"].as<int>(m_snapshotTimeoutMs);
+        if (config["parser_cpus"]) {
+            m_parserCpus = config["parser_cpus"].as<std::vector<int>>();
+        }
 
-    solClient_context_createFuncInfo_t contextFuncInfo = SOLCLIENT_CONTEXT_CREATEFUNC_INITIALIZER;
-    if (solClient_context_create(SOLCLIENT_CONTEXT_PROPS_DEFAULT_WITH_CREATE_THREAD,
-                                &m_context, &contextFuncInfo, sizeof(contextFuncInfo)) != SOLCLIENT_OK) {
-        std::cerr << "Failed to create context\n";
+        const std::string source = config["source"].as<std::string>("solace");
+        if (source == "solace") {
+            YAML::Node solace = config["solace"];
+            SolaceSnapshotSource::Config sourceConfig;
+            sourceConfig.host = solace["host"].as<std::string>();
+            sourceConfig.vpn = solace["vpn"].as<std::string>();
+            sourceConfig.username = solace["username"].as<std::string>();
+            if (!loadPassword(solace, sourceConfig.password)) {
+                return false;
+            }
+            sourceConfig.windowSize = solace["window_size"].as<uint32_t>(sourceConfig.windowSize);
+            m_source = std::make_unique<SolaceSnapshotSource>(sourceConfig);
+        } else if (source == "file") {
+            YAML::Node file = config["file"];
+            FileSnapshotSource::Config sourceConfig;
+            sourceConfig.directory = file["directory"].as<std::string>(sourceConfig.directory);
+            sourceConfig.latencyMs = file["latency_ms"].as<uint32_t>(sourceConfig.latencyMs);
+            sourceConfig.bytesPerSec = file["bytes_per_sec"].as<uint64_t>(sourceConfig.bytesPerSec);
+            m_source = std::make_unique<FileSnapshotSource>(sourceConfig);
+        } else {
+            std::cerr << "Unknown snapshot source '" << source << "', expected solace or file\n";
+            return false;
+        }
+        return true;
+    } catch (const std::exception& e) {
+        std::cerr << "Failed to parse " << config_file << ": " << e.what() << "\n";
         return false;
     }
+}
 
-    // Setup session properties
-    const char* sessionProps[] = {
-        SOLCLIENT_SESSION_PROP_HOST, SOLACE_HOST,
-        SOLCLIENT_SESSION_PROP_VPN_NAME, SOLACE_VPN,
-        SOLCLIENT_SESSION_PROP_USERNAME, SOLACE_USERNAME,
-        SOLCLIENT_SESSION_PROP_PASSWORD, SOLACE_PASSWORD,
-        nullptr, nullptr
-    };
+bool SolaceRecovery::initialize() {
+    return m_source->initialize();
+}
 
-    solClient_session_createFuncInfo_t sessionFuncInfo = SOLCLIENT_SESSION_CREATEFUNC_INITIALIZER;
-    sessionFuncInfo.rxMsgInfo.callback_p = messageReceiveCallback;
-    sessionFuncInfo.rxMsgInfo.user_p = this;  // to setup callback
-    sessionFuncInfo.eventInfo.callback_p = eventCallback;
-    sessionFuncInfo.eventInfo.user_p = this;  
-    
-    if (solClient_session_create((char**)sessionProps, m_context, &m_session,
-                                &sessionFuncInfo, sizeof(sessionFuncInfo)) != SOLCLIENT_OK) {
-        std::cerr << "Failed to create session\n";
-        return false;
+bool SolaceRecovery::recoverAllQueues() {
+    const auto start = std::chrono::steady_clock::now();
+
+    m_results.assign(m_queueNames.size(), QueueResult{});
+    for (size_t i = 0; i < m_queueNames.size(); ++i) {
+        m_results[i].queueName = m_queueNames[i];
     }
 
-    // if (solClient_session_connect(m_session) != SOLCLIENT_OK) {
-    //     std::cerr << "Failed to connect session\n";
-    //     return false;
-    // }
-
-  if (solClient_session_connect(m_session) != SOLCLIENT_OK) {
-    solClient_errorInfo_pt errorInfo = solClient_getLastErrorInfo();
-    std::cerr << "Failed to connect session: " 
-              << solClient_subCodeToString(errorInfo->subCode)
-              << " (" << errorInfo->errorStr << ")" << std::endl;
-    return false;
-}
-    return true;
-}
+    if (!m_saveDirectory.empty()) {
+        std::error_code ec;
+        std::filesystem::create_directories(m_saveDirectory, ec);
+        if (ec) {
+            std::cerr << "Failed to create " << m_saveDirectory << ": " << ec.message() << "\n";
+            return false;
+        }
+    }
+
+    // Parsing happens off the source's threads, on the configured cpus or one
+    // parser per queue at most
+    const size_t cores = std::max(1u, std::thread::hardware_concurrency());
+    startParsers(m_parserCpus.empty() ? std::min(cores, m_queueNames.size()) : m_parserCpus.size());
 
-void SolaceRecovery::recoverAllQueues() {
-    for (const auto& queueName : QUEUE_NAMES) {
-        processQueue(queueName);
+    // The source's thread only hands the message over, it is never copied.
+    // Every ring can hold all queues, so the push can't fail.
+    const SnapshotSource::Handler handler = [this](const SnapshotSource::Message& message) {
+        m_snapshots[message.queue % m_snapshots.size()]->push(message);
+    };
+    const bool complete = m_source->fetch(m_queueNames, handler, m_snapshotTimeoutMs);
+    stopParsers();
+
+    const auto elapsed = std::chrono::duration<double, std::milli>(std::chrono::steady_clock::now() - start).count();
+    size_t received = 0;
+    uint64_t records = 0;
+    for (const auto& result : m_results) {
+        if (result.received) {
+            ++received;
+            records += result.records;
+            std::cout << result.queueName << ": stream " << result.streamId
+                      << " lastSeq " << result.lastSeqNumber
+                      << " records " << result.records << "/" << result.numRecs;
+            SnapshotBootstrap::StreamStats stats;
+            if (result.loaded && m_bootstrap.stats(result.streamId, stats)) {
+                std::cout << " loaded " << stats.loaded << " orders in " << result.loadMs << " ms"
+                          << " (" << (result.loadMs > 0 ? stats.loaded / result.loadMs * 1000.0 : 0.0)
+                          << " records/s), replayed " << stats.replayed << " TBT from "
+                          << result.lastSeqNumber + 1;
+            }
+            std::cout << "\n";
+        } else {
+            std::cerr << result.queueName << ": no snapshot received\n";
+        }
     }
+    std::cout << "Recovered " << received << "/" << m_results.size() << " queues in "
+              << elapsed << " ms from the " << m_source->name() << " source"
+              << (complete ? "" : " (incomplete)") << ", "
+              << (elapsed > 0 ? records / elapsed * 1000.0 : 0.0) << " records/s" << std::endl;
+    return received == m_results.size();
 }
 
-void SolaceRecovery::flowEventCallback(
-    solClient_opaqueFlow_pt /*opaqueFlow_p*/,
-    solClient_flow_eventCallbackInfo_pt eventInfo_p,
-    void* /*user_p*/) 
-{
-    std::cout << "Flow event: " 
-              << solClient_flow_eventToString(eventInfo_p->flowEvent)
-              << std::endl;
+void SolaceRecovery::startParsers(size_t count) {
+    m_stopping = false;
+    for (size_t i = 0; i < count; ++i) {
+        m_snapshots.push_back(std::make_unique<SpscQueue<SnapshotSource::Message>>(m_queueNames.size()));
+    }
+    for (size_t i = 0; i < count; ++i) {
+        m_parsers.emplace_back(&SolaceRecovery::parserLoop, this, i);
+        if (i < m_parserCpus.size()) {
+            cpu_set_t cpus;
+            CPU_ZERO(&cpus);
+            CPU_SET(m_parserCpus[i], &cpus);
+            if (pthread_setaffinity_np(m_parsers.back().native_handle(), sizeof(cpus), &cpus) != 0) {
+                std::cerr << "Failed to pin parser " << i << " to cpu " << m_parserCpus[i] << "\n";
+            }
+        }
+    }
 }
 
-void SolaceRecovery::processQueue(const std::string& queueName) {
-    std::cout << "\nProcessing queue: " << queueName << std::endl;
-
-    solClient_opaqueFlow_pt flow_p = nullptr;
-    const char* flowProps[] = {
-        SOLCLIENT_FLOW_PROP_BIND_BLOCKING, SOLCLIENT_PROP_ENABLE_VAL,
-        SOLCLIENT_FLOW_PROP_BIND_ENTITY_ID, SOLCLIENT_FLOW_PROP_BIND_ENTITY_QUEUE,
-        SOLCLIENT_FLOW_PROP_BIND_NAME, queueName.c_str(),
-        SOLCLIENT_FLOW_PROP_BROWSER, SOLCLIENT_PROP_ENABLE_VAL,
-        SOLCLIENT_FLOW_PROP_WINDOWSIZE, "1",
-        nullptr, nullptr
-    };
-
-    solClient_flow_createFuncInfo_t flowFuncInfo = SOLCLIENT_FLOW_CREATEFUNC_INITIALIZER;
-    
-    // Use correct callback functions for flow
-    flowFuncInfo.rxMsgInfo.callback_p = messageReceiveCallback;
-    flowFuncInfo.rxMsgInfo.user_p = this;
-    flowFuncInfo.eventInfo.callback_p = flowEventCallback;  // Use flow-specific callback
-    flowFuncInfo.eventInfo.user_p = this;
-
-    if (solClient_session_createFlow((char**)flowProps, m_session, &flow_p,
-                                    &flowFuncInfo, sizeof(flowFuncInfo)) != SOLCLIENT_OK) {
-        solClient_errorInfo_pt errorInfo = solClient_getLastErrorInfo();
-        std::cerr << "Failed to create flow for queue: " << queueName 
-                  << " - " << solClient_subCodeToString(errorInfo->subCode)
-                  << " (" << errorInfo->errorStr << ")" << std::endl;
-        return;
+void SolaceRecovery::stopParsers() {
+    m_stopping.store(true, std::memory_order_release);
+    for (auto& parser : m_parsers) {
+        parser.join();
     }
+    m_parsers.clear();
+    m_snapshots.clear();
+}
 
-    // Wait for message processing
-    usleep(1000000);  // Wait for 1 second
+void SolaceRecovery::parserLoop(size_t parser) {
+    SpscQueue<SnapshotSource::Message>& snapshots = *m_snapshots[parser];
+    while (true) {
+        SnapshotSource::Message message;
+        if (!snapshots.pop(message)) {
+            if (!m_stopping.load(std::memory_order_acquire)) {
+                std::this_thread::yield();
+                continue;
+            }
+            // the source is done once stopping is set, one last look drains the ring
+            if (!snapshots.pop(message)) {
+                return;
+            }
+        }
 
-    // Cleanup flow
-    solClient_flow_destroy(&flow_p);
+        // Parsed where the source keeps it, then handed back
+        const uint8_t* data;
+        size_t length;
+        if (m_source->payload(message, data, length)) {
+            processSnapshot(message.queue, data, length);
+        } else {
+            std::cerr << m_queueNames[message.queue] << ": failed to get the snapshot data\n";
+        }
+        m_source->release(message);
+    }
 }
 
-void SolaceRecovery::processMessage(solClient_opaqueMsg_pt msg) {
-    void* data;
-    solClient_uint32_t length;
-    
-    if (solClient_msg_getBinaryAttachmentPtr(msg, &data, &length) != SOLCLIENT_OK) {
-        std::cerr << "Failed to get message data\n";
+void SolaceRecovery::processSnapshot(size_t queue, const uint8_t* data, size_t length) {
+    if (length < sizeof(SolaceSnapshotHeader)) {
+        std::cerr << m_queueNames[queue] << ": message too small for header (" << length << " bytes)\n";
         return;
     }
 
-    std::cout << "\nReceived message with length: " << length << " bytes\n\n";
-    
-    // Print raw hex dump for verification
-    std::cout << "Raw message dump:\n";
-    hexDump(static_cast<const uint8_t*>(data), length);
-    
-    // Parse message header
-    if (length < sizeof(SolaceSnapshotHeader)) {
-        std::cerr << "Message too small for header\n";
-        return;
+    SolaceSnapshotHeader header;
+    std::memcpy(&header, data, sizeof(header));
+    const size_t present = (length - sizeof(SolaceSnapshotHeader)) / sizeof(OrderBookRecord);
+
+    // each queue delivers a single snapshot and has its own slot
+    QueueResult& result = m_results[queue];
+    result.received = true;
+    result.streamId = header.streamId;
+    result.lastSeqNumber = header.lastSeqNumber;
+    result.numRecs = header.numRecs;
+    result.records = static_cast<uint32_t>(std::min<size_t>(header.numRecs, present));
+
+    // Straight into the stream's book, the snapshot message is the only copy
+    const auto start = std::chrono::steady_clock::now();
+    result.loaded = m_bootstrap.loadSnapshot(data, length);
+    result.loadMs = std::chrono::duration<double, std::milli>(std::chrono::steady_clock::now() - start).count();
+    if (!result.loaded) {
+        std::cerr << m_queueNames[queue] << ": failed to load the snapshot of stream " << header.streamId << "\n";
     }
 
-    const auto* header = static_cast<const SolaceSnapshotHeader*>(data);
-    std::cout << "\nMessage Header:\n"
-              << "Length: " << header->messageSize << "\n"
-              << "Sequence: " << header->lastSeqNumber << "\n"
-              << "StreamId: " << header->streamId << "\n"
-              << "NumRecs:" << std::hex << header->numRecs << std::dec 
-              << "\n\n";
+    if (!m_saveDirectory.empty()) {
+        saveSnapshot(queue, data, length);
+    }
 
-    // Process order book records
-    const uint8_t* recordPtr = static_cast<const uint8_t*>(data) + sizeof(SolaceSnapshotHeader);
-    size_t remainingLength = length - sizeof(SolaceSnapshotHeader);
-    int recordCount = 0;
-
-    while (remainingLength >= sizeof(OrderBookRecord)) {
-        const auto* record = reinterpret_cast<const OrderBookRecord*>(recordPtr);
-        
-        std::cout << "Order Record #" << ++recordCount << ":\n"
-                  << "  msg_type: " << record->msg_type << "\n";
-                  << "  timestamp: " << record->timestamp << "\n";
-                  << "  Order ID: " << record->orderId << "\n"
-                  << "  token: " << record->token << "\n"
-                  << "  order type: " << record->orderType << "\n"
-                  << "  Price: " << (record->price / 100.0) << "\n"
-                  << "  Quantity: " << record->quantity << "\n";
-                  // << "  Flags: 0x" << std::hex << record-> << std::dec << "\n\n";
-
-        recordPtr += sizeof(OrderBookRecord);
-        remainingLength -= sizeof(OrderBookRecord);
+    if (m_verbose) {
+        std::lock_guard<std::mutex> lock(m_printMutex);
+        std::cout << "\nQueue " << m_queueNames[queue] << ", " << length << " bytes:\n";
+        hexDump(data, length);
+        printOrderBook(data, length);
     }
+}
 
-    if (remainingLength > 0) {
-        std::cout << "Note: " << remainingLength 
-                  << " bytes of message data remaining\n";
+void SolaceRecovery::saveSnapshot(size_t queue, const uint8_t* data, size_t length) {
+    const std::string file = FileSnapshotSource::path(m_saveDirectory, m_queueNames[queue]);
+    std::ofstream out(file, std::ios::binary | std::ios::trunc);
+    if (!out.write(reinterpret_cast<const char*>(data), static_cast<std::streamsize>(length))) {
+        std::cerr << "Failed to save the snapshot of " << m_queueNames[queue] << " to " << file << "\n";
     }
 }
 
@@ -240,28 +305,8 @@ void SolaceRecovery::printOrderBook(const uint8_t* data, size_t length) {
     }
 }
 
-solClient_rxMsgCallback_returnCode_t SolaceRecovery::messageReceiveCallback( solClient_opaqueSession_pt /*opaqueSession_p*/, solClient_opaqueMsg_pt msg_p, void* user_p) 
-{
-    auto* recovery = static_cast<SolaceRecovery*>(user_p);
-    recovery->processMessage(msg_p);
-    return SOLCLIENT_CALLBACK_OK;  // Add this return value
-}
-
-void SolaceRecovery::eventCallback(solClient_opaqueSession_pt /*opaqueSession_p*/,
-                                 solClient_session_eventCallbackInfo_pt eventInfo_p,
-                                 void* /*user_p*/) {
-    std::cout << "Session event: " 
-              << solClient_session_eventToString(eventInfo_p->sessionEvent)
-              << std::endl;
-}
-
 void SolaceRecovery::shutdown() {
-    if (m_session) {
-        solClient_session_disconnect(m_session);
-        solClient_session_destroy(&m_session);
-    }
-    if (m_context) {
-        solClient_context_destroy(&m_context);
+    if (m_source) {
+        m_source->shutdown();
     }
-    solClient_cleanup();
 }
@@ -0,0 +1,223 @@
+#include "solace_snapshot_source.h"
+#include <chrono>
+#include <iostream>
+#include <string>
+
+SolaceSnapshotSource::SolaceSnapshotSource(Config config)
+    : m_config(std::move(config)), m_context(nullptr), m_session(nullptr) {}
+
+SolaceSnapshotSource::~SolaceSnapshotSource() {
+    shutdown();
+}
+
+bool SolaceSnapshotSource::initialize() {
+    if (solClient_initialize(SOLCLIENT_LOG_DEFAULT_FILTER, nullptr) != SOLCLIENT_OK) {
+        std::cerr << "Failed to initialize Solace client\n";
+        return false;
+    }
+
+    solClient_context_createFuncInfo_t contextFuncInfo = SOLCLIENT_CONTEXT_CREATEFUNC_INITIALIZER;
+    if (solClient_context_create(SOLCLIENT_CONTEXT_PROPS_DEFAULT_WITH_CREATE_THREAD,
+                                &m_context, &contextFuncInfo, sizeof(contextFuncInfo)) != SOLCLIENT_OK) {
+        std::cerr << "Failed to create context\n";
+        return false;
+    }
+
+    // Setup session properties
+    const char* sessionProps[] = {
+        SOLCLIENT_SESSION_PROP_HOST, m_config.host.c_str(),
+        SOLCLIENT_SESSION_PROP_VPN_NAME, m_config.vpn.c_str(),
+        SOLCLIENT_SESSION_PROP_USERNAME, m_config.username.c_str(),
+        SOLCLIENT_SESSION_PROP_PASSWORD, m_config.password.c_str(),
+        nullptr, nullptr
+    };
+
+    solClient_session_createFuncInfo_t sessionFuncInfo = SOLCLIENT_SESSION_CREATEFUNC_INITIALIZER;
+    sessionFuncInfo.rxMsgInfo.callback_p = messageReceiveCallback;
+    sessionFuncInfo.rxMsgInfo.user_p = this;  // to setup callback
+    sessionFuncInfo.eventInfo.callback_p = eventCallback;
+    sessionFuncInfo.eventInfo.user_p = this;
+
+    if (solClient_session_create((char**)sessionProps, m_context, &m_session,
+                                &sessionFuncInfo, sizeof(sessionFuncInfo)) != SOLCLIENT_OK) {
+        std::cerr << "Failed to create session\n";
+        return false;
+    }
+
+    if (solClient_session_connect(m_session) != SOLCLIENT_OK) {
+        solClient_errorInfo_pt errorInfo = solClient_getLastErrorInfo();
+        std::cerr << "Failed to connect session: "
+                  << solClient_subCodeToString(errorInfo->subCode)
+                  << " (" << errorInfo->errorStr << ")" << std::endl;
+        return false;
+    }
+    return true;
+}
+
+bool SolaceSnapshotSource::fetch(const std::vector<std::string>& queues, const Handler& handler, int timeoutMs) {
+    {
+        std::lock_guard<std::mutex> lock(m_mutex);
+        m_handler = &handler;
+        m_pending = queues.size();
+        m_delivered = 0;
+    }
+
+    // Bind every flow without blocking, the binds and the snapshots they
+    // deliver are all in flight together
+    for (size_t i = 0; i < queues.size(); ++i) {
+        m_flows.push_back(std::make_unique<FlowState>(FlowState{this, i, queues[i]}));
+        if (!openFlow(*m_flows.back())) {
+            finishFlow(*m_flows.back());
+        }
+    }
+
+    {
+        std::unique_lock<std::mutex> lock(m_mutex);
+        m_done.wait_for(lock, std::chrono::milliseconds(timeoutMs), [this] { return m_pending == 0; });
+    }
+    // no callbacks once the flows are gone
+    closeFlows();
+
+    std::lock_guard<std::mutex> lock(m_mutex);
+    m_handler = nullptr;
+    return m_delivered == queues.size();
+}
+
+void SolaceSnapshotSource::flowEventCallback(
+    solClient_opaqueFlow_pt /*opaqueFlow_p*/,
+    solClient_flow_eventCallbackInfo_pt eventInfo_p,
+    void* user_p)
+{
+    auto* state = static_cast<FlowState*>(user_p);
+
+    switch (eventInfo_p->flowEvent) {
+    case SOLCLIENT_FLOW_EVENT_UP_NOTICE:
+        break;
+    case SOLCLIENT_FLOW_EVENT_BIND_FAILED_ERROR:
+    case SOLCLIENT_FLOW_EVENT_DOWN_ERROR:
+        std::cerr << "Flow for queue " << state->queueName << ": "
+                  << solClient_flow_eventToString(eventInfo_p->flowEvent)
+                  << " (" << eventInfo_p->info_p << ")" << std::endl;
+        state->owner->finishFlow(*state);
+        break;
+    default:
+        std::cout << "Flow event for queue " << state->queueName << ": "
+                  << solClient_flow_eventToString(eventInfo_p->flowEvent)
+                  << std::endl;
+        break;
+    }
+}
+
+bool SolaceSnapshotSource::openFlow(FlowState& state) {
+    const std::string windowSize = std::to_string(m_config.windowSize);
+    const char* flowProps[] = {
+        SOLCLIENT_FLOW_PROP_BIND_BLOCKING, SOLCLIENT_PROP_DISABLE_VAL,
+        SOLCLIENT_FLOW_PROP_BIND_ENTITY_ID, SOLCLIENT_FLOW_PROP_BIND_ENTITY_QUEUE,
+        SOLCLIENT_FLOW_PROP_BIND_NAME, state.queueName.c_str(),
+        SOLCLIENT_FLOW_PROP_BROWSER, SOLCLIENT_PROP_ENABLE_VAL,
+        SOLCLIENT_FLOW_PROP_WINDOWSIZE, windowSize.c_str(),
+        nullptr, nullptr
+    };
+
+    solClient_flow_createFuncInfo_t flowFuncInfo = SOLCLIENT_FLOW_CREATEFUNC_INITIALIZER;
+    flowFuncInfo.rxMsgInfo.callback_p = flowMessageCallback;
+    flowFuncInfo.rxMsgInfo.user_p = &state;
+    flowFuncInfo.eventInfo.callback_p = flowEventCallback;
+    flowFuncInfo.eventInfo.user_p = &state;
+
+    // Non blocking bind returns SOLCLIENT_IN_PROGRESS, the outcome arrives as a flow event
+    const solClient_returnCode_t rc = solClient_session_createFlow((char**)flowProps, m_session, &state.flow,
+                                                                   &flowFuncInfo, sizeof(flowFuncInfo));
+    if (rc != SOLCLIENT_OK && rc != SOLCLIENT_IN_PROGRESS) {
+        solClient_errorInfo_pt errorInfo = solClient_getLastErrorInfo();
+        std::cerr << "Failed to create flow for queue: " << state.queueName
+                  << " - " << solClient_subCodeToString(errorInfo->subCode)
+                  << " (" << errorInfo->errorStr << ")" << std::endl;
+        return false;
+    }
+    return true;
+}
+
+void SolaceSnapshotSource::closeFlows() {
+    for (auto& state : m_flows) {
+        if (state->flow) {
+            solClient_flow_destroy(&state->flow);
+        }
+    }
+    m_flows.clear();
+}
+
+void SolaceSnapshotSource::finishFlow(FlowState& state) {
+    {
+        std::lock_guard<std::mutex> lock(m_mutex);
+        if (state.done) {
+            return;
+        }
+        state.done = true;
+        --m_pending;
+    }
+    m_done.notify_all();
+}
+
+solClient_rxMsgCallback_returnCode_t SolaceSnapshotSource::messageReceiveCallback( solClient_opaqueSession_pt /*opaqueSession_p*/, solClient_opaqueMsg_pt /*msg_p*/, void* /*user_p*/)
+{
+    // Snapshots only arrive on the queue browser flows
+    return SOLCLIENT_CALLBACK_OK;
+}
+
+solClient_rxMsgCallback_returnCode_t SolaceSnapshotSource::flowMessageCallback(solClient_opaqueFlow_pt /*opaqueFlow_p*/, solClient_opaqueMsg_pt msg_p, void* user_p)
+{
+    auto* state = static_cast<FlowState*>(user_p);
+    SolaceSnapshotSource* source = state->owner;
+    if (state->delivered) {
+        return SOLCLIENT_CALLBACK_OK; // the LVQ's one snapshot is already in
+    }
+    state->delivered = true;
+
+    // Keep the message and pass the pointer on, the attachment is only looked at by the receiver.
+    // The handler is set for as long as the flows exist.
+    (*source->m_handler)(Message{state->queue, msg_p});
+    {
+        std::lock_guard<std::mutex> lock(source->m_mutex);
+        ++source->m_delivered;
+    }
+    source->finishFlow(*state);
+    return SOLCLIENT_CALLBACK_TAKE_MSG;
+}
+
+bool SolaceSnapshotSource::payload(const Message& message, const uint8_t*& data, size_t& length) const {
+    void* attachment;
+    solClient_uint32_t size;
+    if (solClient_msg_getBinaryAttachmentPtr(static_cast<solClient_opaqueMsg_pt>(message.handle), &attachment,
+                                             &size) != SOLCLIENT_OK) {
+        return false;
+    }
+    data = static_cast<const uint8_t*>(attachment);
+    length = size;
+    return true;
+}
+
+void SolaceSnapshotSource::release(const Message& message) {
+    solClient_opaqueMsg_pt msg_p = message.handle;
+    solClient_msg_free(&msg_p);
+}
+
+void SolaceSnapshotSource::eventCallback(solClient_opaqueSession_pt /*opaqueSession_p*/,
+                                 solClient_session_eventCallbackInfo_pt eventInfo_p,
+                                 void* /*user_p*/) {
+    std::cout << "Session event: "
+              << solClient_session_eventToString(eventInfo_p->sessionEvent)
+              << std::endl;
+}
+
+void SolaceSnapshotSource::shutdown() {
+    closeFlows();
+    if (m_session) {
+        solClient_session_disconnect(m_session);
+        solClient_session_destroy(&m_session);
+    }
+    if (m_context) {
+        solClient_context_destroy(&m_context);
+        solClient_cleanup();
+    }
+}
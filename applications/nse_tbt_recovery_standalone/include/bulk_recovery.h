@@ -0,0 +1,97 @@
+#pragma once
+
+#include <atomic>
+#include <cstdint>
+#include <deque>
+#include <map>
+#include <memory>
+#include <mutex>
+#include <string>
+#include <thread>
+#include <utility>
+#include <vector>
+#include "tbt_recovery_client.h"
+#include <capture/writer.h>
+
+namespace acce {
+namespace recovery {
+
+// Recovers a list of gap ranges, e.g. everything missed during an incident, in
+// one run.
+//
+// Ranges are read from a text file, one "<segment> <stream_id> <start_seq>
+// <end_seq>" per line ('#' starts a comment). Every segment gets its own
+// max_sessions workers pulling ranges from that segment's queue, so segments
+// recover concurrently and each stays within its exchange session limit.
+//
+// Recovered messages go to one capture file per (segment, stream) under the
+// output directory, <SEG>_<stream_id>.cap. Workers stage a range's messages
+// locally and append them to the stream's file in one go; the file's writer
+// batches buffers into large writev calls. A range too big to stage whole goes
+// out in 8 MB batches, with the stream's file held by that worker from the
+// first batch to the last, so a range's records are always contiguous.
+// Records of a stream are in sequence order within a range, ranges land in
+// the order they complete.
+class BulkRecovery {
+public:
+  struct Stats {
+    uint64_t ranges = 0;
+    uint64_t failed_ranges = 0;
+    uint64_t messages = 0;
+    uint64_t bytes = 0;
+    double elapsed_ms = 0;
+  };
+
+  BulkRecovery(const std::string& config_file, const std::string& output_dir);
+  ~BulkRecovery();
+
+  bool loadRanges(const std::string& ranges_file);
+
+  // One client per worker, all sharing one session pool and local store
+  bool initialize();
+
+  // Recover every range, false if any of them failed
+  bool run();
+
+  const Stats& stats() const { return m_stats; }
+
+private:
+  // Messages of the range being recovered, copied out of the client's buffer
+  struct Staging {
+    std::vector<std::byte> data;
+    std::vector<std::pair<uint32_t, uint32_t>> index; // (seq_no, offset)
+  };
+
+  struct StreamOutput {
+    std::mutex mutex;
+    elaeo::foundation::capture::Writer writer{std::size_t{1} << 20, 16};
+  };
+
+  struct SegmentQueue {
+    Segment segment;
+    std::mutex mutex;
+    std::deque<RecoveryRequest> ranges;
+  };
+
+  void worker(TbtRecoveryClient& client, SegmentQueue& queue);
+  // Append the staged messages; lock holds the stream's file from the first
+  // commit of a range until the caller lets go of it after the last
+  bool commit(const RecoveryRequest& request, Staging& staging, std::unique_lock<std::mutex>& lock);
+  StreamOutput* output(Segment segment, uint16_t stream_id);
+
+  std::string m_config_file;
+  std::string m_output_dir;
+  std::map<Segment, std::unique_ptr<SegmentQueue>> m_queues;
+  std::vector<std::pair<std::unique_ptr<TbtRecoveryClient>, SegmentQueue*>> m_workers;
+
+  std::mutex m_outputs_mutex;
+  std::map<std::pair<Segment, uint16_t>, std::unique_ptr<StreamOutput>> m_outputs;
+
+  std::atomic<uint64_t> m_failed{0};
+  std::atomic<uint64_t> m_messages{0};
+  std::atomic<uint64_t> m_bytes{0};
+  Stats m_stats;
+};
+
+} // namespace recovery
+} // namespace acce
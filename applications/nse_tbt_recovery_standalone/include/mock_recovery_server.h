@@ -0,0 +1,108 @@
+#pragma once
+
+#include <atomic>
+#include <cstdint>
+#include <memory>
+#include <random>
+#include <span>
+#include <string>
+#include <unordered_map>
+#include <vector>
+#include "tbt_recovery_client.h"
+#include <capture/reader.h>
+#include <spdlog/logger.h>
+
+namespace acce {
+namespace recovery {
+
+// Local stand-in for the exchange's TBT recovery server, for benchmarking and
+// exercising the recovery clients on localhost.
+//
+// Speaks the same protocol: a RecoveryRequestPacket ('R') is answered with a
+// RecoveryResponse ('Y') and, when accepted, the requested range as whole TBT
+// messages. Messages come either from capture files (e.g. bulk recovery output)
+// or from a deterministic generator of OrderMessage / TradeMessage, so the same
+// range always yields the same bytes.
+//
+// Knobs for realistic and hostile servers: response latency, a per session
+// message rate cap, writes fragmented into small pieces (short reads on the
+// client), random disconnects partway through a response, rejections with a
+// given status, and closing after every response like the exchange does.
+class MockRecoveryServer {
+public:
+  struct Config {
+    std::string listen_ip = "127.0.0.1";
+    uint16_t port = 10990;
+
+    // source, capture files when any are given, the generator otherwise
+    std::vector<std::string> capture_files;
+    uint32_t generator_tokens = 1000;
+    double generator_trade_ratio = 0.1;
+
+    // behaviour
+    uint32_t latency_us = 0;         // before answering a request
+    uint64_t max_msgs_per_sec = 0;   // per session, 0 = unlimited
+    uint32_t max_range = 0;          // larger requests are rejected, 0 = unlimited
+    bool close_after_response = false;
+
+    // fault injection
+    uint32_t fragment_bytes = 0;     // write at most this many bytes per send, 0 = whole batches
+    double disconnect_ratio = 0;     // share of responses cut off partway
+    double reject_ratio = 0;         // share of requests rejected
+    uint8_t reject_status = 1;
+    uint64_t seed = 1;
+  };
+
+  struct Stats {
+    std::atomic<uint64_t> sessions{0};
+    std::atomic<uint64_t> requests{0};
+    std::atomic<uint64_t> rejected{0};
+    std::atomic<uint64_t> disconnects{0};
+    std::atomic<uint64_t> messages{0};
+    std::atomic<uint64_t> bytes{0};
+  };
+
+  explicit MockRecoveryServer(Config config);
+  ~MockRecoveryServer();
+
+  // Parse the 'mock_server' section of a config file
+  static bool loadConfig(const std::string& config_file, Config& config);
+
+  // Load the capture files and start listening
+  bool start();
+
+  // Accept and serve sessions until stop(), stop() may be called from a signal handler
+  void run();
+  void stop();
+
+  const Stats& stats() const { return m_stats; }
+  uint16_t port() const { return m_config.port; }
+
+private:
+  // where each stored message of a stream lives, indexed by seq_no - first_seq
+  struct StoredStream {
+    uint32_t first_seq = 0;
+    std::vector<std::span<const std::byte>> messages;
+  };
+
+  bool loadCaptures();
+  void serveSession(int fd, uint64_t session_id);
+  bool serveRequest(int fd, const RecoveryRequestPacket& request, std::mt19937_64& rng);
+  bool sendResponse(int fd, uint16_t stream_id, uint8_t status);
+  bool sendAll(int fd, const std::byte* data, size_t length);
+  std::span<const std::byte> message(uint16_t stream_id, uint32_t seq_no, std::vector<std::byte>& scratch) const;
+  void generate(uint16_t stream_id, uint32_t seq_no, std::vector<std::byte>& out) const;
+
+  Config m_config;
+  std::shared_ptr<spdlog::logger> m_logger;
+  std::vector<std::unique_ptr<elaeo::foundation::capture::Reader>> m_captures;
+  std::unordered_map<uint16_t, StoredStream> m_streams;
+
+  int m_listen_fd = -1;
+  std::atomic<bool> m_running{false};
+  std::atomic<uint32_t> m_active{0}; // detached session threads still running
+  Stats m_stats;
+};
+
+} // namespace recovery
+} // namespace acce
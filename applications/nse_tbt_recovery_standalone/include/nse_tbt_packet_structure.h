@@ -44,6 +44,11 @@ struct PacketLossPacket {
 
 #pragma pack(pop)
 
+// Spread order ('G', 'H', 'J') and spread trade ('K') messages share the
+// outright layouts, token being the spread contract's
+using SpreadOrderMessage = OrderMessage;
+using SpreadTradeMessage = TradeMessage;
+
 // Message type identifiers
 enum class MessageType : uint8_t {
     NewOrder = 'N',
@@ -59,5 +64,11 @@ enum class MessageType : uint8_t {
     Recovery = 'Y'
 };
 
+// msg_len covers the whole message, StreamHeader included, and the message
+// type byte directly follows the header.
+inline MessageType messageType(const uint8_t* msg) {
+    return static_cast<MessageType>(msg[sizeof(StreamHeader)]);
+}
+
 } // namespace recovery
 } // namespace acce
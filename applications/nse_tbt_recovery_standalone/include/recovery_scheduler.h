@@ -0,0 +1,89 @@
+#pragma once
+
+#include <atomic>
+#include <condition_variable>
+#include <cstdint>
+#include <functional>
+#include <memory>
+#include <mutex>
+#include <string>
+#include <vector>
+#include "tbt_recovery_client.h"
+
+namespace acce {
+namespace recovery {
+
+// Splits a large recovery range into chunks, fetches them over a bounded number
+// of parallel sessions and hands the messages back in sequence order.
+class RecoveryScheduler {
+public:
+  struct Stats {
+    uint64_t messages;
+    uint64_t bytes;
+    uint32_t chunks;
+    uint32_t sessions;
+    double elapsed_ms;
+  };
+
+  explicit RecoveryScheduler(const std::string& config_file);
+  ~RecoveryScheduler();
+
+  // Initialize one recovery client per session
+  bool initialize();
+
+  // Recover [start_seq, end_seq]; the callback sees messages in sequence order
+  bool requestRecovery(const RecoveryRequest& request);
+
+  void setCallback(TbtRecoveryClient::RecoveryCallback callback) { m_callback = callback; }
+
+  // Additionally hand over each chunk whole, its messages back to back in sequence order, for batch decoding
+  using BatchCallback = std::function<void(MessageView messages)>;
+  void setBatchCallback(BatchCallback callback) { m_batch_callback = std::move(callback); }
+
+  // Override the configured session count / chunk size (0 keeps the configured value)
+  void setLimits(uint32_t max_sessions, uint32_t chunk_size) {
+    m_max_sessions_override = max_sessions;
+    m_chunk_size_override = chunk_size;
+  }
+
+  // Fetch everything from the exchange even if store_dir is configured, set before initialize()
+  void disableRecoveryStore() { m_store_disabled = true; }
+
+  const Stats& lastStats() const { return m_stats; }
+
+private:
+  // Messages of one chunk, stored back to back and indexed so they can be replayed in order.
+  struct Chunk {
+    uint32_t start_seq;
+    uint32_t end_seq;
+    std::vector<std::byte> data;
+    std::vector<uint32_t> offsets; // start of each message in data
+    bool done = false;
+    bool ok = false;
+  };
+
+  void runSession(TbtRecoveryClient& client, const RecoveryRequest& request);
+  void emitChunk(const Chunk& chunk);
+
+  std::string m_config_file;
+  std::vector<std::unique_ptr<TbtRecoveryClient>> m_clients;
+  TbtRecoveryClient::RecoveryCallback m_callback;
+  BatchCallback m_batch_callback;
+  uint32_t m_max_sessions_override = 0;
+  uint32_t m_chunk_size_override = 0;
+  bool m_store_disabled = false;
+
+  // state of the request in flight, shared between the session threads and the emitter
+  std::vector<Chunk> m_chunks;
+  std::atomic<size_t> m_next_chunk{0};
+  size_t m_next_emit = 0;
+  size_t m_window = 0;
+  bool m_abort = false;
+  std::mutex m_mutex;
+  std::condition_variable m_cv;
+
+  Stats m_stats{};
+};
+
+} // namespace recovery
+} // namespace acce
@@ -0,0 +1,82 @@
+#pragma once
+
+#include <atomic>
+#include <chrono>
+#include <condition_variable>
+#include <deque>
+#include <memory>
+#include <mutex>
+#include <thread>
+#include <unordered_map>
+#include <vector>
+#include "tbt_recovery_client.h"
+#include "tcp_connection.h"
+
+namespace acce {
+namespace recovery {
+
+// Keeps pool_size connections per segment open ahead of time so a recovery
+// request never pays the TCP handshake on the gap-fill path.
+//
+// Every open session of a segment counts, idle or borrowed: the background
+// refill stops at pool_size open sessions, and acquire() never opens one
+// beyond max_sessions (the exchange's per-member limit), it waits for a
+// session to come back instead.
+//
+// A background thread per segment health-checks its idle connections every
+// health_check_ms and tops the segment back up to pool_size. Connect attempts
+// walk the segment's endpoints (server_ip:server_port, then failover) starting
+// from the last one that worked, and back off exponentially between rounds,
+// from retry_backoff_ms up to retry_backoff_max_ms, for at most max_retries
+// retries.
+class RecoverySessionPool {
+public:
+  explicit RecoverySessionPool(const std::unordered_map<Segment, RecoveryConfig>& configs);
+  ~RecoverySessionPool();
+
+  RecoverySessionPool(const RecoverySessionPool&) = delete;
+  RecoverySessionPool& operator=(const RecoverySessionPool&) = delete;
+
+  // Start the maintenance threads, they pre-connect every segment right away
+  void start();
+  void stop();
+
+  // A healthy idle connection if there is one, a new one otherwise (waiting
+  // for one to be released while max_sessions are open). nullptr once every
+  // endpoint failed max_retries + 1 times, or on stop().
+  std::unique_ptr<TcpConnection> acquire(Segment segment);
+
+  // Hand a connection back. Only a reusable one, with nothing left unread, goes
+  // back to the idle list; the rest are closed and replaced in the background.
+  void release(Segment segment, std::unique_ptr<TcpConnection> connection, bool reusable);
+
+  size_t idle(Segment segment) const;
+
+private:
+  struct SegmentPool {
+    RecoveryConfig config;
+    std::vector<Endpoint> endpoints;
+    size_t preferred = 0; // endpoint that last accepted a connection
+    std::deque<std::unique_ptr<TcpConnection>> idle;
+    size_t open = 0;      // idle, borrowed and being connected, under m_mutex
+    uint32_t failures = 0; // consecutive failed background refills
+    std::chrono::steady_clock::time_point next_refill{};
+  };
+
+  // one round over all endpoints, starting at the preferred one, for a
+  // session already counted in pool.open; uncounts it if none connects
+  std::unique_ptr<TcpConnection> connectOnce(SegmentPool& pool);
+  // sessions of the segment that may be open at once
+  static size_t sessionLimit(const SegmentPool& pool);
+  std::chrono::milliseconds backoff(const RecoveryConfig& config, uint32_t failures) const;
+  void maintain(SegmentPool& pool);
+
+  std::unordered_map<Segment, SegmentPool> m_pools;
+  mutable std::mutex m_mutex;
+  std::condition_variable m_cv;
+  std::vector<std::thread> m_threads;
+  std::atomic<bool> m_stop{false};
+};
+
+} // namespace recovery
+} // namespace acce
@@ -0,0 +1,98 @@
+#pragma once
+
+#include <atomic>
+#include <cstddef>
+#include <cstdint>
+#include <memory>
+#include <mutex>
+#include <span>
+#include <string>
+#include <string_view>
+#include <unordered_map>
+#include <utility>
+#include <vector>
+#include "nse_tbt_packet_structure.h"
+
+namespace acce {
+namespace recovery {
+
+// Append-only, memory-mapped store of the TBT messages of one stream, indexed
+// densely by seq_no.
+//
+// Two files per stream and trading day:
+//   <stem>.idx  a header page followed by one 8-byte entry per seq_no,
+//               (data offset << 16 | message length), 0 while the seq is missing
+//   <stem>.dat  whole messages, StreamHeader included, back to back
+//
+// Both files are mapped MAP_SHARED over a fixed virtual reservation, so growing
+// them never moves the mapping and views handed out stay valid while the store
+// is open. Writers reserve data space with an atomic add on the shared header
+// and publish the index entry last, so any number of threads and processes can
+// append and read the same store without locks.
+class SequenceStore {
+public:
+  SequenceStore() = default;
+  ~SequenceStore();
+
+  SequenceStore(const SequenceStore&) = delete;
+  SequenceStore& operator=(const SequenceStore&) = delete;
+
+  // Open or create <stem>.idx / <stem>.dat
+  bool open(const std::string& stem, uint64_t max_data_bytes);
+  void close();
+  bool isOpen() const { return m_header != nullptr; }
+
+  // Store a whole message, false if its seq_no is already present or on error
+  bool append(const StreamHeader& header, std::span<const std::byte> message);
+
+  // The stored message for seq_no, empty if it's missing
+  std::span<const std::byte> find(uint32_t seq_no);
+
+  bool contains(uint32_t seq_no) { return !find(seq_no).empty(); }
+
+  // Sub-ranges of [start_seq, end_seq] that aren't stored, in order
+  std::vector<std::pair<uint32_t, uint32_t>> missing(uint32_t start_seq, uint32_t end_seq);
+
+  uint64_t dataBytes() const;
+
+private:
+  struct FileHeader;
+
+  bool ensureIndex(uint32_t seq_no);
+  bool ensureData(uint64_t end);
+  uint64_t* entry(uint32_t seq_no) const;
+
+  int m_index_fd = -1;
+  int m_data_fd = -1;
+  uint8_t* m_index_map = nullptr;
+  std::byte* m_data_map = nullptr;
+  FileHeader* m_header = nullptr;
+  uint64_t m_data_reserved = 0;
+
+  // file sizes this process knows about, refreshed from fstat when exceeded
+  std::atomic<uint64_t> m_index_size{0};
+  std::atomic<uint64_t> m_data_size{0};
+  std::mutex m_grow_mutex;
+};
+
+// SequenceStores of every (segment, stream) under one directory, opened on first use
+class RecoveryStore {
+public:
+  explicit RecoveryStore(std::string directory, uint64_t max_data_bytes = uint64_t{64} << 30);
+
+  // Today's store of a stream, nullptr if its files can't be opened. The pointer
+  // stays valid for the lifetime of the RecoveryStore; the live feed keeps it and
+  // appends every message it sees.
+  SequenceStore* stream(std::string_view segment, uint16_t stream_id);
+
+  const std::string& directory() const { return m_directory; }
+
+private:
+  std::string m_directory;
+  uint64_t m_max_data_bytes;
+  std::mutex m_mutex;
+  std::unordered_map<std::string, std::unique_ptr<SequenceStore>> m_streams;
+};
+
+} // namespace recovery
+} // namespace acce
@@ -0,0 +1,97 @@
+#pragma once
+
+#include <cstdint>
+#include <span>
+#include <vector>
+#include "tbt_recovery_client.h"
+
+namespace acce {
+namespace recovery {
+
+// Decodes a buffer of back to back TBT messages (e.g. a recovered chunk) in
+// bulk instead of switching on every message's type byte.
+//
+// decode() walks the length prefixes once to index the buffer, collecting each
+// message's offset and type byte, classifies the type bytes 32 at a time (AVX2
+// compares when the CPU has them, a lookup table otherwise) into order and
+// trade lists, and then decodes each class in its own homogeneous loop into
+// structure of arrays columns. Within a column messages keep their buffer
+// order; consumers needing the interleaving across columns use seq_no.
+//
+// Spread orders / trades share the outright layouts and land in the same
+// columns, type tells them apart. Heartbeats, packet loss and anything
+// unknown are only counted.
+class TbtBatchDecoder {
+public:
+  struct OrderColumns {
+    std::vector<uint32_t> seq_no;
+    std::vector<uint16_t> stream_id;
+    std::vector<uint8_t> type;
+    std::vector<uint64_t> timestamp;
+    std::vector<double> order_id;
+    std::vector<uint32_t> token;
+    std::vector<uint8_t> side; // 'B' / 'S'
+    std::vector<int32_t> price;
+    std::vector<uint32_t> quantity;
+
+    size_t size() const { return seq_no.size(); }
+    void resize(size_t n);
+  };
+
+  struct TradeColumns {
+    std::vector<uint32_t> seq_no;
+    std::vector<uint16_t> stream_id;
+    std::vector<uint8_t> type;
+    std::vector<uint64_t> timestamp;
+    std::vector<double> buy_order_id;
+    std::vector<double> sell_order_id;
+    std::vector<uint32_t> token;
+    std::vector<uint32_t> price;
+    std::vector<uint32_t> quantity;
+
+    size_t size() const { return seq_no.size(); }
+    void resize(size_t n);
+  };
+
+  // totals over every decode() since construction
+  struct Stats {
+    uint64_t messages = 0;
+    uint64_t orders = 0;
+    uint64_t trades = 0;
+    uint64_t other = 0;     // heartbeats, packet loss, unknown types
+    uint64_t truncated = 0; // shorter than their type's struct, dropped
+    uint64_t bytes = 0;
+  };
+
+  // Replace the columns with the messages of data. Returns the bytes consumed,
+  // less than data.size() when it ends in a partial or malformed message.
+  size_t decode(std::span<const std::byte> data);
+
+  const OrderColumns& orders() const { return m_orders; }
+  const TradeColumns& trades() const { return m_trades; }
+  const Stats& stats() const { return m_stats; }
+
+  // whether classification runs on AVX2 on this machine
+  static bool vectorized();
+
+private:
+  size_t index(const uint8_t* data, size_t size);
+  void classify();
+  void decodeOrders(const uint8_t* data);
+  void decodeTrades(const uint8_t* data);
+
+  // per message of the current buffer
+  std::vector<uint32_t> m_offsets;
+  std::vector<uint8_t> m_types; // padded with zeros to a multiple of 32
+
+  // positions in m_offsets of each class
+  std::vector<uint32_t> m_order_idx;
+  std::vector<uint32_t> m_trade_idx;
+
+  OrderColumns m_orders;
+  TradeColumns m_trades;
+  Stats m_stats;
+};
+
+} // namespace recovery
+} // namespace acce
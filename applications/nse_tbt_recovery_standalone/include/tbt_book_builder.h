@@ -0,0 +1,70 @@
+#pragma once
+
+#include <bit>
+#include <cstdint>
+#include <string>
+#include "tbt_recovery_client.h"
+#include "orderbook/implied.h"
+#include "orderbook/order_book.h"
+
+namespace acce {
+namespace recovery {
+
+// Maintains order level books from NSE TBT order ('N', 'M', 'X') and trade ('T')
+// messages on top of the generic elaeo::business::orderbook engine, and spread
+// books from their spread counterparts ('G', 'H', 'J', 'K') in the same engine.
+//
+// NSE order ids are doubles; the book keys them on their bit pattern, which is
+// unique per id and hashes without any floating point work. Feed it the in-order
+// messages of a stream, e.g. as the TbtLiveReceiver handler.
+//
+// Spreads declared with defineSpread() / loadSpreads() also get an implied top
+// of book from their outright legs, kept current as the legs' tops move.
+class TbtBookBuilder {
+public:
+  using OrderBook = elaeo::business::orderbook::OrderBook;
+  using ImpliedSpreads = elaeo::business::orderbook::ImpliedSpreads;
+  using Top = elaeo::business::orderbook::Top;
+
+  struct Stats {
+    uint64_t adds = 0;
+    uint64_t modifies = 0;
+    uint64_t cancels = 0;
+    uint64_t trades = 0;
+    uint64_t unknown_orders = 0; // modify / cancel / trade leg of an order we never saw
+    uint64_t duplicates = 0;
+    uint64_t spread_messages = 0; // spread orders and trades among the above
+    uint64_t ignored = 0;         // heartbeats and other non book messages
+  };
+
+  explicit TbtBookBuilder(size_t expected_orders = size_t{1} << 22, size_t expected_tokens = 1 << 16);
+
+  // Apply one whole message, StreamHeader included
+  void apply(MessageView message);
+
+  // Price spread_token off its legs: buying the spread buys buy_leg and sells sell_leg
+  void defineSpread(uint32_t spread_token, uint32_t buy_leg, uint32_t sell_leg);
+
+  // defineSpread() every entry of the optional 'books: spreads:' config section
+  bool loadSpreads(const std::string& config_file);
+
+  const OrderBook& book() const { return m_book; }
+  const Stats& stats() const { return m_stats; }
+
+  // Implied top of a defined spread, nullptr for an unknown one
+  const Top* implied(uint32_t spread_token) const { return m_implied.implied(spread_token); }
+  const ImpliedSpreads& impliedSpreads() const { return m_implied; }
+
+  static uint64_t orderKey(double order_id) { return std::bit_cast<uint64_t>(order_id); }
+
+private:
+  void onOrder(MessageType type, const OrderMessage& order);
+  void onTrade(const TradeMessage& trade);
+
+  OrderBook m_book;
+  ImpliedSpreads m_implied;
+  Stats m_stats;
+};
+
+} // namespace recovery
+} // namespace acce
@@ -0,0 +1,150 @@
+#pragma once
+
+#include <atomic>
+#include <chrono>
+#include <condition_variable>
+#include <cstdint>
+#include <deque>
+#include <functional>
+#include <memory>
+#include <mutex>
+#include <string>
+#include <thread>
+#include <unordered_map>
+#include <vector>
+#include "tbt_recovery_client.h"
+#include <spdlog/logger.h>
+
+namespace acce {
+namespace recovery {
+
+// Live NSE TBT multicast consumer that keeps every stream gap free.
+//
+// Messages are sequenced per stream_id. When a seq_no jumps ahead the stream
+// buffers its live traffic and hands the missing range to a pool of recovery
+// workers (TbtRecoveryClient, sharing one session pool and local store). Once
+// the range is back the recovered messages and then the buffered ones are
+// delivered in order. A stream that stays stalled longer than max_stall_ms, or
+// buffers more than max_buffered messages, gives the gap up and moves on, so a
+// slow recovery only ever delays its own stream.
+//
+// Sockets, sequencing and delivery all run on the thread calling run(); only the
+// recovery requests run elsewhere.
+class TbtLiveReceiver {
+public:
+  struct Channel {
+    std::string group;
+    uint16_t port;
+  };
+
+  struct StreamStats {
+    uint64_t delivered = 0;
+    uint64_t recovered = 0; // delivered out of gap fills
+    uint64_t duplicates = 0;
+    uint64_t gaps = 0;
+    uint64_t abandoned = 0; // sequence numbers given up on
+  };
+
+  using MessageHandler = std::function<void(const StreamHeader& header, MessageView message)>;
+
+  explicit TbtLiveReceiver(const std::string& config_file);
+  ~TbtLiveReceiver();
+
+  bool initialize();
+
+  // In-order, gap-free messages of every stream, called on the run() thread
+  void setHandler(MessageHandler handler) { m_handler = std::move(handler); }
+
+  // Receive until stop() is called, stop() may be called from any thread or a signal handler
+  void run();
+  void stop() { m_running = false; }
+
+  // Per stream counters, read them from the handler or once run() has returned
+  std::unordered_map<uint16_t, StreamStats> stats() const;
+
+private:
+  // Whole messages kept back to back, indexed by (seq_no, offset)
+  struct MessageBuffer {
+    std::vector<std::byte> data;
+    std::vector<std::pair<uint32_t, uint32_t>> index;
+
+    void add(uint32_t seq_no, MessageView message);
+    void clear() {
+      data.clear();
+      index.clear();
+    }
+    size_t size() const { return index.size(); }
+  };
+
+  struct StreamState {
+    uint16_t stream_id = 0;
+    bool started = false;
+    uint32_t next_seq = 0; // next seq_no to deliver
+
+    // gap fill in flight, [gap_start, gap_end]
+    bool recovering = false;
+    uint64_t generation = 0;
+    uint32_t gap_start = 0;
+    uint32_t gap_end = 0;
+    std::chrono::steady_clock::time_point stalled_since;
+    MessageBuffer pending; // live messages that arrived behind the gap
+
+    SequenceStore* store = nullptr;
+    StreamStats stats;
+  };
+
+  struct GapJob {
+    uint16_t stream_id;
+    uint64_t generation;
+    uint32_t start_seq;
+    uint32_t end_seq;
+  };
+
+  struct GapResult {
+    uint16_t stream_id;
+    uint64_t generation;
+    bool ok;
+    MessageBuffer messages;
+  };
+
+  bool loadConfig();
+  bool openChannels();
+  void onDatagram(const uint8_t* data, size_t length);
+  void onMessage(const StreamHeader& header, MessageView message);
+  void deliver(StreamState& stream, const StreamHeader& header, MessageView message);
+  void startGap(StreamState& stream, uint32_t start_seq, uint32_t end_seq);
+  void completeGap(GapResult& result);
+  void abandonGap(StreamState& stream, const char* reason);
+  void drainPending(StreamState& stream);
+  void checkStalls();
+  void logStats() const;
+  void recoveryWorker(TbtRecoveryClient& client);
+
+  std::string m_config_file;
+  Segment m_segment = Segment::FO;
+  std::string m_interface_ip;
+  std::vector<Channel> m_channels;
+  std::vector<int> m_sockets;
+  uint32_t m_max_buffered = 0;
+  std::chrono::milliseconds m_max_stall{0};
+  uint32_t m_workers = 1;
+
+  MessageHandler m_handler;
+  std::shared_ptr<spdlog::logger> m_logger;
+  std::atomic<bool> m_running{false};
+  std::unordered_map<uint16_t, StreamState> m_streams;
+
+  // recovery workers, fed with gaps by the receive thread and answering through m_results
+  std::vector<std::unique_ptr<TbtRecoveryClient>> m_clients;
+  std::vector<std::thread> m_threads;
+  std::mutex m_jobs_mutex;
+  std::condition_variable m_jobs_cv;
+  std::deque<GapJob> m_jobs;
+  bool m_stop_workers = false;
+  std::mutex m_results_mutex;
+  std::vector<GapResult> m_results;
+  int m_wakeup_fd = -1; // eventfd, a finished gap wakes the receive loop
+};
+
+} // namespace recovery
+} // namespace acce
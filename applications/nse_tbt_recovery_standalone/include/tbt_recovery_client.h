@@ -3,15 +3,23 @@
 #include <string>
 #include <memory>
 #include <vector>
+#include <cstddef>
 #include <cstdint>
+#include <concepts>
 #include <functional>
+#include <span>
 #include <unordered_map>
 #include "nse_tbt_packet_structure.h"
+#include "sequence_store.h"
+#include "tbt_stream_framer.h"
+#include "tcp_connection.h"
 #include <arpa/inet.h>  // ntohs, ntohl
 
 namespace acce {
 namespace recovery {
 
+class RecoverySessionPool;
+
 enum class Segment {
   CM,
   FO,
@@ -19,6 +27,16 @@ enum class Segment {
   CO
 };
 
+inline const char* segmentName(Segment segment) {
+  static constexpr const char* names[] = {"CM", "FO", "CD", "CO"};
+  return names[static_cast<int>(segment)];
+}
+
+struct Endpoint {
+  std::string ip;
+  uint16_t port;
+};
+
 // Recovery configuration
 struct RecoveryConfig {
   std::string server_ip;
@@ -26,6 +44,13 @@ struct RecoveryConfig {
   uint32_t timeout_ms;
   uint32_t max_retries;
   uint32_t buffer_size;
+  uint32_t max_sessions; // concurrent recovery sessions, keep within the exchange's per-member limit
+  uint32_t chunk_size;   // sequence numbers per pipelined request, 0 = no splitting
+  std::vector<Endpoint> failover; // tried in order when server_ip:server_port is down
+  uint32_t pool_size;             // connections kept open ahead of requests
+  uint32_t retry_backoff_ms;      // first connect retry delay, doubled per retry
+  uint32_t retry_backoff_max_ms;  // cap on the connect retry delay
+  uint32_t health_check_ms;       // how often idle pooled connections are checked
 };
 
 // Recovery request parameters
@@ -52,26 +77,76 @@ struct RecoveryResponse{
 
 #pragma pack(pop)
 
+// One complete recovered message, StreamHeader included. Points into the
+// client's receive buffer and is only valid for the duration of the call.
+using MessageView = std::span<const std::byte>;
+
+// Compile-time alternative to RecoveryCallback: any callable taking the parsed
+// header and the message view. It is called directly from the receive loop, so
+// the handler can be inlined.
+template <typename Sink>
+concept RecoverySink = std::invocable<Sink&, const StreamHeader&, MessageView>;
+
 class TbtRecoveryClient {
 public:
   explicit TbtRecoveryClient(const std::string& config_file);
   ~TbtRecoveryClient();
 
-  // Initialize the recovery client
+  // Initialize the recovery client, starts a session pool unless one was shared in
   bool initialize();
 
-  // Request recovery for specified sequence range
+  // Take connections from `pool` instead of a pool of our own, set before initialize()
+  void setSessionPool(std::shared_ptr<RecoverySessionPool> pool) { m_pool = std::move(pool); }
+  const std::shared_ptr<RecoverySessionPool>& sessionPool() const { return m_pool; }
+
+  // Serve from and record into `store` instead of the one configured by store_dir,
+  // set before initialize()
+  void setRecoveryStore(std::shared_ptr<RecoveryStore> store) { m_store = std::move(store); }
+  const std::shared_ptr<RecoveryStore>& recoveryStore() const { return m_store; }
+
+  // Always fetch from the exchange even if store_dir is configured, set before initialize()
+  void disableRecoveryStore() { m_store_disabled = true; }
+
+  // Request recovery for specified sequence range, data messages go to the callback
   bool requestRecovery(const RecoveryRequest& request);
 
+  // Request recovery for specified sequence range, data messages go straight to `sink`.
+  // With a local store, stored messages are replayed from it and only the missing
+  // sub-ranges are fetched from the exchange (and stored on the way through).
+  template <RecoverySink Sink>
+  bool requestRecovery(const RecoveryRequest& request, Sink&& sink);
+
   // Callback interface for recovery data 
-  using RecoveryCallback = std::function<void(uint32_t seq_num, const std::vector<uint8_t>& data)>;
+  using RecoveryCallback = std::function<void(const StreamHeader& header, MessageView message)>;
   void setCallback(RecoveryCallback callback) { m_callback = callback; }
 
+  // Loaded configuration for a segment, nullptr if the segment isn't configured
+  const RecoveryConfig* segmentConfig(Segment segment) const {
+    auto it = m_configs.find(segment);
+    return it == m_configs.end() ? nullptr : &it->second;
+  }
+
 private:
+  // What the receive loop does with a framed message
+  enum class Disposition {
+    Deliver,     // data message, hand it to the sink
+    DeliverLast, // data message reaching end_seq, hand it over and stop
+    Skip,        // control message, already handled
+    Fail         // request rejected or stream broken
+  };
+
   bool loadConfig(const std::string& config_file);
-  bool connectToServer(const std::string& ip, uint16_t port);
   bool sendRequest(const RecoveryRequestPacket& request);
-  bool processRecovery();
+  bool beginRecovery(const RecoveryRequest& request);
+  bool receive();
+  Disposition onMessage(const StreamHeader& hdr, const uint8_t* msg, size_t length);
+  bool endRecovery(bool ok, TbtStreamFramer::Status status);
+  bool shouldRetry(const RecoveryRequest& request, uint32_t attempt) const;
+  void logLocalHit(const RecoveryRequest& request, size_t gaps) const;
+
+  // Fetch the whole range from the exchange
+  template <RecoverySink Sink>
+  bool fetchRemote(const RecoveryRequest& request, Sink&& sink);
   void processTbtMessage( const StreamHeader& tbtHeader, const uint8_t* payload, size_t length);
 
   // Configuration
@@ -79,9 +154,20 @@ private:
   std::unordered_map<Segment, RecoveryConfig> m_configs;
   RecoveryCallback m_callback;
 
-  // TCP socket handling
-  class TcpConnection;
+  // TCP socket handling, the connection is borrowed from the pool for one request
+  std::shared_ptr<RecoverySessionPool> m_pool;
   std::unique_ptr<TcpConnection> m_connection;
+  Segment m_segment;
+  size_t m_received = 0; // bytes received for the request in flight
+
+  // Local copy of recovered and live messages, shared across clients
+  std::string m_store_dir;
+  uint64_t m_store_max_bytes = 0;
+  std::shared_ptr<RecoveryStore> m_store;
+  bool m_store_disabled = false;
+
+  // Receive buffer (buffer_size bytes) messages are framed from in place
+  TbtStreamFramer m_framer;
 
   // Logging
   class Logger;
@@ -91,6 +177,92 @@ private:
   uint32_t m_end_seq;
 };
 
+template <RecoverySink Sink>
+bool TbtRecoveryClient::requestRecovery(const RecoveryRequest& request, Sink&& sink) {
+  SequenceStore* store = m_store ? m_store->stream(segmentName(request.segment), request.stream_id) : nullptr;
+  if (!store) {
+    return fetchRemote(request, sink);
+  }
+
+  // Walk the range in seq order: replay what's stored, fetch and store the gaps.
+  // replay covers [next, end), so a gap at seq 0 doesn't wrap.
+  uint64_t next = request.start_seq;
+  auto replay = [&](uint64_t end) {
+    for (; next < end; ++next) {
+      const auto message = store->find(static_cast<uint32_t>(next));
+      if (message.size() < sizeof(StreamHeader)) {
+        continue; // not stored after all, nothing to hand over
+      }
+      sink(*reinterpret_cast<const StreamHeader*>(message.data()), message);
+    }
+  };
+
+  const auto gaps = store->missing(request.start_seq, request.end_seq);
+  logLocalHit(request, gaps.size());
+  for (const auto& [gap_start, gap_end] : gaps) {
+    replay(gap_start);
+
+    RecoveryRequest gap = request;
+    gap.start_seq = gap_start;
+    gap.end_seq = gap_end;
+    const bool ok = fetchRemote(gap, [&](const StreamHeader& hdr, MessageView message) {
+      store->append(hdr, message);
+      sink(hdr, message);
+    });
+    if (!ok) {
+      return false;
+    }
+    next = uint64_t{gap_end} + 1;
+  }
+  replay(uint64_t{request.end_seq} + 1);
+  return true;
+}
+
+template <RecoverySink Sink>
+bool TbtRecoveryClient::fetchRemote(const RecoveryRequest& request, Sink&& sink) {
+  for (uint32_t attempt = 0;; ++attempt) {
+    if (!beginRecovery(request)) {
+      return false;
+    }
+
+    bool done = false;
+    bool failed = false;
+    auto status = TbtStreamFramer::Status::NeedMore;
+
+    while (!done && !failed) {
+      // (1) One large read straight into the framer's buffer
+      if (!receive()) {
+        failed = true;
+        break;
+      }
+
+      // (2) Process every complete message in place
+      status = m_framer.drain([&](const StreamHeader& hdr, const uint8_t* msg, size_t length) {
+        switch (onMessage(hdr, msg, length)) {
+        case Disposition::Skip:
+          return true;
+        case Disposition::Fail:
+          failed = true;
+          return false;
+        case Disposition::DeliverLast:
+          done = true;
+          [[fallthrough]];
+        case Disposition::Deliver:
+          sink(hdr, MessageView(reinterpret_cast<const std::byte*>(msg), length));
+          break;
+        }
+        return !done;
+      });
+      failed = failed || status == TbtStreamFramer::Status::Malformed;
+    }
+
+    // (3) A pooled session the server dropped while idle answers with nothing, try another one
+    if (endRecovery(done && !failed, status) || !shouldRetry(request, attempt)) {
+      return done && !failed;
+    }
+  }
+}
+
 }
 // namespace recovery
 } // namespace acce
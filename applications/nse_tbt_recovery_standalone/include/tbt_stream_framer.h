@@ -0,0 +1,105 @@
+#pragma once
+
+#include <cstdint>
+#include <cstring>
+#include <memory>
+#include <span>
+#include "nse_tbt_packet_structure.h"
+
+namespace acce {
+namespace recovery {
+
+// Reassembles TBT messages out of large socket reads without copying them.
+//
+// Bytes are received straight into one reusable buffer of `capacity` bytes and
+// complete messages are handed out in place as (header, pointer, length) views.
+// A message that straddles the end of a read stays in the buffer; when the tail
+// runs out of room the partial message is moved back to the front, so every view
+// handed out is contiguous. The buffer is allocated once and never resized.
+class TbtStreamFramer {
+public:
+  enum class Status {
+    NeedMore,  // all complete messages consumed, read more bytes
+    Stopped,   // the handler asked to stop, unconsumed messages stay buffered
+    Malformed  // a header carries a length that can never be framed
+  };
+
+  TbtStreamFramer() = default;
+  explicit TbtStreamFramer(size_t capacity) { reserve(capacity); }
+
+  // Grow the buffer to at least `capacity` bytes, drops any buffered data
+  void reserve(size_t capacity) {
+    if (capacity > m_capacity) {
+      m_buffer = std::make_unique<uint8_t[]>(capacity);
+      m_capacity = capacity;
+    }
+    reset();
+  }
+
+  void reset() {
+    m_head = 0;
+    m_tail = 0;
+  }
+
+  // Free space to receive into; empty only if the buffer is unallocated
+  std::span<uint8_t> writable() {
+    if (m_tail == m_capacity) {
+      compact();
+    }
+    return {m_buffer.get() + m_tail, m_capacity - m_tail};
+  }
+
+  // Account for `bytes` received into writable()
+  void commit(size_t bytes) { m_tail += bytes; }
+
+  size_t buffered() const { return m_tail - m_head; }
+  size_t capacity() const { return m_capacity; }
+
+  // Hand every complete message to handler(const StreamHeader&, const uint8_t* msg, size_t len).
+  // `msg` points at the StreamHeader and `len` covers the whole message. The view
+  // stays valid until the next writable() call. The handler returns false to stop.
+  template <typename Handler>
+  Status drain(Handler&& handler) {
+    while (m_tail - m_head >= sizeof(StreamHeader)) {
+      const uint8_t* msg = m_buffer.get() + m_head;
+      const auto* hdr = reinterpret_cast<const StreamHeader*>(msg);
+      const size_t len = hdr->msg_len;
+
+      if (len < sizeof(StreamHeader) || len > m_capacity) {
+        return Status::Malformed;
+      }
+      if (m_tail - m_head < len) {
+        break;
+      }
+
+      m_head += len;
+      if (!handler(*hdr, msg, len)) {
+        return Status::Stopped;
+      }
+    }
+
+    if (m_head == m_tail) {
+      reset();
+    }
+    return Status::NeedMore;
+  }
+
+private:
+  // move the trailing partial message to the front of the buffer
+  void compact() {
+    const size_t pending = m_tail - m_head;
+    if (pending && m_head) {
+      std::memmove(m_buffer.get(), m_buffer.get() + m_head, pending);
+    }
+    m_head = 0;
+    m_tail = pending;
+  }
+
+  std::unique_ptr<uint8_t[]> m_buffer;
+  size_t m_capacity = 0;
+  size_t m_head = 0;
+  size_t m_tail = 0;
+};
+
+} // namespace recovery
+} // namespace acce
@@ -0,0 +1,51 @@
+#pragma once
+
+#include <atomic>
+#include <cstddef>
+#include <cstdint>
+#include <string>
+#include <sys/types.h>
+
+namespace acce {
+namespace recovery {
+
+// Blocking TCP connection to a recovery server. Send and receive honour the
+// timeout given to connect().
+class TcpConnection {
+public:
+  TcpConnection() : m_socket(-1) {}
+  ~TcpConnection();
+
+  TcpConnection(const TcpConnection &) = delete;
+  TcpConnection &operator=(const TcpConnection &) = delete;
+
+  // Connect within timeout_ms, false on refusal or timeout. A pending connect is
+  // abandoned as soon as *cancel turns true.
+  bool connect(const std::string &ip, uint16_t port, uint32_t timeout_ms,
+               const std::atomic<bool> *cancel = nullptr);
+  void close();
+  bool isOpen() const { return m_socket >= 0; }
+
+  // Non-blocking peek: false once the peer has closed or reset the connection,
+  // or if it holds unread bytes that no request is waiting for.
+  bool healthy() const;
+
+  bool send(const void *data, size_t size);
+
+  // read exactly expected_size bytes, <= 0 on close or error
+  ssize_t recv_full(void *buffer, size_t expected_size);
+
+  // single recv of whatever is available, up to `size` bytes
+  ssize_t recv_some(void *buffer, size_t size);
+
+  const std::string &ip() const { return m_ip; }
+  uint16_t port() const { return m_port; }
+
+private:
+  int m_socket;
+  std::string m_ip;
+  uint16_t m_port = 0;
+};
+
+} // namespace recovery
+} // namespace acce
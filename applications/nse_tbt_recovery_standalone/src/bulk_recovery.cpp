@@ -0,0 +1,232 @@
+#include "bulk_recovery.h"
+#include <algorithm>
+#include <chrono>
+#include <cstring>
+#include <filesystem>
+#include <fmt/format.h>
+#include <fstream>
+#include <sstream>
+#include <spdlog/spdlog.h>
+#include <unordered_map>
+
+namespace acce {
+namespace recovery {
+
+namespace {
+// a range's messages are handed to the stream file at least this often, bounds the staging memory
+constexpr size_t kMaxStagedBytes = size_t{8} << 20;
+} // namespace
+
+BulkRecovery::BulkRecovery(const std::string &config_file, const std::string &output_dir)
+    : m_config_file(config_file), m_output_dir(output_dir) {}
+
+BulkRecovery::~BulkRecovery() {
+  for (auto &[key, out] : m_outputs) {
+    out->writer.close();
+  }
+}
+
+bool BulkRecovery::loadRanges(const std::string &ranges_file) {
+  static const std::unordered_map<std::string, Segment> segment_map = {
+      {"CM", Segment::CM}, {"FO", Segment::FO}, {"CD", Segment::CD}, {"CO", Segment::CO}};
+
+  std::ifstream file(ranges_file);
+  if (!file) {
+    spdlog::error("Failed to open ranges file {}", ranges_file);
+    return false;
+  }
+
+  std::string line;
+  for (size_t line_no = 1; std::getline(file, line); ++line_no) {
+    line = line.substr(0, line.find('#'));
+    std::istringstream fields(line);
+    std::string segment;
+    uint32_t stream_id = 0;
+    uint32_t start_seq = 0;
+    uint32_t end_seq = 0;
+    if (!(fields >> segment)) {
+      continue; // blank or comment
+    }
+    auto it = segment_map.find(segment);
+    if (it == segment_map.end() || !(fields >> stream_id >> start_seq >> end_seq) || stream_id > UINT16_MAX ||
+        end_seq < start_seq) {
+      spdlog::error("{}:{}: expected <segment> <stream_id> <start_seq> <end_seq>, got '{}'", ranges_file, line_no,
+                    line);
+      return false;
+    }
+
+    auto &queue = m_queues[it->second];
+    if (!queue) {
+      queue = std::make_unique<SegmentQueue>();
+      queue->segment = it->second;
+    }
+    queue->ranges.push_back(RecoveryRequest{it->second, static_cast<uint16_t>(stream_id), start_seq, end_seq});
+    ++m_stats.ranges;
+  }
+  return true;
+}
+
+bool BulkRecovery::initialize() {
+  if (m_queues.empty()) {
+    spdlog::error("No ranges to recover");
+    return false;
+  }
+  std::error_code ec;
+  std::filesystem::create_directories(m_output_dir, ec);
+  if (ec) {
+    spdlog::error("Failed to create output directory {}: {}", m_output_dir, ec.message());
+    return false;
+  }
+
+  auto first = std::make_unique<TbtRecoveryClient>(m_config_file);
+  if (!first->initialize()) {
+    return false;
+  }
+  auto pool = first->sessionPool();
+  auto store = first->recoveryStore();
+  const TbtRecoveryClient &configured = *first; // stays alive as the first worker
+
+  for (auto &[segment, queue] : m_queues) {
+    const auto *config = configured.segmentConfig(segment);
+    if (!config) {
+      spdlog::get("tbt_recovery")->error("Ranges given for segment {} which isn't configured", segmentName(segment));
+      return false;
+    }
+    // no point in more workers than ranges
+    const size_t workers = std::min<size_t>(std::max(config->max_sessions, 1u), queue->ranges.size());
+    for (size_t i = 0; i < workers; ++i) {
+      std::unique_ptr<TbtRecoveryClient> client;
+      if (first) {
+        client = std::move(first);
+      } else {
+        client = std::make_unique<TbtRecoveryClient>(m_config_file);
+        client->setSessionPool(pool);
+        client->setRecoveryStore(store);
+        if (!client->initialize()) {
+          return false;
+        }
+      }
+      m_workers.emplace_back(std::move(client), queue.get());
+    }
+  }
+
+  spdlog::get("tbt_recovery")
+      ->info("Bulk recovery of {} ranges over {} segments with {} workers", m_stats.ranges, m_queues.size(),
+             m_workers.size());
+  return true;
+}
+
+bool BulkRecovery::run() {
+  const auto start = std::chrono::steady_clock::now();
+
+  std::vector<std::thread> threads;
+  threads.reserve(m_workers.size());
+  for (auto &[client, queue] : m_workers) {
+    threads.emplace_back(&BulkRecovery::worker, this, std::ref(*client), std::ref(*queue));
+  }
+  for (auto &thread : threads) {
+    thread.join();
+  }
+
+  bool ok = true;
+  for (auto &[key, out] : m_outputs) {
+    if (!out->writer.close()) {
+      spdlog::get("tbt_recovery")->error("Failed to finish capture of {} stream {}: {}", segmentName(key.first),
+                                         key.second, out->writer.error());
+      ok = false;
+    }
+  }
+
+  m_stats.failed_ranges = m_failed.load();
+  m_stats.messages = m_messages.load();
+  m_stats.bytes = m_bytes.load();
+  m_stats.elapsed_ms = std::chrono::duration<double, std::milli>(std::chrono::steady_clock::now() - start).count();
+  return ok && m_stats.failed_ranges == 0;
+}
+
+void BulkRecovery::worker(TbtRecoveryClient &client, SegmentQueue &queue) {
+  auto logger = spdlog::get("tbt_recovery");
+  Staging staging;
+
+  while (true) {
+    RecoveryRequest request;
+    {
+      std::lock_guard<std::mutex> lock(queue.mutex);
+      if (queue.ranges.empty()) {
+        return;
+      }
+      request = queue.ranges.front();
+      queue.ranges.pop_front();
+    }
+
+    staging.data.clear();
+    staging.index.clear();
+    bool committed = true;
+    std::unique_lock<std::mutex> stream_lock; // the stream's file, once a batch of this range went out
+    const bool ok = client.requestRecovery(request, [&](const StreamHeader &header, MessageView message) {
+      staging.index.emplace_back(header.seq_no, static_cast<uint32_t>(staging.data.size()));
+      staging.data.insert(staging.data.end(), message.begin(), message.end());
+      if (staging.data.size() >= kMaxStagedBytes) {
+        committed = commit(request, staging, stream_lock) && committed;
+      }
+    });
+    committed = commit(request, staging, stream_lock) && committed;
+    if (stream_lock) {
+      stream_lock.unlock();
+    }
+
+    if (!ok || !committed) {
+      ++m_failed;
+      logger->error("Bulk range {} stream {} [{}, {}] failed", segmentName(request.segment), request.stream_id,
+                    request.start_seq, request.end_seq);
+    }
+  }
+}
+
+bool BulkRecovery::commit(const RecoveryRequest &request, Staging &staging, std::unique_lock<std::mutex> &lock) {
+  if (staging.index.empty()) {
+    return true;
+  }
+  StreamOutput *out = output(request.segment, request.stream_id);
+  if (!out) {
+    return false;
+  }
+
+  // one lock per range, not per message; other workers of the stream wait
+  // for the whole range so its batches stay together in the file
+  if (!lock) {
+    lock = std::unique_lock<std::mutex>(out->mutex);
+  }
+  bool ok = true;
+  for (size_t i = 0; i < staging.index.size() && ok; ++i) {
+    const auto [seq_no, offset] = staging.index[i];
+    const size_t end = i + 1 < staging.index.size() ? staging.index[i + 1].second : staging.data.size();
+    ok = out->writer.write(seq_no, request.stream_id,
+                           std::span<const std::byte>(staging.data.data() + offset, end - offset));
+  }
+
+  m_messages += staging.index.size();
+  m_bytes += staging.data.size();
+  staging.data.clear();
+  staging.index.clear();
+  return ok;
+}
+
+BulkRecovery::StreamOutput *BulkRecovery::output(Segment segment, uint16_t stream_id) {
+  std::lock_guard<std::mutex> lock(m_outputs_mutex);
+  auto &out = m_outputs[{segment, stream_id}];
+  if (!out) {
+    out = std::make_unique<StreamOutput>();
+    const auto path =
+        (std::filesystem::path(m_output_dir) / fmt::format("{}_{}.cap", segmentName(segment), stream_id)).string();
+    if (!out->writer.open(path, fmt::format("{}_{}", segmentName(segment), stream_id))) {
+      spdlog::get("tbt_recovery")->error("Failed to create {}: {}", path, out->writer.error());
+      m_outputs.erase({segment, stream_id});
+      return nullptr;
+    }
+  }
+  return out.get();
+}
+
+} // namespace recovery
+} // namespace acce
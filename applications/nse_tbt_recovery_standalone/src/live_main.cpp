@@ -0,0 +1,69 @@
+#include "tbt_book_builder.h"
+#include "tbt_live_receiver.h"
+#include <csignal>
+#include <iostream>
+#include <memory>
+#include <string>
+
+namespace {
+acce::recovery::TbtLiveReceiver* g_receiver = nullptr;
+
+void signalHandler(int /*signum*/) {
+  if (g_receiver) {
+    g_receiver->stop();
+  }
+}
+} // namespace
+
+int main(int argc, char* argv[]) {
+  if (argc < 2 || argc > 3 || (argc == 3 && std::string(argv[2]) != "--books")) {
+    std::cout << "Usage: " << argv[0] << " <config_file> [--books]\n";
+    std::cout << "Joins the channels of the 'live' config section and fills gaps from the recovery server\n";
+    std::cout << "  --books  build order level books from the gap-free stream\n";
+    return 1;
+  }
+
+  try {
+    acce::recovery::TbtLiveReceiver receiver(argv[1]);
+    if (!receiver.initialize()) {
+      std::cerr << "Failed to initialize live receiver" << std::endl;
+      return 1;
+    }
+
+    std::unique_ptr<acce::recovery::TbtBookBuilder> books;
+    if (argc == 3) {
+      books = std::make_unique<acce::recovery::TbtBookBuilder>();
+      if (!books->loadSpreads(argv[1])) {
+        return 1;
+      }
+      receiver.setHandler([&books](const acce::recovery::StreamHeader&, acce::recovery::MessageView message) {
+        books->apply(message);
+      });
+    }
+
+    g_receiver = &receiver;
+    std::signal(SIGINT, signalHandler);
+    std::signal(SIGTERM, signalHandler);
+
+    receiver.run();
+    g_receiver = nullptr;
+
+    for (const auto& [stream_id, stats] : receiver.stats()) {
+      std::cout << "stream " << stream_id << ": delivered=" << stats.delivered << " recovered=" << stats.recovered
+                << " duplicates=" << stats.duplicates << " gaps=" << stats.gaps << " abandoned=" << stats.abandoned
+                << std::endl;
+    }
+    if (books) {
+      const auto& stats = books->stats();
+      std::cout << "books: instruments=" << books->book().instruments() << " orders=" << books->book().orders()
+                << " adds=" << stats.adds << " modifies=" << stats.modifies << " cancels=" << stats.cancels
+                << " trades=" << stats.trades << " spread_messages=" << stats.spread_messages
+                << " unknown_orders=" << stats.unknown_orders
+                << " implied_reprices=" << books->impliedSpreads().reprices() << std::endl;
+    }
+    return 0;
+  } catch (const std::exception& e) {
+    std::cerr << "Error: " << e.what() << std::endl;
+    return 1;
+  }
+}
@@ -1,16 +1,71 @@
+#include "bulk_recovery.h"
+#include "recovery_scheduler.h"
+#include "tbt_batch_decoder.h"
 #include "tbt_recovery_client.h"
+#include <chrono>
 #include <iostream>
 #include <string>
 #include <unordered_map>
 #include <stdexcept>
 
 void printUsage(const char* program) {
-  std::cout << "Usage: " << program << " <config_file> <segment> <stream_id> <start_seq> <end_seq>\n";
+  std::cout << "Usage: " << program << " <config_file> <segment> <stream_id> <start_seq> <end_seq> [--benchmark|--decode]\n";
+  std::cout << "       " << program << " <config_file> --bulk <ranges_file> <output_dir>\n";
   std::cout << "Segments: CM, FO, CD, CO\n";
+  std::cout << "--benchmark: run the range through the serial client first and report the pipelined speedup,\n"
+            << "             with the local store off so both runs fetch the whole range from the server\n";
+  std::cout << "--decode: batch decode the recovered chunks into order / trade columns and report the decode rate\n";
+  std::cout << "--bulk: recover every '<segment> <stream_id> <start_seq> <end_seq>' line of ranges_file into\n"
+            << "        per stream capture files under output_dir\n";
+}
+
+int runBulk(const std::string& config_file, const std::string& ranges_file, const std::string& output_dir) {
+  acce::recovery::BulkRecovery bulk(config_file, output_dir);
+  if (!bulk.loadRanges(ranges_file) || !bulk.initialize()) {
+    std::cerr << "Failed to initialize bulk recovery" << std::endl;
+    return 1;
+  }
+  const bool ok = bulk.run();
+
+  const auto& stats = bulk.stats();
+  const double seconds = stats.elapsed_ms / 1000.0;
+  std::cout << "ranges:     " << stats.ranges << " (" << stats.failed_ranges << " failed)\n"
+            << "messages:   " << stats.messages << " in " << stats.elapsed_ms << " ms\n"
+            << "throughput: " << (seconds > 0 ? stats.messages / seconds : 0.0) << " msgs/s, "
+            << (seconds > 0 ? stats.bytes / seconds / (1024.0 * 1024.0) : 0.0) << " MB/s" << std::endl;
+  return ok ? 0 : 1;
+}
+
+// Recover the range over a single connection, the pre-scheduler behaviour. The
+// local store is off, or the pipelined run would replay what this one stored.
+double runSerial(const std::string& config_file, const acce::recovery::RecoveryRequest& request, uint64_t& messages) {
+  acce::recovery::TbtRecoveryClient client(config_file);
+  client.disableRecoveryStore();
+  if (!client.initialize()) {
+    throw std::runtime_error("Failed to initialize serial recovery client");
+  }
+  messages = 0;
+
+  const auto start = std::chrono::steady_clock::now();
+  if (!client.requestRecovery(request, [&messages](const acce::recovery::StreamHeader&,
+                                                   acce::recovery::MessageView) { ++messages; })) {
+    throw std::runtime_error("Serial recovery request failed");
+  }
+  return std::chrono::duration<double, std::milli>(std::chrono::steady_clock::now() - start).count();
 }
 
 int main(int argc, char* argv[]) {
-  if (argc != 6) {
+  if (argc == 5 && std::string(argv[2]) == "--bulk") {
+    try {
+      return runBulk(argv[1], argv[3], argv[4]);
+    } catch (const std::exception& e) {
+      std::cerr << "Error: " << e.what() << std::endl;
+      return 1;
+    }
+  }
+
+  const std::string mode = argc == 7 ? argv[6] : "";
+  if (argc != 6 && !(argc == 7 && (mode == "--benchmark" || mode == "--decode"))) {
     printUsage(argv[0]);
     return 1;
   }
@@ -37,20 +92,6 @@ int main(int argc, char* argv[]) {
       return 1;
     }
 
-    // Initialize recovery client
-    acce::recovery::TbtRecoveryClient client(config_file);
-    if (!client.initialize()) {
-      std::cerr << "Failed to initialize recovery client" << std::endl;
-      return 1;
-    }
-
-    // Set callback to print recovered packets
-    client.setCallback([](uint32_t seq_num, const std::vector<uint8_t>& data) {
-      std::cout << "Recovered packet: seq=" << seq_num 
-                << " size=" << data.size() << std::endl;
-    });
-
-    // Request recovery
     acce::recovery::RecoveryRequest request{
       segment_it->second,
       stream_id,
@@ -58,11 +99,64 @@ int main(int argc, char* argv[]) {
       end_seq
     };
 
-    if (!client.requestRecovery(request)) {
+    double serial_ms = 0.0;
+    uint64_t serial_messages = 0;
+    if (mode == "--benchmark") {
+      serial_ms = runSerial(config_file, request, serial_messages);
+    }
+
+    // Initialize recovery scheduler
+    acce::recovery::RecoveryScheduler scheduler(config_file);
+    if (mode == "--benchmark") {
+      scheduler.disableRecoveryStore();
+    }
+    if (!scheduler.initialize()) {
+      std::cerr << "Failed to initialize recovery client" << std::endl;
+      return 1;
+    }
+
+    // Set callback to print recovered packets
+    if (argc == 6) {
+      scheduler.setCallback([](const acce::recovery::StreamHeader& header, acce::recovery::MessageView message) {
+        std::cout << "Recovered packet: seq=" << header.seq_no
+                  << " size=" << message.size() << std::endl;
+      });
+    }
+
+    acce::recovery::TbtBatchDecoder decoder;
+    double decode_ms = 0.0;
+    if (mode == "--decode") {
+      scheduler.setBatchCallback([&decoder, &decode_ms](acce::recovery::MessageView messages) {
+        const auto start = std::chrono::steady_clock::now();
+        decoder.decode(messages);
+        decode_ms += std::chrono::duration<double, std::milli>(std::chrono::steady_clock::now() - start).count();
+      });
+    }
+
+    // Request recovery
+    if (!scheduler.requestRecovery(request)) {
       std::cerr << "Recovery request failed" << std::endl;
       return 1;
     }
 
+    if (mode == "--decode") {
+      const auto& stats = decoder.stats();
+      std::cout << "decoded:   " << stats.messages << " msgs (" << stats.orders << " orders, " << stats.trades
+                << " trades, " << stats.other << " other, " << stats.truncated << " truncated) in " << decode_ms
+                << " ms" << (acce::recovery::TbtBatchDecoder::vectorized() ? " [avx2]" : "") << "\n"
+                << "rate:      " << (decode_ms > 0 ? stats.messages / decode_ms / 1000.0 : 0.0) << " M msgs/s, "
+                << (decode_ms > 0 ? stats.bytes / decode_ms / 1000.0 : 0.0) << " MB/s" << std::endl;
+    }
+
+    if (mode == "--benchmark") {
+      const auto& stats = scheduler.lastStats();
+      std::cout << "serial:    " << serial_messages << " msgs in " << serial_ms << " ms\n"
+                << "pipelined: " << stats.messages << " msgs in " << stats.elapsed_ms << " ms ("
+                << stats.chunks << " chunks over " << stats.sessions << " sessions)\n"
+                << "speedup:   " << (stats.elapsed_ms > 0 ? serial_ms / stats.elapsed_ms : 0.0) << "x\n"
+                << "store:     off, both runs fetched from the server" << std::endl;
+    }
+
     return 0;
   }
   catch (const std::exception& e) {
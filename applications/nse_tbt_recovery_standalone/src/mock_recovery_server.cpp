@@ -0,0 +1,360 @@
+#include "mock_recovery_server.h"
+#include <algorithm>
+#include <arpa/inet.h>
+#include <chrono>
+#include <cstring>
+#include <netinet/in.h>
+#include <netinet/tcp.h>
+#include <spdlog/sinks/stdout_sinks.h>
+#include <spdlog/spdlog.h>
+#include <sys/socket.h>
+#include <thread>
+#include <unistd.h>
+#include <yaml-cpp/yaml.h>
+
+namespace acce {
+namespace recovery {
+
+namespace {
+constexpr size_t kBatchBytes = 64 * 1024;
+constexpr int kSessionPollMs = 200; // how quickly idle sessions notice stop()
+
+uint64_t mix(uint64_t value) {
+  value ^= value >> 33;
+  value *= 0xff51afd7ed558ccdULL;
+  value ^= value >> 33;
+  value *= 0xc4ceb9fe1a85ec53ULL;
+  value ^= value >> 33;
+  return value;
+}
+} // namespace
+
+MockRecoveryServer::MockRecoveryServer(Config config) : m_config(std::move(config)) {
+  m_logger = spdlog::get("tbt_mock_server");
+  if (!m_logger) {
+    m_logger = spdlog::stdout_logger_mt("tbt_mock_server");
+    m_logger->set_pattern("[%Y-%m-%d %H:%M:%S.%e] [%l] [%t] %v");
+  }
+}
+
+MockRecoveryServer::~MockRecoveryServer() {
+  stop();
+  while (m_active.load() > 0) {
+    std::this_thread::sleep_for(std::chrono::milliseconds(10));
+  }
+}
+
+bool MockRecoveryServer::loadConfig(const std::string &config_file, Config &config) {
+  try {
+    auto mock = YAML::LoadFile(config_file)["mock_server"];
+    config.listen_ip = mock["listen_ip"].as<std::string>(config.listen_ip);
+    config.port = mock["port"].as<uint16_t>(config.port);
+    if (mock["capture_files"]) {
+      config.capture_files = mock["capture_files"].as<std::vector<std::string>>();
+    }
+    config.generator_tokens = std::max(mock["generator_tokens"].as<uint32_t>(config.generator_tokens), 1u);
+    config.generator_trade_ratio = mock["generator_trade_ratio"].as<double>(config.generator_trade_ratio);
+    config.latency_us = mock["latency_us"].as<uint32_t>(config.latency_us);
+    config.max_msgs_per_sec = mock["max_msgs_per_sec"].as<uint64_t>(config.max_msgs_per_sec);
+    config.max_range = mock["max_range"].as<uint32_t>(config.max_range);
+    config.close_after_response = mock["close_after_response"].as<bool>(config.close_after_response);
+    config.fragment_bytes = mock["fragment_bytes"].as<uint32_t>(config.fragment_bytes);
+    config.disconnect_ratio = mock["disconnect_ratio"].as<double>(config.disconnect_ratio);
+    config.reject_ratio = mock["reject_ratio"].as<double>(config.reject_ratio);
+    config.reject_status = static_cast<uint8_t>(mock["reject_status"].as<uint32_t>(config.reject_status));
+    config.seed = mock["seed"].as<uint64_t>(config.seed);
+    return true;
+  } catch (const std::exception &e) {
+    spdlog::error("Failed to load mock server config from {}: {}", config_file, e.what());
+    return false;
+  }
+}
+
+bool MockRecoveryServer::start() {
+  if (!m_config.capture_files.empty() && !loadCaptures()) {
+    return false;
+  }
+
+  m_listen_fd = socket(AF_INET, SOCK_STREAM, 0);
+  if (m_listen_fd < 0) {
+    m_logger->error("Socket creation failed: {}", strerror(errno));
+    return false;
+  }
+  int reuse = 1;
+  setsockopt(m_listen_fd, SOL_SOCKET, SO_REUSEADDR, &reuse, sizeof(reuse));
+
+  struct sockaddr_in addr{};
+  addr.sin_family = AF_INET;
+  addr.sin_port = htons(m_config.port);
+  if (inet_pton(AF_INET, m_config.listen_ip.c_str(), &addr.sin_addr) <= 0 ||
+      bind(m_listen_fd, reinterpret_cast<sockaddr *>(&addr), sizeof(addr)) < 0 || listen(m_listen_fd, 64) < 0) {
+    m_logger->error("Failed to listen on {}:{}: {}", m_config.listen_ip, m_config.port, strerror(errno));
+    close(m_listen_fd);
+    m_listen_fd = -1;
+    return false;
+  }
+
+  // port 0 picks a free one, report what we got
+  socklen_t len = sizeof(addr);
+  getsockname(m_listen_fd, reinterpret_cast<sockaddr *>(&addr), &len);
+  m_config.port = ntohs(addr.sin_port);
+
+  m_running = true;
+  m_logger->info("Mock recovery server on {}:{} serving {}", m_config.listen_ip, m_config.port,
+                 m_captures.empty() ? "generated messages" : fmt::format("{} captured streams", m_streams.size()));
+  return true;
+}
+
+bool MockRecoveryServer::loadCaptures() {
+  for (const auto &path : m_config.capture_files) {
+    auto reader = std::make_unique<elaeo::foundation::capture::Reader>();
+    if (!reader->open(path)) {
+      m_logger->error("Failed to open capture {}: {}", path, reader->error());
+      return false;
+    }
+
+    size_t loaded = 0;
+    for (const auto record : *reader) {
+      if (record.kind() != elaeo::foundation::capture::RecordKind::Message ||
+          record.payload.size() < sizeof(StreamHeader)) {
+        continue;
+      }
+      StreamHeader header;
+      std::memcpy(&header, record.payload.data(), sizeof(header));
+
+      auto &stream = m_streams[header.stream_id];
+      if (stream.messages.empty()) {
+        stream.first_seq = header.seq_no;
+      } else if (header.seq_no < stream.first_seq) {
+        // make room in front, captures of one stream needn't be in order
+        const uint32_t shift = stream.first_seq - header.seq_no;
+        stream.messages.insert(stream.messages.begin(), shift, {});
+        stream.first_seq = header.seq_no;
+      }
+      const size_t slot = header.seq_no - stream.first_seq;
+      if (slot >= stream.messages.size()) {
+        stream.messages.resize(slot + 1);
+      }
+      stream.messages[slot] = record.payload;
+      ++loaded;
+    }
+    m_logger->info("Loaded {} messages from {}", loaded, path);
+    m_captures.push_back(std::move(reader));
+  }
+  return true;
+}
+
+void MockRecoveryServer::run() {
+  uint64_t session_id = 0;
+  while (m_running) {
+    const int fd = accept(m_listen_fd, nullptr, nullptr);
+    if (fd < 0) {
+      if (m_running && errno != EINTR) {
+        m_logger->error("Accept failed: {}", strerror(errno));
+      }
+      continue;
+    }
+
+    int nodelay = 1;
+    setsockopt(fd, IPPROTO_TCP, TCP_NODELAY, &nodelay, sizeof(nodelay));
+    struct timeval tv{0, kSessionPollMs * 1000};
+    setsockopt(fd, SOL_SOCKET, SO_RCVTIMEO, &tv, sizeof(tv));
+
+    ++m_stats.sessions;
+    ++m_active;
+    std::thread([this, fd, id = ++session_id] {
+      serveSession(fd, id);
+      close(fd);
+      --m_active;
+    }).detach();
+  }
+}
+
+void MockRecoveryServer::stop() {
+  if (m_running.exchange(false) && m_listen_fd >= 0) {
+    // wakes the accept in run()
+    shutdown(m_listen_fd, SHUT_RDWR);
+    close(m_listen_fd);
+    m_listen_fd = -1;
+  }
+}
+
+void MockRecoveryServer::serveSession(int fd, uint64_t session_id) {
+  std::mt19937_64 rng(m_config.seed ^ mix(session_id));
+  RecoveryRequestPacket request{};
+  size_t have = 0;
+
+  while (m_running) {
+    const ssize_t n = recv(fd, reinterpret_cast<uint8_t *>(&request) + have, sizeof(request) - have, 0);
+    if (n < 0 && (errno == EAGAIN || errno == EWOULDBLOCK || errno == EINTR)) {
+      continue;
+    }
+    if (n <= 0) {
+      return;
+    }
+    have += static_cast<size_t>(n);
+    if (have < sizeof(request)) {
+      continue;
+    }
+    have = 0;
+
+    if (request.msg_type != 'R') {
+      m_logger->warn("Session {}: unexpected request type {:#x}, closing", session_id, request.msg_type);
+      return;
+    }
+    if (!serveRequest(fd, request, rng) || m_config.close_after_response) {
+      return;
+    }
+  }
+}
+
+bool MockRecoveryServer::serveRequest(int fd, const RecoveryRequestPacket &request, std::mt19937_64 &rng) {
+  ++m_stats.requests;
+  const auto stream_id = static_cast<uint16_t>(request.stream_id);
+  std::uniform_real_distribution<double> chance(0.0, 1.0);
+
+  if (m_config.latency_us) {
+    std::this_thread::sleep_for(std::chrono::microseconds(m_config.latency_us));
+  }
+
+  const bool too_large = m_config.max_range && request.end_seq - request.start_seq + 1 > m_config.max_range;
+  if (request.end_seq < request.start_seq || too_large || chance(rng) < m_config.reject_ratio) {
+    ++m_stats.rejected;
+    m_logger->info("Rejecting stream {} [{}, {}] with status {}", stream_id, request.start_seq, request.end_seq,
+                   m_config.reject_status);
+    return sendResponse(fd, stream_id, m_config.reject_status);
+  }
+  if (!sendResponse(fd, stream_id, 0)) {
+    return false;
+  }
+
+  // a disconnect cuts the response off in the middle of one of its messages
+  uint64_t cut_at = UINT64_MAX;
+  if (chance(rng) < m_config.disconnect_ratio) {
+    cut_at = request.start_seq + rng() % (uint64_t{request.end_seq} - request.start_seq + 1);
+  }
+
+  std::vector<std::byte> batch;
+  batch.reserve(kBatchBytes + 0x10000);
+  std::vector<std::byte> scratch;
+  uint64_t sent = 0;
+  const auto started = std::chrono::steady_clock::now();
+
+  for (uint64_t seq = request.start_seq; seq <= request.end_seq && m_running; ++seq) {
+    const auto message = this->message(stream_id, static_cast<uint32_t>(seq), scratch);
+    if (message.empty()) {
+      continue; // not in the captures
+    }
+
+    if (seq == cut_at) {
+      batch.insert(batch.end(), message.begin(), message.begin() + message.size() / 2);
+      sendAll(fd, batch.data(), batch.size());
+      ++m_stats.disconnects;
+      m_logger->info("Disconnecting stream {} [{}, {}] at seq {}", stream_id, request.start_seq, request.end_seq, seq);
+      return false;
+    }
+
+    batch.insert(batch.end(), message.begin(), message.end());
+    ++sent;
+    if (batch.size() >= kBatchBytes || seq == request.end_seq) {
+      if (!sendAll(fd, batch.data(), batch.size())) {
+        return false;
+      }
+      m_stats.bytes += batch.size();
+      batch.clear();
+
+      if (m_config.max_msgs_per_sec) {
+        // pace to the cap, sleeping off whatever we are ahead of it
+        const auto due = started + std::chrono::nanoseconds(sent * 1000000000ULL / m_config.max_msgs_per_sec);
+        std::this_thread::sleep_until(due);
+      }
+    }
+  }
+  if (!batch.empty() && !sendAll(fd, batch.data(), batch.size())) {
+    return false;
+  }
+  m_stats.bytes += batch.size();
+  m_stats.messages += sent;
+  return true;
+}
+
+bool MockRecoveryServer::sendResponse(int fd, uint16_t stream_id, uint8_t status) {
+  RecoveryResponse response{};
+  response.header.msg_len = sizeof(RecoveryResponse);
+  response.header.stream_id = stream_id;
+  response.message_type = static_cast<uint8_t>(MessageType::Recovery);
+  response.req_status = status;
+  return sendAll(fd, reinterpret_cast<const std::byte *>(&response), sizeof(response));
+}
+
+bool MockRecoveryServer::sendAll(int fd, const std::byte *data, size_t length) {
+  const size_t piece = m_config.fragment_bytes ? m_config.fragment_bytes : length;
+  while (length > 0) {
+    const ssize_t n = send(fd, data, std::min(piece, length), MSG_NOSIGNAL);
+    if (n < 0) {
+      if (errno == EINTR) {
+        continue;
+      }
+      return false;
+    }
+    data += n;
+    length -= static_cast<size_t>(n);
+  }
+  return true;
+}
+
+std::span<const std::byte> MockRecoveryServer::message(uint16_t stream_id, uint32_t seq_no,
+                                                       std::vector<std::byte> &scratch) const {
+  if (m_captures.empty()) {
+    generate(stream_id, seq_no, scratch);
+    return scratch;
+  }
+  auto it = m_streams.find(stream_id);
+  if (it == m_streams.end() || seq_no < it->second.first_seq ||
+      seq_no - it->second.first_seq >= it->second.messages.size()) {
+    return {};
+  }
+  return it->second.messages[seq_no - it->second.first_seq];
+}
+
+void MockRecoveryServer::generate(uint16_t stream_id, uint32_t seq_no, std::vector<std::byte> &out) const {
+  // everything derives from (seed, stream, seq), so a range always comes back identical
+  const uint64_t bits = mix(m_config.seed ^ (uint64_t{stream_id} << 32 | seq_no));
+  const uint32_t token = 35000 + static_cast<uint32_t>(bits % m_config.generator_tokens);
+  const int32_t price = 100000 + static_cast<int32_t>((bits >> 20) % 2000) * 5;
+  const uint32_t quantity = 25 * (1 + static_cast<uint32_t>((bits >> 32) % 40));
+  const uint64_t timestamp = 1'700'000'000'000'000'000ULL + uint64_t{seq_no} * 1000;
+  const bool trade = static_cast<double>(bits >> 11) / static_cast<double>(1ULL << 53) < m_config.generator_trade_ratio;
+
+  if (trade) {
+    TradeMessage message{};
+    message.header = {sizeof(TradeMessage), stream_id, seq_no};
+    message.message_type = static_cast<uint8_t>(MessageType::Trade);
+    message.timestamp = timestamp;
+    message.buy_order_id = static_cast<double>(seq_no) * 2;
+    message.sell_order_id = static_cast<double>(seq_no) * 2 + 1;
+    message.token = token;
+    message.trade_price = static_cast<uint32_t>(price);
+    message.trade_quantity = quantity;
+    out.resize(sizeof(message));
+    std::memcpy(out.data(), &message, sizeof(message));
+    return;
+  }
+
+  static constexpr MessageType kOrderTypes[] = {MessageType::NewOrder, MessageType::NewOrder, MessageType::ModifyOrder,
+                                                MessageType::CancelOrder};
+  OrderMessage message{};
+  message.header = {sizeof(OrderMessage), stream_id, seq_no};
+  message.message_type = static_cast<uint8_t>(kOrderTypes[(bits >> 8) % 4]);
+  message.timestamp = timestamp;
+  message.order_id = static_cast<double>(seq_no);
+  message.token = token;
+  message.order_type = (bits >> 16) & 1 ? 'B' : 'S';
+  message.price = price;
+  message.quantity = quantity;
+  out.resize(sizeof(message));
+  std::memcpy(out.data(), &message, sizeof(message));
+}
+
+} // namespace recovery
+} // namespace acce
@@ -0,0 +1,51 @@
+#include "mock_recovery_server.h"
+#include <csignal>
+#include <iostream>
+#include <string>
+
+namespace {
+acce::recovery::MockRecoveryServer* g_server = nullptr;
+
+void signalHandler(int /*signum*/) {
+  if (g_server) {
+    g_server->stop();
+  }
+}
+} // namespace
+
+int main(int argc, char* argv[]) {
+  if (argc != 2) {
+    std::cout << "Usage: " << argv[0] << " <config_file>\n";
+    std::cout << "Serves TBT recovery requests on localhost as configured in the 'mock_server' section\n";
+    return 1;
+  }
+
+  try {
+    acce::recovery::MockRecoveryServer::Config config;
+    if (!acce::recovery::MockRecoveryServer::loadConfig(argv[1], config)) {
+      return 1;
+    }
+
+    acce::recovery::MockRecoveryServer server(config);
+    if (!server.start()) {
+      std::cerr << "Failed to start mock recovery server" << std::endl;
+      return 1;
+    }
+
+    g_server = &server;
+    std::signal(SIGINT, signalHandler);
+    std::signal(SIGTERM, signalHandler);
+
+    server.run();
+    g_server = nullptr;
+
+    const auto& stats = server.stats();
+    std::cout << "sessions=" << stats.sessions << " requests=" << stats.requests << " rejected=" << stats.rejected
+              << " disconnects=" << stats.disconnects << " messages=" << stats.messages << " bytes=" << stats.bytes
+              << std::endl;
+    return 0;
+  } catch (const std::exception& e) {
+    std::cerr << "Error: " << e.what() << std::endl;
+    return 1;
+  }
+}
@@ -0,0 +1,204 @@
+#include "recovery_scheduler.h"
+#include <algorithm>
+#include <chrono>
+#include <spdlog/spdlog.h>
+#include <thread>
+
+namespace acce {
+namespace recovery {
+
+namespace {
+// how many chunks may be buffered ahead of the emitter, per session.
+constexpr size_t kChunksAheadPerSession = 2;
+// rough size of a TBT order/trade message, used to pre-size chunk buffers.
+constexpr size_t kAvgMessageSize = 48;
+} // namespace
+
+RecoveryScheduler::RecoveryScheduler(const std::string &config_file) : m_config_file(config_file) {}
+
+RecoveryScheduler::~RecoveryScheduler() = default;
+
+bool RecoveryScheduler::initialize() {
+  auto first = std::make_unique<TbtRecoveryClient>(m_config_file);
+  if (m_store_disabled) {
+    first->disableRecoveryStore();
+  }
+  if (!first->initialize()) {
+    return false;
+  }
+
+  // the session budget is shared by all segments, take the largest configured one.
+  uint32_t sessions = m_max_sessions_override;
+  if (sessions == 0) {
+    for (auto segment : {Segment::CM, Segment::FO, Segment::CD, Segment::CO}) {
+      if (const auto *cfg = first->segmentConfig(segment)) {
+        sessions = std::max(sessions, cfg->max_sessions);
+      }
+    }
+  }
+  sessions = std::max(sessions, 1u);
+
+  // all sessions draw on the first client's connection pool and local store
+  auto pool = first->sessionPool();
+  auto store = first->recoveryStore();
+  m_clients.push_back(std::move(first));
+  while (m_clients.size() < sessions) {
+    auto client = std::make_unique<TbtRecoveryClient>(m_config_file);
+    client->setSessionPool(pool);
+    client->setRecoveryStore(store);
+    if (m_store_disabled) {
+      client->disableRecoveryStore();
+    }
+    if (!client->initialize()) {
+      return false;
+    }
+    m_clients.push_back(std::move(client));
+  }
+
+  spdlog::get("tbt_recovery")->info("Recovery scheduler initialized with {} sessions", m_clients.size());
+  return true;
+}
+
+bool RecoveryScheduler::requestRecovery(const RecoveryRequest &request) {
+  auto logger = spdlog::get("tbt_recovery");
+  const auto *config = m_clients.empty() ? nullptr : m_clients.front()->segmentConfig(request.segment);
+  if (!config || request.end_seq < request.start_seq) {
+    logger->error("Invalid recovery request: segment {} range [{}, {}]", static_cast<int>(request.segment),
+                  request.start_seq, request.end_seq);
+    return false;
+  }
+
+  const auto start_time = std::chrono::steady_clock::now();
+
+  // split the range into chunks
+  const uint64_t range = static_cast<uint64_t>(request.end_seq) - request.start_seq + 1;
+  const uint64_t chunk_size = m_chunk_size_override ? m_chunk_size_override
+                              : config->chunk_size  ? config->chunk_size
+                                                    : range;
+  m_chunks.clear();
+  m_chunks.resize((range + chunk_size - 1) / chunk_size);
+  for (size_t i = 0; i < m_chunks.size(); ++i) {
+    m_chunks[i].start_seq = static_cast<uint32_t>(request.start_seq + i * chunk_size);
+    m_chunks[i].end_seq = static_cast<uint32_t>(
+        std::min<uint64_t>(request.end_seq, request.start_seq + (i + 1) * chunk_size - 1));
+  }
+
+  const size_t sessions = std::min(m_clients.size(), m_chunks.size());
+  m_next_chunk = 0;
+  m_next_emit = 0;
+  m_window = sessions * kChunksAheadPerSession;
+  m_abort = false;
+  m_stats = Stats{0, 0, static_cast<uint32_t>(m_chunks.size()), static_cast<uint32_t>(sessions), 0.0};
+
+  logger->info("Scheduling recovery stream {} [{}, {}] as {} chunks over {} sessions", request.stream_id,
+               request.start_seq, request.end_seq, m_chunks.size(), sessions);
+
+  std::vector<std::thread> workers;
+  workers.reserve(sessions);
+  for (size_t i = 0; i < sessions; ++i) {
+    workers.emplace_back([this, i, &request] { runSession(*m_clients[i], request); });
+  }
+
+  // emit chunks in order on the caller's thread while later chunks are still in flight
+  bool ok = true;
+  for (size_t idx = 0; idx < m_chunks.size(); ++idx) {
+    {
+      std::unique_lock<std::mutex> lock(m_mutex);
+      m_cv.wait(lock, [&] { return m_chunks[idx].done || m_abort; });
+      if (!m_chunks[idx].done || !m_chunks[idx].ok) {
+        ok = false;
+        m_abort = true;
+        break;
+      }
+    }
+
+    emitChunk(m_chunks[idx]);
+    m_chunks[idx].data = {};
+    m_chunks[idx].offsets = {};
+
+    {
+      std::lock_guard<std::mutex> lock(m_mutex);
+      ++m_next_emit;
+    }
+    m_cv.notify_all();
+  }
+  m_cv.notify_all();
+
+  for (auto &worker : workers) {
+    worker.join();
+  }
+
+  m_stats.elapsed_ms =
+      std::chrono::duration<double, std::milli>(std::chrono::steady_clock::now() - start_time).count();
+  if (ok) {
+    logger->info("Recovered {} messages ({} bytes) in {:.1f} ms", m_stats.messages, m_stats.bytes,
+                 m_stats.elapsed_ms);
+  } else {
+    logger->error("Pipelined recovery for stream {} failed after {} messages", request.stream_id,
+                  m_stats.messages);
+  }
+  return ok;
+}
+
+void RecoveryScheduler::runSession(TbtRecoveryClient &client, const RecoveryRequest &request) {
+  while (true) {
+    const size_t idx = m_next_chunk.fetch_add(1);
+    if (idx >= m_chunks.size()) {
+      return;
+    }
+
+    // don't run too far ahead of the emitter, buffered chunks cost memory
+    {
+      std::unique_lock<std::mutex> lock(m_mutex);
+      m_cv.wait(lock, [&] { return m_abort || idx < m_next_emit + m_window; });
+      if (m_abort) {
+        return;
+      }
+    }
+
+    // the chunk is owned by this session until it is marked done
+    Chunk &chunk = m_chunks[idx];
+    chunk.data.reserve(static_cast<size_t>(chunk.end_seq - chunk.start_seq + 1) * kAvgMessageSize);
+    RecoveryRequest sub_request = request;
+    sub_request.start_seq = chunk.start_seq;
+    sub_request.end_seq = chunk.end_seq;
+    const bool ok = client.requestRecovery(sub_request, [&chunk](const StreamHeader &, MessageView message) {
+      chunk.offsets.push_back(static_cast<uint32_t>(chunk.data.size()));
+      chunk.data.insert(chunk.data.end(), message.begin(), message.end());
+    });
+
+    {
+      std::lock_guard<std::mutex> lock(m_mutex);
+      chunk.ok = ok;
+      chunk.done = true;
+      if (!ok) {
+        m_abort = true;
+      }
+    }
+    m_cv.notify_all();
+
+    if (!ok) {
+      return;
+    }
+  }
+}
+
+void RecoveryScheduler::emitChunk(const Chunk &chunk) {
+  for (size_t i = 0; i < chunk.offsets.size(); ++i) {
+    const uint32_t begin = chunk.offsets[i];
+    const uint32_t end = i + 1 < chunk.offsets.size() ? chunk.offsets[i + 1] : static_cast<uint32_t>(chunk.data.size());
+    m_stats.messages++;
+    m_stats.bytes += end - begin;
+    if (m_callback) {
+      // messages are stored whole, the header is read back in place
+      const MessageView message(chunk.data.data() + begin, end - begin);
+      m_callback(*reinterpret_cast<const StreamHeader *>(message.data()), message);
+    }
+  }
+  if (m_batch_callback && !chunk.data.empty()) {
+    m_batch_callback(MessageView(chunk.data.data(), chunk.data.size()));
+  }
+}
+
+} // namespace recovery
+} // namespace acce
@@ -0,0 +1,203 @@
+#include "recovery_session_pool.h"
+#include <algorithm>
+#include <spdlog/spdlog.h>
+
+namespace acce {
+namespace recovery {
+
+RecoverySessionPool::RecoverySessionPool(const std::unordered_map<Segment, RecoveryConfig> &configs) {
+  for (const auto &[segment, config] : configs) {
+    auto &pool = m_pools[segment];
+    pool.config = config;
+    pool.endpoints.push_back({config.server_ip, config.server_port});
+    pool.endpoints.insert(pool.endpoints.end(), config.failover.begin(), config.failover.end());
+  }
+}
+
+RecoverySessionPool::~RecoverySessionPool() { stop(); }
+
+void RecoverySessionPool::start() {
+  std::lock_guard<std::mutex> lock(m_mutex);
+  if (!m_threads.empty()) {
+    return;
+  }
+  m_stop = false;
+  // one thread per segment fills it straight away, an unreachable segment holds up neither
+  // startup nor the other segments
+  for (auto &[segment, pool] : m_pools) {
+    m_threads.emplace_back([this, &pool = pool] { maintain(pool); });
+  }
+}
+
+void RecoverySessionPool::stop() {
+  {
+    std::lock_guard<std::mutex> lock(m_mutex);
+    m_stop = true;
+  }
+  m_cv.notify_all();
+  for (auto &thread : m_threads) {
+    thread.join();
+  }
+  m_threads.clear();
+}
+
+std::unique_ptr<TcpConnection> RecoverySessionPool::acquire(Segment segment) {
+  auto it = m_pools.find(segment);
+  if (it == m_pools.end()) {
+    return nullptr;
+  }
+  auto &pool = it->second;
+  auto logger = spdlog::get("tbt_recovery");
+
+  std::unique_lock<std::mutex> lock(m_mutex);
+  for (uint32_t attempt = 0; !m_stop;) {
+    while (!pool.idle.empty()) {
+      auto connection = std::move(pool.idle.front());
+      pool.idle.pop_front();
+      if (connection->healthy()) {
+        return connection;
+      }
+      --pool.open;
+      logger->info("Dropping stale pooled session to {}:{}", connection->ip(), connection->port());
+    }
+
+    // every session the exchange allows is open, wait for one to come back or close
+    if (pool.open >= sessionLimit(pool)) {
+      m_cv.wait(lock, [this, &pool] { return m_stop || !pool.idle.empty() || pool.open < sessionLimit(pool); });
+      continue;
+    }
+
+    // nothing pooled, connect inline with bounded backoff
+    ++pool.open;
+    lock.unlock();
+    if (auto connection = connectOnce(pool)) {
+      return connection;
+    }
+    if (attempt == pool.config.max_retries) {
+      lock.lock();
+      break;
+    }
+
+    const auto delay = backoff(pool.config, attempt++);
+    logger->warn("No recovery server reachable for segment {}, retry {}/{} in {}ms", static_cast<int>(segment),
+                 attempt, pool.config.max_retries, delay.count());
+    lock.lock();
+    m_cv.wait_for(lock, delay, [this] { return m_stop.load(); });
+  }
+  lock.unlock();
+
+  logger->error("Giving up on segment {} after {} connect rounds", static_cast<int>(segment),
+                pool.config.max_retries + 1);
+  return nullptr;
+}
+
+void RecoverySessionPool::release(Segment segment, std::unique_ptr<TcpConnection> connection, bool reusable) {
+  auto it = m_pools.find(segment);
+  if (!connection || it == m_pools.end()) {
+    return;
+  }
+
+  {
+    std::lock_guard<std::mutex> lock(m_mutex);
+    auto &pool = it->second;
+    if (reusable && connection->healthy() && pool.idle.size() < pool.config.pool_size) {
+      pool.idle.push_back(std::move(connection));
+    } else {
+      --pool.open;
+    }
+  }
+  // a closed session makes room for the refill or a waiting acquire()
+  connection.reset();
+  m_cv.notify_all();
+}
+
+size_t RecoverySessionPool::idle(Segment segment) const {
+  std::lock_guard<std::mutex> lock(m_mutex);
+  auto it = m_pools.find(segment);
+  return it == m_pools.end() ? 0 : it->second.idle.size();
+}
+
+std::unique_ptr<TcpConnection> RecoverySessionPool::connectOnce(SegmentPool &pool) {
+  size_t first;
+  {
+    std::lock_guard<std::mutex> lock(m_mutex);
+    first = pool.preferred;
+  }
+
+  auto logger = spdlog::get("tbt_recovery");
+  for (size_t i = 0; i < pool.endpoints.size(); ++i) {
+    const size_t index = (first + i) % pool.endpoints.size();
+    const auto &endpoint = pool.endpoints[index];
+
+    auto connection = std::make_unique<TcpConnection>();
+    if (connection->connect(endpoint.ip, endpoint.port, pool.config.timeout_ms, &m_stop)) {
+      if (index != first) {
+        logger->warn("Failing over to recovery server {}:{}", endpoint.ip, endpoint.port);
+      }
+      std::lock_guard<std::mutex> lock(m_mutex);
+      pool.preferred = index;
+      return connection;
+    }
+    if (m_stop) {
+      break;
+    }
+    logger->error("Failed to connect to recovery server {}:{}", endpoint.ip, endpoint.port);
+  }
+
+  {
+    std::lock_guard<std::mutex> lock(m_mutex);
+    --pool.open;
+  }
+  m_cv.notify_all();
+  return nullptr;
+}
+
+size_t RecoverySessionPool::sessionLimit(const SegmentPool &pool) {
+  return std::max(pool.config.max_sessions, 1u);
+}
+
+std::chrono::milliseconds RecoverySessionPool::backoff(const RecoveryConfig &config, uint32_t failures) const {
+  const uint64_t delay = static_cast<uint64_t>(config.retry_backoff_ms) << std::min(failures, 16u);
+  return std::chrono::milliseconds(std::min<uint64_t>(delay, config.retry_backoff_max_ms));
+}
+
+void RecoverySessionPool::maintain(SegmentPool &pool) {
+  const auto interval = std::chrono::milliseconds(std::max(pool.config.health_check_ms, 1u));
+
+  std::unique_lock<std::mutex> lock(m_mutex);
+  for (; !m_stop; m_cv.wait_for(lock, interval)) {
+    // drop sessions the server closed or reset while they sat idle
+    auto dead = std::remove_if(pool.idle.begin(), pool.idle.end(),
+                               [](const auto &connection) { return !connection->healthy(); });
+    if (dead != pool.idle.end()) {
+      pool.open -= static_cast<size_t>(pool.idle.end() - dead);
+      pool.idle.erase(dead, pool.idle.end());
+      m_cv.notify_all(); // room for a waiting acquire()
+    }
+
+    const auto now = std::chrono::steady_clock::now();
+    if (now < pool.next_refill) {
+      continue;
+    }
+
+    // borrowed sessions count too, the segment never goes past pool_size open
+    const size_t target = std::min<size_t>(pool.config.pool_size, sessionLimit(pool));
+    while (!m_stop && pool.open < target) {
+      // connect without holding the lock, acquire() and release() must not wait on a handshake
+      ++pool.open;
+      lock.unlock();
+      auto connection = connectOnce(pool);
+      lock.lock();
+
+      if (!connection) {
+        pool.next_refill = now + backoff(pool.config, pool.failures++);
+        break;
+      }
+      pool.failures = 0;
+      pool.idle.push_back(std::move(connection));
+    }
+  }
+}
+
+} // namespace recovery
+} // namespace acce
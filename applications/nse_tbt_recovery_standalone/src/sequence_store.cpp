@@ -0,0 +1,251 @@
+#include "sequence_store.h"
+#include <algorithm>
+#include <chrono>
+#include <cstring>
+#include <ctime>
+#include <fcntl.h>
+#include <filesystem>
+#include <fmt/format.h>
+#include <spdlog/spdlog.h>
+#include <sys/file.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <unistd.h>
+
+namespace acce {
+namespace recovery {
+
+namespace {
+constexpr uint64_t kMagic = 0x5154534f54424e41ULL; // "ANBTOSTQ"
+constexpr uint32_t kVersion = 1;
+constexpr uint64_t kHeaderBytes = 4096;
+constexpr uint64_t kMaxEntries = uint64_t{1} << 32;
+constexpr uint64_t kIndexGrowEntries = uint64_t{1} << 20; // 8 MiB of index at a time
+constexpr uint64_t kDataGrowBytes = uint64_t{64} << 20;
+
+uint64_t roundUp(uint64_t value, uint64_t step) { return (value + step - 1) / step * step; }
+
+uint64_t fileSize(int fd) {
+  struct stat st{};
+  return fstat(fd, &st) == 0 ? static_cast<uint64_t>(st.st_size) : 0;
+}
+} // namespace
+
+struct SequenceStore::FileHeader {
+  uint64_t magic;
+  uint32_t version;
+  uint32_t reserved;
+  uint64_t data_end; // bytes of .dat handed out so far, advanced atomically
+};
+
+SequenceStore::~SequenceStore() { close(); }
+
+bool SequenceStore::open(const std::string &stem, uint64_t max_data_bytes) {
+  close();
+  auto logger = spdlog::get("tbt_recovery");
+
+  m_index_fd = ::open((stem + ".idx").c_str(), O_RDWR | O_CREAT, 0644);
+  m_data_fd = ::open((stem + ".dat").c_str(), O_RDWR | O_CREAT, 0644);
+  if (m_index_fd < 0 || m_data_fd < 0) {
+    logger->error("Failed to open sequence store {}: {}", stem, strerror(errno));
+    close();
+    return false;
+  }
+
+  // whoever gets here first lays out the header, the others wait for it
+  flock(m_index_fd, LOCK_EX);
+  if (fileSize(m_index_fd) < kHeaderBytes) {
+    if (posix_fallocate(m_index_fd, 0, kHeaderBytes) != 0) {
+      flock(m_index_fd, LOCK_UN);
+      logger->error("Failed to size sequence store {}", stem);
+      close();
+      return false;
+    }
+    const FileHeader header{kMagic, kVersion, 0, 0};
+    pwrite(m_index_fd, &header, sizeof(header), 0);
+  }
+  flock(m_index_fd, LOCK_UN);
+
+  const uint64_t index_reserved = kHeaderBytes + kMaxEntries * sizeof(uint64_t);
+  void *index = mmap(nullptr, index_reserved, PROT_READ | PROT_WRITE, MAP_SHARED | MAP_NORESERVE, m_index_fd, 0);
+  void *data = mmap(nullptr, max_data_bytes, PROT_READ | PROT_WRITE, MAP_SHARED | MAP_NORESERVE, m_data_fd, 0);
+  if (index == MAP_FAILED || data == MAP_FAILED) {
+    logger->error("Failed to map sequence store {}: {}", stem, strerror(errno));
+    if (index != MAP_FAILED) {
+      munmap(index, index_reserved);
+    }
+    if (data != MAP_FAILED) {
+      munmap(data, max_data_bytes);
+    }
+    close();
+    return false;
+  }
+
+  m_index_map = static_cast<uint8_t *>(index);
+  m_data_map = static_cast<std::byte *>(data);
+  m_data_reserved = max_data_bytes;
+  m_header = reinterpret_cast<FileHeader *>(m_index_map);
+  m_index_size = fileSize(m_index_fd);
+  m_data_size = fileSize(m_data_fd);
+
+  if (m_header->magic != kMagic || m_header->version != kVersion) {
+    logger->error("{}.idx is not a version {} sequence store", stem, kVersion);
+    close();
+    return false;
+  }
+  return true;
+}
+
+void SequenceStore::close() {
+  if (m_index_map) {
+    munmap(m_index_map, kHeaderBytes + kMaxEntries * sizeof(uint64_t));
+  }
+  if (m_data_map) {
+    munmap(m_data_map, m_data_reserved);
+  }
+  if (m_index_fd >= 0) {
+    ::close(m_index_fd);
+  }
+  if (m_data_fd >= 0) {
+    ::close(m_data_fd);
+  }
+  m_index_map = nullptr;
+  m_data_map = nullptr;
+  m_header = nullptr;
+  m_index_fd = -1;
+  m_data_fd = -1;
+}
+
+uint64_t *SequenceStore::entry(uint32_t seq_no) const {
+  return reinterpret_cast<uint64_t *>(m_index_map + kHeaderBytes) + seq_no;
+}
+
+bool SequenceStore::ensureIndex(uint32_t seq_no) {
+  const uint64_t need = kHeaderBytes + (uint64_t{seq_no} + 1) * sizeof(uint64_t);
+  if (need <= m_index_size.load(std::memory_order_acquire)) {
+    return true;
+  }
+
+  std::lock_guard<std::mutex> lock(m_grow_mutex);
+  uint64_t size = fileSize(m_index_fd);
+  if (size < need) {
+    // posix_fallocate only ever grows the file, racing processes can't truncate each other
+    size = kHeaderBytes + roundUp(need - kHeaderBytes, kIndexGrowEntries * sizeof(uint64_t));
+    if (posix_fallocate(m_index_fd, 0, static_cast<off_t>(size)) != 0) {
+      return false;
+    }
+  }
+  m_index_size.store(size, std::memory_order_release);
+  return true;
+}
+
+bool SequenceStore::ensureData(uint64_t end) {
+  if (end <= m_data_size.load(std::memory_order_acquire)) {
+    return true;
+  }
+
+  std::lock_guard<std::mutex> lock(m_grow_mutex);
+  uint64_t size = fileSize(m_data_fd);
+  if (size < end) {
+    size = std::min(roundUp(end, kDataGrowBytes), m_data_reserved);
+    if (posix_fallocate(m_data_fd, 0, static_cast<off_t>(size)) != 0) {
+      return false;
+    }
+  }
+  m_data_size.store(size, std::memory_order_release);
+  return true;
+}
+
+bool SequenceStore::append(const StreamHeader &header, std::span<const std::byte> message) {
+  if (!m_header || message.size() < sizeof(StreamHeader) || message.size() > 0xFFFF || !ensureIndex(header.seq_no)) {
+    return false;
+  }
+
+  std::atomic_ref<uint64_t> slot(*entry(header.seq_no));
+  if (slot.load(std::memory_order_acquire) != 0) {
+    return false; // already stored, by us or another process
+  }
+
+  const uint64_t offset =
+      std::atomic_ref<uint64_t>(m_header->data_end).fetch_add(message.size(), std::memory_order_relaxed);
+  if (offset + message.size() > m_data_reserved || !ensureData(offset + message.size())) {
+    spdlog::get("tbt_recovery")->error("Sequence store full, dropping seq {}", header.seq_no);
+    return false;
+  }
+  std::memcpy(m_data_map + offset, message.data(), message.size());
+
+  // publish last, a reader that sees the entry sees the bytes
+  uint64_t expected = 0;
+  return slot.compare_exchange_strong(expected, offset << 16 | message.size(), std::memory_order_release,
+                                      std::memory_order_relaxed);
+}
+
+std::span<const std::byte> SequenceStore::find(uint32_t seq_no) {
+  if (!m_header) {
+    return {};
+  }
+
+  const uint64_t need = kHeaderBytes + (uint64_t{seq_no} + 1) * sizeof(uint64_t);
+  if (need > m_index_size.load(std::memory_order_acquire)) {
+    // another process may have grown the index
+    std::lock_guard<std::mutex> lock(m_grow_mutex);
+    m_index_size.store(std::max(m_index_size.load(), fileSize(m_index_fd)), std::memory_order_release);
+    if (need > m_index_size.load()) {
+      return {};
+    }
+  }
+
+  const uint64_t value = std::atomic_ref<uint64_t>(*entry(seq_no)).load(std::memory_order_acquire);
+  if (value == 0) {
+    return {};
+  }
+  return {m_data_map + (value >> 16), static_cast<size_t>(value & 0xFFFF)};
+}
+
+std::vector<std::pair<uint32_t, uint32_t>> SequenceStore::missing(uint32_t start_seq, uint32_t end_seq) {
+  std::vector<std::pair<uint32_t, uint32_t>> gaps;
+  for (uint64_t seq = start_seq; seq <= end_seq; ++seq) {
+    if (contains(static_cast<uint32_t>(seq))) {
+      continue;
+    }
+    if (!gaps.empty() && gaps.back().second + 1 == seq) {
+      gaps.back().second = static_cast<uint32_t>(seq);
+    } else {
+      gaps.emplace_back(static_cast<uint32_t>(seq), static_cast<uint32_t>(seq));
+    }
+  }
+  return gaps;
+}
+
+uint64_t SequenceStore::dataBytes() const {
+  return m_header ? std::atomic_ref<uint64_t>(m_header->data_end).load(std::memory_order_relaxed) : 0;
+}
+
+RecoveryStore::RecoveryStore(std::string directory, uint64_t max_data_bytes)
+    : m_directory(std::move(directory)), m_max_data_bytes(max_data_bytes) {}
+
+SequenceStore *RecoveryStore::stream(std::string_view segment, uint16_t stream_id) {
+  // sequence numbers restart every trading day, so does the store
+  const std::time_t now = std::chrono::system_clock::to_time_t(std::chrono::system_clock::now());
+  std::tm local{};
+  localtime_r(&now, &local);
+  const std::string name = fmt::format("{}_{}_{:04}{:02}{:02}", segment, stream_id, local.tm_year + 1900,
+                                       local.tm_mon + 1, local.tm_mday);
+
+  std::lock_guard<std::mutex> lock(m_mutex);
+  auto &store = m_streams[name];
+  if (!store) {
+    std::error_code ec;
+    std::filesystem::create_directories(m_directory, ec);
+    auto opened = std::make_unique<SequenceStore>();
+    if (!opened->open((std::filesystem::path(m_directory) / name).string(), m_max_data_bytes)) {
+      m_streams.erase(name);
+      return nullptr;
+    }
+    store = std::move(opened);
+  }
+  return store.get();
+}
+
+} // namespace recovery
+} // namespace acce
@@ -0,0 +1,223 @@
+#include "tbt_batch_decoder.h"
+#include <array>
+#include <cstring>
+
+#if defined(__x86_64__) || defined(__i386__)
+#include <immintrin.h>
+#define TBT_BATCH_AVX2 1
+#endif
+
+namespace acce {
+namespace recovery {
+
+namespace {
+constexpr size_t kLanes = 32;
+
+enum class Class : uint8_t { Other, Order, Trade };
+
+constexpr std::array<Class, 256> makeClasses() {
+  std::array<Class, 256> classes{};
+  for (auto type : {MessageType::NewOrder, MessageType::ModifyOrder, MessageType::CancelOrder,
+                    MessageType::SpreadNewOrder, MessageType::SpreadModifyOrder, MessageType::SpreadCancelOrder}) {
+    classes[static_cast<uint8_t>(type)] = Class::Order;
+  }
+  for (auto type : {MessageType::Trade, MessageType::SpreadTrade}) {
+    classes[static_cast<uint8_t>(type)] = Class::Trade;
+  }
+  return classes;
+}
+
+constexpr std::array<Class, 256> kClasses = makeClasses();
+
+// types is padded to a multiple of kLanes, orders / trades are sized to count
+void classifyScalar(const uint8_t *types, size_t count, uint32_t *orders, size_t &num_orders, uint32_t *trades,
+                    size_t &num_trades) {
+  for (size_t i = 0; i < count; ++i) {
+    const Class cls = kClasses[types[i]];
+    // branch free, both slots are written and only the matching count advances
+    orders[num_orders] = static_cast<uint32_t>(i);
+    trades[num_trades] = static_cast<uint32_t>(i);
+    num_orders += cls == Class::Order;
+    num_trades += cls == Class::Trade;
+  }
+}
+
+#ifdef TBT_BATCH_AVX2
+// Compiled for AVX2 regardless of the build's -march, only called once the CPU is known to have it
+__attribute__((target("avx2"))) void classifyAvx2(const uint8_t *types, size_t count, uint32_t *orders,
+                                                  size_t &num_orders, uint32_t *trades, size_t &num_trades) {
+  const __m256i new_order = _mm256_set1_epi8(static_cast<char>(MessageType::NewOrder));
+  const __m256i modify = _mm256_set1_epi8(static_cast<char>(MessageType::ModifyOrder));
+  const __m256i cancel = _mm256_set1_epi8(static_cast<char>(MessageType::CancelOrder));
+  const __m256i spread_new = _mm256_set1_epi8(static_cast<char>(MessageType::SpreadNewOrder));
+  const __m256i spread_modify = _mm256_set1_epi8(static_cast<char>(MessageType::SpreadModifyOrder));
+  const __m256i spread_cancel = _mm256_set1_epi8(static_cast<char>(MessageType::SpreadCancelOrder));
+  const __m256i trade = _mm256_set1_epi8(static_cast<char>(MessageType::Trade));
+  const __m256i spread_trade = _mm256_set1_epi8(static_cast<char>(MessageType::SpreadTrade));
+
+  // the zero padding past count never matches a type
+  for (size_t base = 0; base < count; base += kLanes) {
+    const __m256i v = _mm256_loadu_si256(reinterpret_cast<const __m256i *>(types + base));
+    const __m256i order = _mm256_or_si256(
+        _mm256_or_si256(_mm256_or_si256(_mm256_cmpeq_epi8(v, new_order), _mm256_cmpeq_epi8(v, modify)),
+                        _mm256_or_si256(_mm256_cmpeq_epi8(v, cancel), _mm256_cmpeq_epi8(v, spread_new))),
+        _mm256_or_si256(_mm256_cmpeq_epi8(v, spread_modify), _mm256_cmpeq_epi8(v, spread_cancel)));
+    const __m256i trades_v = _mm256_or_si256(_mm256_cmpeq_epi8(v, trade), _mm256_cmpeq_epi8(v, spread_trade));
+
+    for (uint32_t mask = static_cast<uint32_t>(_mm256_movemask_epi8(order)); mask != 0; mask &= mask - 1) {
+      orders[num_orders++] = static_cast<uint32_t>(base + __builtin_ctz(mask));
+    }
+    for (uint32_t mask = static_cast<uint32_t>(_mm256_movemask_epi8(trades_v)); mask != 0; mask &= mask - 1) {
+      trades[num_trades++] = static_cast<uint32_t>(base + __builtin_ctz(mask));
+    }
+  }
+}
+#endif
+
+uint16_t lengthAt(const uint8_t *data, size_t offset) {
+  uint16_t length;
+  std::memcpy(&length, data + offset, sizeof(length));
+  return length;
+}
+} // namespace
+
+void TbtBatchDecoder::OrderColumns::resize(size_t n) {
+  seq_no.resize(n);
+  stream_id.resize(n);
+  type.resize(n);
+  timestamp.resize(n);
+  order_id.resize(n);
+  token.resize(n);
+  side.resize(n);
+  price.resize(n);
+  quantity.resize(n);
+}
+
+void TbtBatchDecoder::TradeColumns::resize(size_t n) {
+  seq_no.resize(n);
+  stream_id.resize(n);
+  type.resize(n);
+  timestamp.resize(n);
+  buy_order_id.resize(n);
+  sell_order_id.resize(n);
+  token.resize(n);
+  price.resize(n);
+  quantity.resize(n);
+}
+
+bool TbtBatchDecoder::vectorized() {
+#ifdef TBT_BATCH_AVX2
+  static const bool avx2 = __builtin_cpu_supports("avx2");
+  return avx2;
+#else
+  return false;
+#endif
+}
+
+size_t TbtBatchDecoder::decode(std::span<const std::byte> data) {
+  const auto *bytes = reinterpret_cast<const uint8_t *>(data.data());
+  const size_t consumed = index(bytes, data.size());
+  classify();
+  decodeOrders(bytes);
+  decodeTrades(bytes);
+
+  m_stats.messages += m_offsets.size();
+  m_stats.orders += m_orders.size();
+  m_stats.trades += m_trades.size();
+  m_stats.other += m_offsets.size() - m_order_idx.size() - m_trade_idx.size();
+  m_stats.bytes += consumed;
+  return consumed;
+}
+
+size_t TbtBatchDecoder::index(const uint8_t *data, size_t size) {
+  m_offsets.clear();
+  m_types.clear();
+
+  size_t offset = 0;
+  while (size - offset > sizeof(StreamHeader)) {
+    const uint16_t length = lengthAt(data, offset);
+    if (length <= sizeof(StreamHeader) || length > size - offset) {
+      break; // malformed, or the message continues past the buffer
+    }
+    m_offsets.push_back(static_cast<uint32_t>(offset));
+    m_types.push_back(data[offset + sizeof(StreamHeader)]);
+    offset += length;
+  }
+
+  m_types.resize((m_offsets.size() + kLanes - 1) / kLanes * kLanes, 0);
+  return offset;
+}
+
+void TbtBatchDecoder::classify() {
+  const size_t count = m_offsets.size();
+  m_order_idx.resize(count);
+  m_trade_idx.resize(count);
+  size_t num_orders = 0;
+  size_t num_trades = 0;
+
+#ifdef TBT_BATCH_AVX2
+  if (vectorized()) {
+    classifyAvx2(m_types.data(), count, m_order_idx.data(), num_orders, m_trade_idx.data(), num_trades);
+  } else
+#endif
+  {
+    classifyScalar(m_types.data(), count, m_order_idx.data(), num_orders, m_trade_idx.data(), num_trades);
+  }
+
+  m_order_idx.resize(num_orders);
+  m_trade_idx.resize(num_trades);
+}
+
+void TbtBatchDecoder::decodeOrders(const uint8_t *data) {
+  m_orders.resize(m_order_idx.size());
+  size_t n = 0;
+  for (const uint32_t idx : m_order_idx) {
+    const uint32_t offset = m_offsets[idx];
+    if (lengthAt(data, offset) < sizeof(OrderMessage)) {
+      ++m_stats.truncated;
+      continue;
+    }
+    // copy the packed wire struct out rather than overlaying it on a possibly unaligned buffer
+    OrderMessage order;
+    std::memcpy(&order, data + offset, sizeof(order));
+    m_orders.seq_no[n] = order.header.seq_no;
+    m_orders.stream_id[n] = order.header.stream_id;
+    m_orders.type[n] = order.message_type;
+    m_orders.timestamp[n] = order.timestamp;
+    m_orders.order_id[n] = order.order_id;
+    m_orders.token[n] = order.token;
+    m_orders.side[n] = order.order_type;
+    m_orders.price[n] = order.price;
+    m_orders.quantity[n] = order.quantity;
+    ++n;
+  }
+  m_orders.resize(n);
+}
+
+void TbtBatchDecoder::decodeTrades(const uint8_t *data) {
+  m_trades.resize(m_trade_idx.size());
+  size_t n = 0;
+  for (const uint32_t idx : m_trade_idx) {
+    const uint32_t offset = m_offsets[idx];
+    if (lengthAt(data, offset) < sizeof(TradeMessage)) {
+      ++m_stats.truncated;
+      continue;
+    }
+    TradeMessage trade;
+    std::memcpy(&trade, data + offset, sizeof(trade));
+    m_trades.seq_no[n] = trade.header.seq_no;
+    m_trades.stream_id[n] = trade.header.stream_id;
+    m_trades.type[n] = trade.message_type;
+    m_trades.timestamp[n] = trade.timestamp;
+    m_trades.buy_order_id[n] = trade.buy_order_id;
+    m_trades.sell_order_id[n] = trade.sell_order_id;
+    m_trades.token[n] = trade.token;
+    m_trades.price[n] = trade.trade_price;
+    m_trades.quantity[n] = trade.trade_quantity;
+    ++n;
+  }
+  m_trades.resize(n);
+}
+
+} // namespace recovery
+} // namespace acce
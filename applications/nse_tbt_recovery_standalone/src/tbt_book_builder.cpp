@@ -0,0 +1,132 @@
+#include "tbt_book_builder.h"
+#include <cstring>
+#include <spdlog/spdlog.h>
+#include <yaml-cpp/yaml.h>
+
+namespace acce {
+namespace recovery {
+
+using elaeo::business::orderbook::BookType;
+using elaeo::business::orderbook::Side;
+
+TbtBookBuilder::TbtBookBuilder(size_t expected_orders, size_t expected_tokens)
+    : m_book(expected_orders, expected_tokens), m_implied(m_book) {
+  m_book.setTopListener([this](const elaeo::business::orderbook::Book &book) { m_implied.onTopChange(book); });
+}
+
+void TbtBookBuilder::defineSpread(uint32_t spread_token, uint32_t buy_leg, uint32_t sell_leg) {
+  m_implied.define(spread_token, buy_leg, sell_leg);
+}
+
+bool TbtBookBuilder::loadSpreads(const std::string &config_file) {
+  try {
+    YAML::Node spreads = YAML::LoadFile(config_file)["books"]["spreads"];
+    for (const auto &spread : spreads) {
+      defineSpread(spread["token"].as<uint32_t>(), spread["buy_leg"].as<uint32_t>(),
+                   spread["sell_leg"].as<uint32_t>());
+    }
+    return true;
+  } catch (const std::exception &e) {
+    spdlog::error("Failed to load spread definitions from {}: {}", config_file, e.what());
+    return false;
+  }
+}
+
+void TbtBookBuilder::apply(MessageView message) {
+  if (message.size() <= sizeof(StreamHeader)) {
+    ++m_stats.ignored;
+    return;
+  }
+
+  // copy the packed wire struct out rather than overlaying it on a possibly unaligned buffer
+  const auto *bytes = reinterpret_cast<const uint8_t *>(message.data());
+  const MessageType type = messageType(bytes);
+  switch (type) {
+  case MessageType::SpreadNewOrder:
+  case MessageType::SpreadModifyOrder:
+  case MessageType::SpreadCancelOrder:
+    ++m_stats.spread_messages;
+    [[fallthrough]];
+  case MessageType::NewOrder:
+  case MessageType::ModifyOrder:
+  case MessageType::CancelOrder: {
+    if (message.size() < sizeof(OrderMessage)) {
+      break;
+    }
+    OrderMessage order;
+    std::memcpy(&order, bytes, sizeof(order));
+    onOrder(type, order);
+    return;
+  }
+  case MessageType::SpreadTrade:
+    ++m_stats.spread_messages;
+    [[fallthrough]];
+  case MessageType::Trade: {
+    if (message.size() < sizeof(TradeMessage)) {
+      break;
+    }
+    TradeMessage trade;
+    std::memcpy(&trade, bytes, sizeof(trade));
+    onTrade(trade);
+    return;
+  }
+  default:
+    break;
+  }
+  ++m_stats.ignored;
+}
+
+void TbtBookBuilder::onOrder(MessageType type, const OrderMessage &order) {
+  using Result = OrderBook::Result;
+  const uint64_t key = orderKey(order.order_id);
+  const Side side = order.order_type == 'B' ? Side::Buy : Side::Sell;
+  const BookType book_type =
+      type == MessageType::SpreadNewOrder || type == MessageType::SpreadModifyOrder ? BookType::Spread
+                                                                                    : BookType::Outright;
+
+  switch (type) {
+  case MessageType::NewOrder:
+  case MessageType::SpreadNewOrder:
+    ++m_stats.adds;
+    if (m_book.add(key, order.token, side, order.price, order.quantity, book_type) == Result::Duplicate) {
+      ++m_stats.duplicates;
+    }
+    break;
+
+  case MessageType::ModifyOrder:
+  case MessageType::SpreadModifyOrder:
+    ++m_stats.modifies;
+    if (m_book.modify(key, order.price, order.quantity) == Result::UnknownOrder) {
+      // the order predates our view of the stream, a modify carries its full state so take it as is
+      ++m_stats.unknown_orders;
+      m_book.add(key, order.token, side, order.price, order.quantity, book_type);
+    }
+    break;
+
+  case MessageType::CancelOrder:
+  case MessageType::SpreadCancelOrder:
+    ++m_stats.cancels;
+    if (m_book.cancel(key) == Result::UnknownOrder) {
+      ++m_stats.unknown_orders;
+    }
+    break;
+
+  default:
+    break;
+  }
+}
+
+void TbtBookBuilder::onTrade(const TradeMessage &trade) {
+  using Result = OrderBook::Result;
+  ++m_stats.trades;
+
+  // a zero id is the side that never rested (market / IOC order)
+  for (const double order_id : {trade.buy_order_id, trade.sell_order_id}) {
+    if (order_id != 0 && m_book.execute(orderKey(order_id), trade.trade_quantity) == Result::UnknownOrder) {
+      ++m_stats.unknown_orders;
+    }
+  }
+}
+
+} // namespace recovery
+} // namespace acce
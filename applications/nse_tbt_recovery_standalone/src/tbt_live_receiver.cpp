@@ -0,0 +1,423 @@
+#include "tbt_live_receiver.h"
+#include <algorithm>
+#include <arpa/inet.h>
+#include <cstring>
+#include <fcntl.h>
+#include <netinet/in.h>
+#include <poll.h>
+#include <spdlog/spdlog.h>
+#include <sys/eventfd.h>
+#include <sys/socket.h>
+#include <unistd.h>
+#include <yaml-cpp/yaml.h>
+
+namespace acce {
+namespace recovery {
+
+namespace {
+constexpr size_t kDatagramSize = 65536;
+constexpr int kPollTimeoutMs = 10; // also how often stalls are checked
+constexpr auto kStatsInterval = std::chrono::seconds(5);
+} // namespace
+
+void TbtLiveReceiver::MessageBuffer::add(uint32_t seq_no, MessageView message) {
+  index.emplace_back(seq_no, static_cast<uint32_t>(data.size()));
+  data.insert(data.end(), message.begin(), message.end());
+}
+
+TbtLiveReceiver::TbtLiveReceiver(const std::string &config_file) : m_config_file(config_file) {}
+
+TbtLiveReceiver::~TbtLiveReceiver() {
+  {
+    std::lock_guard<std::mutex> lock(m_jobs_mutex);
+    m_stop_workers = true;
+  }
+  m_jobs_cv.notify_all();
+  for (auto &thread : m_threads) {
+    thread.join();
+  }
+  for (int sd : m_sockets) {
+    close(sd);
+  }
+  if (m_wakeup_fd >= 0) {
+    close(m_wakeup_fd);
+  }
+}
+
+bool TbtLiveReceiver::initialize() {
+  // the first client sets up logging, the session pool and the local store, the rest share them
+  auto first = std::make_unique<TbtRecoveryClient>(m_config_file);
+  if (!first->initialize()) {
+    return false;
+  }
+  m_logger = spdlog::get("tbt_recovery");
+  m_clients.push_back(std::move(first));
+
+  if (!loadConfig()) {
+    return false;
+  }
+
+  while (m_clients.size() < m_workers) {
+    auto client = std::make_unique<TbtRecoveryClient>(m_config_file);
+    client->setSessionPool(m_clients.front()->sessionPool());
+    client->setRecoveryStore(m_clients.front()->recoveryStore());
+    if (!client->initialize()) {
+      return false;
+    }
+    m_clients.push_back(std::move(client));
+  }
+
+  m_wakeup_fd = eventfd(0, EFD_NONBLOCK);
+  if (m_wakeup_fd < 0 || !openChannels()) {
+    return false;
+  }
+
+  for (auto &client : m_clients) {
+    m_threads.emplace_back([this, &client = *client] { recoveryWorker(client); });
+  }
+
+  m_logger->info("Live receiver on {} channels, {} recovery workers, stall limit {}ms, buffer limit {} messages",
+                 m_channels.size(), m_clients.size(), m_max_stall.count(), m_max_buffered);
+  return true;
+}
+
+bool TbtLiveReceiver::loadConfig() {
+  try {
+    YAML::Node config = YAML::LoadFile(m_config_file);
+    auto live = config["live"];
+
+    static const std::unordered_map<std::string, Segment> segment_map = {
+        {"CM", Segment::CM}, {"FO", Segment::FO}, {"CD", Segment::CD}, {"CO", Segment::CO}};
+    m_segment = segment_map.at(live["segment"].as<std::string>());
+    m_interface_ip = live["interface_ip"].as<std::string>();
+    for (const auto &channel : live["channels"]) {
+      m_channels.push_back({channel["group"].as<std::string>(), channel["port"].as<uint16_t>()});
+    }
+    m_max_buffered = live["max_buffered"].as<uint32_t>(1000000);
+    m_max_stall = std::chrono::milliseconds(live["max_stall_ms"].as<uint32_t>(2000));
+
+    const auto *segment_config = m_clients.front()->segmentConfig(m_segment);
+    if (!segment_config) {
+      m_logger->error("Live segment {} has no recovery server configured", segmentName(m_segment));
+      return false;
+    }
+    m_workers = std::max(live["recovery_workers"].as<uint32_t>(segment_config->max_sessions), 1u);
+    return true;
+  } catch (const std::exception &e) {
+    m_logger->error("Failed to load live receiver config: {}", e.what());
+    return false;
+  }
+}
+
+bool TbtLiveReceiver::openChannels() {
+  for (const auto &channel : m_channels) {
+    int sd = socket(AF_INET, SOCK_DGRAM, 0);
+    if (sd < 0) {
+      m_logger->error("Socket creation failed: {}", strerror(errno));
+      return false;
+    }
+    m_sockets.push_back(sd);
+
+    int reuse = 1;
+    setsockopt(sd, SOL_SOCKET, SO_REUSEADDR, &reuse, sizeof(reuse));
+    int rcvbuf = 16 << 20;
+    setsockopt(sd, SOL_SOCKET, SO_RCVBUF, &rcvbuf, sizeof(rcvbuf));
+    fcntl(sd, F_SETFL, fcntl(sd, F_GETFL, 0) | O_NONBLOCK);
+
+    // bind the group address so channels sharing a port don't see each other's traffic
+    struct sockaddr_in local_addr{};
+    local_addr.sin_family = AF_INET;
+    local_addr.sin_port = htons(channel.port);
+    local_addr.sin_addr.s_addr = inet_addr(channel.group.c_str());
+    if (bind(sd, reinterpret_cast<struct sockaddr *>(&local_addr), sizeof(local_addr)) < 0) {
+      m_logger->error("Bind to {}:{} failed: {}", channel.group, channel.port, strerror(errno));
+      return false;
+    }
+
+    struct ip_mreq group{};
+    group.imr_multiaddr.s_addr = inet_addr(channel.group.c_str());
+    group.imr_interface.s_addr = inet_addr(m_interface_ip.c_str());
+    if (setsockopt(sd, IPPROTO_IP, IP_ADD_MEMBERSHIP, &group, sizeof(group)) < 0) {
+      m_logger->error("Failed to join {}:{} on {}: {}", channel.group, channel.port, m_interface_ip, strerror(errno));
+      return false;
+    }
+    m_logger->info("Joined multicast group {}:{}", channel.group, channel.port);
+  }
+  return true;
+}
+
+void TbtLiveReceiver::run() {
+  std::vector<pollfd> fds;
+  for (int sd : m_sockets) {
+    fds.push_back({sd, POLLIN, 0});
+  }
+  fds.push_back({m_wakeup_fd, POLLIN, 0});
+
+  std::vector<uint8_t> datagram(kDatagramSize);
+  std::vector<GapResult> results;
+  auto next_stats = std::chrono::steady_clock::now() + kStatsInterval;
+
+  m_running = true;
+  while (m_running) {
+    if (poll(fds.data(), fds.size(), kPollTimeoutMs) < 0 && errno != EINTR) {
+      m_logger->error("poll failed: {}", strerror(errno));
+      break;
+    }
+
+    for (size_t i = 0; i + 1 < fds.size(); ++i) {
+      if (!(fds[i].revents & POLLIN)) {
+        continue;
+      }
+      // drain the socket, one datagram per recv
+      ssize_t bytes;
+      while ((bytes = recv(fds[i].fd, datagram.data(), datagram.size(), 0)) > 0) {
+        onDatagram(datagram.data(), static_cast<size_t>(bytes));
+      }
+    }
+
+    if (fds.back().revents & POLLIN) {
+      uint64_t count;
+      [[maybe_unused]] auto rc = read(m_wakeup_fd, &count, sizeof(count));
+      {
+        std::lock_guard<std::mutex> lock(m_results_mutex);
+        results.swap(m_results);
+      }
+      for (auto &result : results) {
+        completeGap(result);
+      }
+      results.clear();
+    }
+
+    checkStalls();
+
+    if (std::chrono::steady_clock::now() >= next_stats) {
+      logStats();
+      next_stats += kStatsInterval;
+    }
+  }
+  logStats();
+}
+
+void TbtLiveReceiver::onDatagram(const uint8_t *data, size_t length) {
+  // a datagram may carry several messages, each framed by its StreamHeader
+  size_t offset = 0;
+  while (length - offset >= sizeof(StreamHeader)) {
+    const auto *header = reinterpret_cast<const StreamHeader *>(data + offset);
+    if (header->msg_len <= sizeof(StreamHeader) || header->msg_len > length - offset) {
+      m_logger->warn("Malformed TBT datagram, msg_len {} with {} bytes left", header->msg_len, length - offset);
+      return;
+    }
+    onMessage(*header, MessageView(reinterpret_cast<const std::byte *>(data + offset), header->msg_len));
+    offset += header->msg_len;
+  }
+}
+
+void TbtLiveReceiver::onMessage(const StreamHeader &header, MessageView message) {
+  const auto type = messageType(reinterpret_cast<const uint8_t *>(message.data()));
+  if (type == MessageType::HeartBeat) {
+    return; // not part of the sequenced stream
+  }
+  if (type == MessageType::PacketLoss) {
+    m_logger->warn("Exchange reported packet loss on stream {} at seq {}", header.stream_id, header.seq_no);
+  }
+
+  auto &stream = m_streams[header.stream_id];
+  if (!stream.started) {
+    // join the stream wherever it is, history is a separate recovery request
+    stream.stream_id = header.stream_id;
+    stream.started = true;
+    stream.next_seq = header.seq_no;
+    if (const auto &store = m_clients.front()->recoveryStore()) {
+      stream.store = store->stream(segmentName(m_segment), header.stream_id);
+    }
+    m_logger->info("Stream {} starts at seq {}", header.stream_id, header.seq_no);
+  }
+
+  if (header.seq_no < stream.next_seq) {
+    stream.stats.duplicates++;
+    return;
+  }
+
+  if (stream.recovering) {
+    stream.pending.add(header.seq_no, message);
+    if (stream.pending.size() > m_max_buffered) {
+      abandonGap(stream, "buffer limit reached");
+    }
+    return;
+  }
+
+  if (header.seq_no == stream.next_seq) {
+    deliver(stream, header, message);
+    stream.next_seq++;
+    return;
+  }
+
+  stream.pending.add(header.seq_no, message);
+  startGap(stream, stream.next_seq, header.seq_no - 1);
+}
+
+void TbtLiveReceiver::deliver(StreamState &stream, const StreamHeader &header, MessageView message) {
+  if (stream.store) {
+    stream.store->append(header, message);
+  }
+  stream.stats.delivered++;
+  if (m_handler) {
+    m_handler(header, message);
+  }
+}
+
+void TbtLiveReceiver::startGap(StreamState &stream, uint32_t start_seq, uint32_t end_seq) {
+  stream.recovering = true;
+  stream.generation++;
+  stream.gap_start = start_seq;
+  stream.gap_end = end_seq;
+  stream.stalled_since = std::chrono::steady_clock::now();
+  stream.stats.gaps++;
+  m_logger->warn("Gap on stream {}: [{}, {}], requesting recovery", stream.stream_id, start_seq, end_seq);
+
+  {
+    std::lock_guard<std::mutex> lock(m_jobs_mutex);
+    m_jobs.push_back({stream.stream_id, stream.generation, start_seq, end_seq});
+  }
+  m_jobs_cv.notify_one();
+}
+
+void TbtLiveReceiver::completeGap(GapResult &result) {
+  auto it = m_streams.find(result.stream_id);
+  if (it == m_streams.end()) {
+    return;
+  }
+  auto &stream = it->second;
+  if (!stream.recovering || stream.generation != result.generation) {
+    return; // the gap was given up on while this was in flight
+  }
+  if (!result.ok) {
+    abandonGap(stream, "recovery failed");
+    return;
+  }
+
+  for (const auto &[seq_no, offset] : result.messages.index) {
+    if (seq_no != stream.next_seq || seq_no > stream.gap_end) {
+      continue;
+    }
+    const auto *header = reinterpret_cast<const StreamHeader *>(result.messages.data.data() + offset);
+    deliver(stream, *header, MessageView(result.messages.data.data() + offset, header->msg_len));
+    stream.stats.recovered++;
+    stream.next_seq++;
+  }
+
+  if (stream.next_seq <= stream.gap_end) {
+    abandonGap(stream, "recovery came back incomplete");
+    return;
+  }
+
+  m_logger->info("Gap on stream {}: [{}, {}] filled in {}ms", stream.stream_id, stream.gap_start, stream.gap_end,
+                 std::chrono::duration_cast<std::chrono::milliseconds>(std::chrono::steady_clock::now() -
+                                                                       stream.stalled_since)
+                     .count());
+  stream.recovering = false;
+  drainPending(stream);
+}
+
+void TbtLiveReceiver::abandonGap(StreamState &stream, const char *reason) {
+  const uint32_t lost = stream.next_seq <= stream.gap_end ? stream.gap_end - stream.next_seq + 1 : 0;
+  m_logger->error("Giving up gap on stream {}: [{}, {}], {}; {} messages lost", stream.stream_id, stream.next_seq,
+                  stream.gap_end, reason, lost);
+  stream.stats.abandoned += lost;
+  stream.next_seq = std::max(stream.next_seq, stream.gap_end + 1);
+  stream.recovering = false;
+  stream.generation++; // a late answer for this gap is ignored
+  drainPending(stream);
+}
+
+void TbtLiveReceiver::drainPending(StreamState &stream) {
+  auto &pending = stream.pending;
+  std::stable_sort(pending.index.begin(), pending.index.end(),
+                   [](const auto &a, const auto &b) { return a.first < b.first; });
+
+  size_t i = 0;
+  for (; i < pending.index.size(); ++i) {
+    const auto [seq_no, offset] = pending.index[i];
+    if (seq_no < stream.next_seq) {
+      stream.stats.duplicates++;
+      continue;
+    }
+    if (seq_no > stream.next_seq) {
+      break; // another hole behind the one just closed
+    }
+    const auto *header = reinterpret_cast<const StreamHeader *>(pending.data.data() + offset);
+    deliver(stream, *header, MessageView(pending.data.data() + offset, header->msg_len));
+    stream.next_seq++;
+  }
+
+  if (i == pending.index.size()) {
+    pending.clear();
+    return;
+  }
+
+  // keep what's left behind the new hole and go after it
+  MessageBuffer rest;
+  for (size_t j = i; j < pending.index.size(); ++j) {
+    const auto [seq_no, offset] = pending.index[j];
+    const auto *header = reinterpret_cast<const StreamHeader *>(pending.data.data() + offset);
+    rest.add(seq_no, MessageView(pending.data.data() + offset, header->msg_len));
+  }
+  pending = std::move(rest);
+  startGap(stream, stream.next_seq, pending.index.front().first - 1);
+}
+
+void TbtLiveReceiver::checkStalls() {
+  const auto now = std::chrono::steady_clock::now();
+  for (auto &[stream_id, stream] : m_streams) {
+    if (stream.recovering && now - stream.stalled_since > m_max_stall) {
+      abandonGap(stream, "stall limit reached");
+    }
+  }
+}
+
+void TbtLiveReceiver::recoveryWorker(TbtRecoveryClient &client) {
+  while (true) {
+    GapJob job;
+    {
+      std::unique_lock<std::mutex> lock(m_jobs_mutex);
+      m_jobs_cv.wait(lock, [this] { return m_stop_workers || !m_jobs.empty(); });
+      if (m_stop_workers) {
+        return;
+      }
+      job = m_jobs.front();
+      m_jobs.pop_front();
+    }
+
+    GapResult result{job.stream_id, job.generation, false, {}};
+    RecoveryRequest request{m_segment, job.stream_id, job.start_seq, job.end_seq};
+    result.ok = client.requestRecovery(request, [&result](const StreamHeader &header, MessageView message) {
+      result.messages.add(header.seq_no, message);
+    });
+
+    {
+      std::lock_guard<std::mutex> lock(m_results_mutex);
+      m_results.push_back(std::move(result));
+    }
+    const uint64_t one = 1;
+    [[maybe_unused]] auto rc = write(m_wakeup_fd, &one, sizeof(one));
+  }
+}
+
+std::unordered_map<uint16_t, TbtLiveReceiver::StreamStats> TbtLiveReceiver::stats() const {
+  std::unordered_map<uint16_t, StreamStats> stats;
+  for (const auto &[stream_id, stream] : m_streams) {
+    stats[stream_id] = stream.stats;
+  }
+  return stats;
+}
+
+void TbtLiveReceiver::logStats() const {
+  for (const auto &[stream_id, stream] : m_streams) {
+    m_logger->info("Stream {}: next_seq={} delivered={} recovered={} duplicates={} gaps={} abandoned={} pending={}",
+                   stream_id, stream.next_seq, stream.stats.delivered, stream.stats.recovered,
+                   stream.stats.duplicates, stream.stats.gaps, stream.stats.abandoned, stream.pending.size());
+  }
+}
+
+} // namespace recovery
+} // namespace acce
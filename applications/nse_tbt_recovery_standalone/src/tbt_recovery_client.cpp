@@ -1,13 +1,10 @@
 #include "tbt_recovery_client.h"
 #include "nse_tbt_packet_structure.h"
-#include <arpa/inet.h>
+#include "recovery_session_pool.h"
 #include <fmt/format.h>
 #include <iostream>
-#include <netinet/in.h>
 #include <spdlog/sinks/daily_file_sink.h>
 #include <spdlog/spdlog.h>
-#include <sys/socket.h>
-#include <unistd.h>
 #include <yaml-cpp/yaml.h>
 
 namespace acce {
@@ -15,10 +12,17 @@ namespace recovery {
 class TbtRecoveryClient::Logger {
 public:
   explicit Logger(const std::string &log_file) {
+    // several clients (one per recovery session) share the same daily log.
+    m_logger = spdlog::get("tbt_recovery");
+    if (m_logger) {
+      return;
+    }
     m_logger = spdlog::daily_logger_mt("tbt_recovery", log_file);
     m_logger->set_pattern("[%Y-%m-%d %H:%M:%S.%e] [%l] [%t] %v");
-    m_logger->set_level(spdlog::level::debug);
-    m_logger->flush_on(spdlog::level::info);
+    // per message lines are at trace and stay off; flushing on every info
+    // line would cost a write per line on the recovery path
+    m_logger->set_level(spdlog::level::info);
+    m_logger->flush_on(spdlog::level::warn);
   }
 
   // template<typename... Args>
@@ -51,6 +55,11 @@ public:
     m_logger->debug(fmt, std::forward<Args>(args)...);
   }
 
+  template <typename... Args>
+  void trace(fmt::format_string<Args...> fmt, Args &&...args) {
+    m_logger->trace(fmt, std::forward<Args>(args)...);
+  }
+
   template <typename... Args>
   void error(fmt::format_string<Args...> fmt, Args &&...args) {
     m_logger->error(fmt, std::forward<Args>(args)...);
@@ -91,82 +100,32 @@ private:
   std::shared_ptr<spdlog::logger> m_logger;
 };
 
-class TbtRecoveryClient::TcpConnection {
-public:
-  TcpConnection() : m_socket(-1) {}
+TbtRecoveryClient::TbtRecoveryClient(const std::string &config_file) : m_config_file(config_file) {}
 
-  ~TcpConnection() {
-    if (m_socket >= 0) {
-      close(m_socket);
-    }
+TbtRecoveryClient::~TbtRecoveryClient() {
+  // a sink that threw mid request left its session with us, it still counts against the pool
+  if (m_connection) {
+    m_pool->release(m_segment, std::move(m_connection), false);
   }
+}
 
-  bool connect(const std::string &ip, uint16_t port, uint32_t timeout_ms) {
-    m_socket = socket(AF_INET, SOCK_STREAM, 0);
-    if (m_socket < 0)
-      return false;
-
-    struct sockaddr_in server_addr{};
-    server_addr.sin_family = AF_INET;
-    server_addr.sin_port = htons(port);
-    inet_pton(AF_INET, ip.c_str(), &server_addr.sin_addr);
-
-    // Set timeout
-    struct timeval tv{};
-    tv.tv_sec = timeout_ms / 1000;
-    tv.tv_usec = (timeout_ms % 1000) * 1000;
-    setsockopt(m_socket, SOL_SOCKET, SO_RCVTIMEO, &tv, sizeof(tv));
-    setsockopt(m_socket, SOL_SOCKET, SO_SNDTIMEO, &tv, sizeof(tv));
-
-    return ::connect(m_socket, (struct sockaddr *)&server_addr,
-                     sizeof(server_addr)) == 0;
+bool TbtRecoveryClient::initialize() {
+  if (!loadConfig(m_config_file)) {
+    return false;
   }
 
-  bool send(const void *data, size_t size) {
-    return ::send(m_socket, data, size, 0) == size;
+  // Local store of recovered/live messages, off unless store_dir is configured
+  if (!m_store && !m_store_dir.empty() && !m_store_disabled) {
+    m_store = std::make_shared<RecoveryStore>(m_store_dir, m_store_max_bytes);
   }
 
-  // ssize_t recv_full(void* buffer, size_t size) {
-  //   return ::recv(m_socket, buffer, size, 0);
-  // }
-
-  ssize_t recv_full(void *buffer, size_t expected_size) {
-    uint8_t *ptr = static_cast<uint8_t *>(buffer);
-    size_t total_bytes_read = 0;
-
-    while (total_bytes_read < expected_size) {
-      ssize_t bytes_read = ::recv(m_socket, ptr + total_bytes_read,
-                                  expected_size - total_bytes_read, 0);
-
-      if (bytes_read <= 0) {
-        if (bytes_read == 0) {
-          // m_logger->error("Connection closed unexpectedly during
-          // recv_full.");
-          std::cerr << "Connection closed unexpectedly during recv_full."
-                    << std::endl;
-        } else {
-          // m_logger->error("Error during recv_full: {}", strerror(errno));
-          std::cerr << "Connection closed unexpectedly during recv_full."
-                    << std::endl;
-        }
-        return bytes_read; // Return error or disconnection
-      }
-
-      total_bytes_read += bytes_read;
-    }
-
-    return total_bytes_read;
+  // Open the sessions now, requests later only pick them up
+  if (!m_pool) {
+    m_pool = std::make_shared<RecoverySessionPool>(m_configs);
+    m_pool->start();
   }
-
-private:
-  int m_socket;
-};
-
-TbtRecoveryClient::TbtRecoveryClient(const std::string &config_file) : m_config_file(config_file) {}
-
-TbtRecoveryClient::~TbtRecoveryClient() = default;
-
-bool TbtRecoveryClient::initialize() { return loadConfig(m_config_file); }
+  return true;
+}
 
 bool TbtRecoveryClient::loadConfig(const std::string &config_file) {
   try {
@@ -175,6 +134,10 @@ bool TbtRecoveryClient::loadConfig(const std::string &config_file) {
     // Initialize logger
     m_logger = std::make_unique<Logger>(config["log"]["file"].as<std::string>());
 
+    // Optional local sequence store
+    m_store_dir = config["recovery"]["store_dir"].as<std::string>("");
+    m_store_max_bytes = config["recovery"]["store_max_gb"].as<uint64_t>(64) << 30;
+
     // Load server configs
     auto servers = config["servers"];
 
@@ -194,7 +157,20 @@ bool TbtRecoveryClient::loadConfig(const std::string &config_file) {
                          server.second["port"].as<uint16_t>(),
                          config["recovery"]["timeout_ms"].as<uint32_t>(),
                          config["recovery"]["max_retries"].as<uint32_t>(),
-                         config["recovery"]["buffer_size"].as<uint32_t>()};
+                         config["recovery"]["buffer_size"].as<uint32_t>(),
+                         config["recovery"]["max_sessions"].as<uint32_t>(1),
+                         config["recovery"]["chunk_size"].as<uint32_t>(0),
+                         {},
+                         0,
+                         config["recovery"]["retry_backoff_ms"].as<uint32_t>(100),
+                         config["recovery"]["retry_backoff_max_ms"].as<uint32_t>(5000),
+                         config["recovery"]["health_check_ms"].as<uint32_t>(1000)};
+      cfg.pool_size = config["recovery"]["pool_size"].as<uint32_t>(cfg.max_sessions);
+
+      // Alternate servers for the segment, in the order they should be tried
+      for (const auto &endpoint : server.second["failover"]) {
+        cfg.failover.push_back({endpoint["ip"].as<std::string>(), endpoint["port"].as<uint16_t>()});
+      }
 
       m_configs[segment] = cfg;
     }
@@ -209,6 +185,15 @@ bool TbtRecoveryClient::loadConfig(const std::string &config_file) {
 }
 
 bool TbtRecoveryClient::requestRecovery(const RecoveryRequest &request) {
+  return requestRecovery(request, [this](const StreamHeader &hdr, MessageView message) {
+    // Fire user callback if set
+    if (m_callback) {
+      m_callback(hdr, message);
+    }
+  });
+}
+
+bool TbtRecoveryClient::beginRecovery(const RecoveryRequest &request) {
   // Get config for requested segment
   auto it = m_configs.find(request.segment);
   if (it == m_configs.end()) {
@@ -217,18 +202,25 @@ bool TbtRecoveryClient::requestRecovery(const RecoveryRequest &request) {
   }
   const auto &config = it->second;
 
-  // Connect to recovery server
-  m_connection = std::make_unique<TcpConnection>();
-  if (!m_connection->connect(config.server_ip, config.server_port,
-                             config.timeout_ms)) {
-    m_logger->error("Failed to connect to recovery server {}:{}",
-                    config.server_ip, config.server_port);
+  if (m_connection) {
+    m_pool->release(m_segment, std::move(m_connection), false); // left over by a sink that threw
+  }
+
+  // Take a connected session from the pool, it handles retries and failover
+  m_connection = m_pool->acquire(request.segment);
+  if (!m_connection) {
+    m_logger->error("No recovery session available for segment {}", static_cast<int>(request.segment));
     return false;
   }
+  m_segment = request.segment;
+  m_received = 0;
 
   // Set the end sequence number
   m_end_seq = request.end_seq;
 
+  // The receive buffer is allocated once and re-used by every request
+  m_framer.reserve(config.buffer_size);
+
   // Send recovery request
   RecoveryRequestPacket req_packet{};
   req_packet.msg_type = 'R';
@@ -237,99 +229,112 @@ bool TbtRecoveryClient::requestRecovery(const RecoveryRequest &request) {
   req_packet.end_seq = request.end_seq;
 
   if (!sendRequest(req_packet)) {
-    m_logger->error("Failed to send recovery request");
-    return false;
+    // a dead pooled session, close it so the receive fails at once and the request is retried
+    m_logger->warn("Failed to send recovery request to {}:{}", m_connection->ip(), m_connection->port());
+    m_connection->close();
   }
-
-  // Process responses
-  return processRecovery();
+  return true;
 }
 
 bool TbtRecoveryClient::sendRequest(const RecoveryRequestPacket &request) {
   return m_connection->send(&request, sizeof(request));
 }
 
-bool TbtRecoveryClient::processRecovery() {
-  while (true) {
-    // (1) Read the 9-byte StreamHeader
-    StreamHeader hdr{};
-    ssize_t bytes_read = m_connection->recv_full(&hdr, sizeof(hdr));
-    if (bytes_read <= 0) {
-      m_logger->error("Connection closed or error while reading TBT header.");
-      m_connection.reset();
-      break;
-    }
-    if (bytes_read != static_cast<ssize_t>(sizeof(hdr))) {
-      m_logger->error("Incomplete TBT header read: got {} vs expected {}",
-                      bytes_read, sizeof(hdr));
-      return false;
-    }
-
-    // Convert from network to host endianness
-    // fixEndianness(hdr); not needed as the data packet is Little Endian.
+bool TbtRecoveryClient::receive() {
+  auto space = m_framer.writable();
+  if (space.empty()) {
+    m_logger->error("Recovery receive buffer is full, buffer_size too small");
+    return false;
+  }
 
-    //construct payload
-    std::vector<uint8_t> payload(hdr.msg_len);
+  ssize_t bytes_read = m_connection->recv_some(space.data(), space.size());
+  if (bytes_read <= 0) {
+    m_logger->error("Connection closed or error while reading TBT data ({} bytes buffered).",
+                    m_framer.buffered());
+    return false;
+  }
+  m_framer.commit(static_cast<size_t>(bytes_read));
+  m_received += static_cast<size_t>(bytes_read);
+  return true;
+}
 
-    // (2) Handling Control Message ('Y')
-    if(payload[0] == static_cast<uint8_t>(MessageType::Recovery)) {
+TbtRecoveryClient::Disposition TbtRecoveryClient::onMessage(const StreamHeader &hdr, const uint8_t *msg, size_t length) {
+  if (length <= sizeof(StreamHeader)) {
+    m_logger->warn("Empty TBT message: seq={} stream={}", hdr.seq_no, hdr.stream_id);
+    return Disposition::Skip;
+  }
 
-      m_logger->hexdump(payload.data(),payload.size(), "");
-      auto *recoveryResp = reinterpret_cast<const RecoveryResponse *>(payload.data());
-      if (recoveryResp->req_status != 0) { // Assuming '0' means success
-        m_logger->error("Recovery request failed with status {}", recoveryResp->req_status);
-        return false;
-      }
-      m_logger->info("TBT Recovery Response Success");
+  // Handling Control Message ('Y')
+  if (messageType(msg) == MessageType::Recovery) {
+    m_logger->hexdump(msg, length, "");
+    if (length < sizeof(RecoveryResponse)) {
+      m_logger->error("Truncated recovery response ({} bytes)", length);
+      return Disposition::Fail;
     }
-
-    // (3) Read and Process TBT Data
-    size_t total_bytes_read = 0;
-    while (total_bytes_read < hdr.msg_len) {
-      ssize_t ret = m_connection->recv_full(payload.data() + total_bytes_read,
-                                            hdr.msg_len - total_bytes_read);
-      if (ret <= 0) {
-        m_logger->error("Incomplete TBT packet received: got {} vs expected {}",
-                        total_bytes_read, hdr.msg_len);
-        return false;
-      }
-      total_bytes_read += ret;
+    auto *recoveryResp = reinterpret_cast<const RecoveryResponse *>(msg);
+    if (recoveryResp->req_status != 0) { // Assuming '0' means success
+      m_logger->error("Recovery request failed with status {}", recoveryResp->req_status);
+      return Disposition::Fail;
     }
+    m_logger->info("TBT Recovery Response Success");
+    return Disposition::Skip;
+  }
 
-    m_logger->info("Received TBT packet: seq={}, stream={} size={}", hdr.seq_no,
-                   hdr.stream_id, hdr.msg_len);
-    m_logger->hexdump(payload.data(), hdr.msg_len, "  ");
+  m_logger->trace("Received TBT packet: seq={}, stream={} size={}", hdr.seq_no, hdr.stream_id, length);
 
-    // Process the TBT message
+  // Process the TBT message
+  processTbtMessage(hdr, msg, length);
 
-    processTbtMessage(hdr, payload.data(), hdr.msg_len);
+  // Stop if we have received all requested sequences
+  if (hdr.seq_no >= m_end_seq) {
+    m_logger->info("Reached requested sequence range. Closing connection.");
+    return Disposition::DeliverLast;
+  }
+  return Disposition::Deliver;
+}
 
-    // Fire user callback if set
-    if (m_callback) {
-      m_callback(hdr.seq_no, payload);
-    }
+bool TbtRecoveryClient::endRecovery(bool ok, TbtStreamFramer::Status status) {
+  if (status == TbtStreamFramer::Status::Malformed) {
+    m_logger->error("Malformed TBT stream, invalid message length with {} bytes buffered", m_framer.buffered());
+  }
+  // Only a session that ended exactly on a message boundary can serve another request
+  m_pool->release(m_segment, std::move(m_connection), ok && m_framer.buffered() == 0);
+  return ok;
+}
 
-    // Stop if we have received all requested sequences
-    if (hdr.seq_no >= m_end_seq) {
-      m_logger->info("Reached requested sequence range. Closing connection.");
-      return true;
-    }
+void TbtRecoveryClient::logLocalHit(const RecoveryRequest &request, size_t gaps) const {
+  if (gaps == 0) {
+    m_logger->info("Serving stream {} [{}, {}] from the local store", request.stream_id, request.start_seq,
+                   request.end_seq);
+  } else {
+    m_logger->info("Stream {} [{}, {}] has {} gaps in the local store, fetching them from the exchange",
+                   request.stream_id, request.start_seq, request.end_seq, gaps);
   }
+}
 
-  m_connection.reset();
-  return false;
+bool TbtRecoveryClient::shouldRetry(const RecoveryRequest &request, uint32_t attempt) const {
+  const auto &config = m_configs.at(request.segment);
+  if (m_received > 0 || attempt >= config.max_retries) {
+    return false;
+  }
+  m_logger->warn("Recovery session closed before responding, retrying stream {} [{}, {}] ({}/{})",
+                 request.stream_id, request.start_seq, request.end_seq, attempt + 1, config.max_retries);
+  return true;
 }
 
 void TbtRecoveryClient::processTbtMessage(const StreamHeader &tbtHeader, const uint8_t *payload, size_t length) {
-  // We already called fixEndianness(hdr) in processRecovery(),
-  // so tbtHeader is in host-endian format.
+  // payload points at the full message, StreamHeader included, so the
+  // message structs below can be overlaid on it directly.
 
-  MessageType msgType = static_cast<MessageType>(payload[0]);
+  MessageType msgType = messageType(payload);
 
   switch (msgType) {
   case MessageType::NewOrder:
   case MessageType::ModifyOrder:
-  case MessageType::CancelOrder: {
+  case MessageType::CancelOrder:
+  case MessageType::SpreadNewOrder:
+  case MessageType::SpreadModifyOrder:
+  case MessageType::SpreadCancelOrder: {
     if (length < sizeof(OrderMessage)) {
       m_logger->error("Payload too small ({} bytes) for OrderMessage", length);
       return;
@@ -338,7 +343,7 @@ void TbtRecoveryClient::processTbtMessage(const StreamHeader &tbtHeader, const u
         reinterpret_cast<OrderMessage *>(const_cast<uint8_t *>(payload));
     // fixEndianness(*orderPtr);
 
-    m_logger->info(
+    m_logger->trace(
         "Order: seq={} stream={} type={} token={} orderid={} price={} qty={}",
         orderPtr->header.seq_no, orderPtr->header.stream_id,
         static_cast<char>(orderPtr->message_type), orderPtr->token,
@@ -346,7 +351,8 @@ void TbtRecoveryClient::processTbtMessage(const StreamHeader &tbtHeader, const u
     break;
   }
 
-  case MessageType::Trade: {
+  case MessageType::Trade:
+  case MessageType::SpreadTrade: {
     if (length < sizeof(TradeMessage)) {
       m_logger->error("Payload too small ({} bytes) for TradeMessage", length);
       return;
@@ -355,9 +361,9 @@ void TbtRecoveryClient::processTbtMessage(const StreamHeader &tbtHeader, const u
         reinterpret_cast<TradeMessage *>(const_cast<uint8_t *>(payload));
     // fixEndianness(*tradePtr);
 
-    m_logger->info(
-        "Trade: seq={} stream={} token={} buyOrd={} sellOrd={} price={} qty={}",
-        tradePtr->header.seq_no, tradePtr->header.stream_id, tradePtr->token,
+    m_logger->trace(
+        "{}: seq={} stream={} token={} buyOrd={} sellOrd={} price={} qty={}",
+        msgType == MessageType::SpreadTrade ? "SpreadTrade" : "Trade", tradePtr->header.seq_no, tradePtr->header.stream_id, tradePtr->token,
         tradePtr->buy_order_id, tradePtr->sell_order_id, tradePtr->trade_price,
         tradePtr->trade_quantity);
     break;
@@ -380,19 +386,19 @@ void TbtRecoveryClient::processTbtMessage(const StreamHeader &tbtHeader, const u
   }
 
   case MessageType::HeartBeat: {
-    m_logger->debug("Heartbeat received: seq={} stream={}", tbtHeader.seq_no,
+    m_logger->trace("Heartbeat received: seq={} stream={}", tbtHeader.seq_no,
                     tbtHeader.stream_id);
     break;
   }
   case MessageType::Recovery: {
-    m_logger->warn("Recovery Response received :{}",
-                   static_cast<char>(payload[0]));
+    m_logger->debug("Recovery Response received :{}",
+                    static_cast<char>(msgType));
     break;
   }
 
   default: {
     m_logger->warn("Unknown message type received: {}",
-                   static_cast<char>(payload[0]));
+                   static_cast<char>(msgType));
     break;
   }
   }
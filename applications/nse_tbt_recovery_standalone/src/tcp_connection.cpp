@@ -0,0 +1,120 @@
+#include "tcp_connection.h"
+#include <algorithm>
+#include <arpa/inet.h>
+#include <cerrno>
+#include <fcntl.h>
+#include <iostream>
+#include <netinet/in.h>
+#include <netinet/tcp.h>
+#include <poll.h>
+#include <sys/socket.h>
+#include <unistd.h>
+
+namespace acce {
+namespace recovery {
+
+TcpConnection::~TcpConnection() { close(); }
+
+bool TcpConnection::connect(const std::string &ip, uint16_t port, uint32_t timeout_ms,
+                            const std::atomic<bool> *cancel) {
+  close();
+  m_ip = ip;
+  m_port = port;
+
+  struct sockaddr_in server_addr{};
+  server_addr.sin_family = AF_INET;
+  server_addr.sin_port = htons(port);
+  if (inet_pton(AF_INET, ip.c_str(), &server_addr.sin_addr) != 1) {
+    return false;
+  }
+
+  m_socket = socket(AF_INET, SOCK_STREAM, 0);
+  if (m_socket < 0)
+    return false;
+
+  // Non-blocking connect so an unreachable server costs timeout_ms, not the kernel's SYN retries
+  const int flags = fcntl(m_socket, F_GETFL, 0);
+  fcntl(m_socket, F_SETFL, flags | O_NONBLOCK);
+  int rc = ::connect(m_socket, (struct sockaddr *)&server_addr, sizeof(server_addr));
+  if (rc < 0 && errno == EINPROGRESS) {
+    // wait in short slices so a cancel is noticed quickly
+    constexpr uint32_t kSliceMs = 50;
+    struct pollfd pfd{m_socket, POLLOUT, 0};
+    rc = 0;
+    for (uint32_t waited = 0; rc == 0 && waited < timeout_ms && !(cancel && *cancel); waited += kSliceMs) {
+      rc = poll(&pfd, 1, static_cast<int>(std::min(kSliceMs, timeout_ms - waited)));
+    }
+    int error = 0;
+    socklen_t len = sizeof(error);
+    if (rc == 1 && getsockopt(m_socket, SOL_SOCKET, SO_ERROR, &error, &len) == 0 && error == 0) {
+      rc = 0;
+    } else {
+      rc = -1;
+    }
+  }
+  if (rc < 0) {
+    close();
+    return false;
+  }
+  fcntl(m_socket, F_SETFL, flags);
+
+  // Set timeout
+  struct timeval tv{};
+  tv.tv_sec = timeout_ms / 1000;
+  tv.tv_usec = (timeout_ms % 1000) * 1000;
+  setsockopt(m_socket, SOL_SOCKET, SO_RCVTIMEO, &tv, sizeof(tv));
+  setsockopt(m_socket, SOL_SOCKET, SO_SNDTIMEO, &tv, sizeof(tv));
+
+  // Requests are tiny and latency bound, idle pooled sessions should notice a dead peer
+  int one = 1;
+  setsockopt(m_socket, IPPROTO_TCP, TCP_NODELAY, &one, sizeof(one));
+  setsockopt(m_socket, SOL_SOCKET, SO_KEEPALIVE, &one, sizeof(one));
+  return true;
+}
+
+void TcpConnection::close() {
+  if (m_socket >= 0) {
+    ::close(m_socket);
+    m_socket = -1;
+  }
+}
+
+bool TcpConnection::healthy() const {
+  if (m_socket < 0) {
+    return false;
+  }
+  uint8_t byte;
+  const ssize_t rc = ::recv(m_socket, &byte, 1, MSG_PEEK | MSG_DONTWAIT);
+  return rc < 0 && (errno == EAGAIN || errno == EWOULDBLOCK);
+}
+
+bool TcpConnection::send(const void *data, size_t size) {
+  return ::send(m_socket, data, size, MSG_NOSIGNAL) == static_cast<ssize_t>(size);
+}
+
+ssize_t TcpConnection::recv_full(void *buffer, size_t expected_size) {
+  uint8_t *ptr = static_cast<uint8_t *>(buffer);
+  size_t total_bytes_read = 0;
+
+  while (total_bytes_read < expected_size) {
+    ssize_t bytes_read = ::recv(m_socket, ptr + total_bytes_read,
+                                expected_size - total_bytes_read, 0);
+
+    if (bytes_read <= 0) {
+      std::cerr << "Connection closed unexpectedly during recv_full."
+                << std::endl;
+      return bytes_read; // Return error or disconnection
+    }
+
+    total_bytes_read += bytes_read;
+  }
+
+  return total_bytes_read;
+}
+
+ssize_t TcpConnection::recv_some(void *buffer, size_t size) {
+  return ::recv(m_socket, buffer, size, 0);
+}
+
+} // namespace recovery
+} // namespace acce
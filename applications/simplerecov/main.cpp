@@ -1,14 +1,20 @@
 #include "tbt_packet_structure.h"
+#include <capture/reader.h>
+#include <capture/writer.h>
 #include <arpa/inet.h>
 #include <fcntl.h>
 #include <fstream>
 #include <iostream>
+#include <algorithm>
+#include <chrono>
 #include <memory>
 #include <netinet/in.h>
+#include <span>
 #include <spdlog/sinks/daily_file_sink.h>
 #include <spdlog/spdlog.h>
 #include <string>
 #include <sys/socket.h>
+#include <thread>
 #include <unistd.h>
 #include <vector>
 
@@ -60,52 +66,30 @@ public:
   }
 
   void enableDumping(bool enable,
-                     const std::string &filename = "tbt_recovery_dump.bin") {
+                     const std::string &filename = "tbt_recovery_dump.cap") {
     m_enable_dump = enable;
     m_dump_filename = filename;
   }
 
-  void openDumpFile() {
-    if (m_enable_dump && !m_dump_file.is_open()) {
-      m_dump_file.open(m_dump_filename, std::ios::binary | std::ios::out);
-      if (!m_dump_file.is_open()) {
-        m_logger->error("Failed to open dump file: {}", m_dump_filename);
-      }
+  bool openDumpFile() {
+    if (m_enable_dump && !m_capture.isOpen() &&
+        !m_capture.open(m_dump_filename, "nse-tbt-recov")) {
+      m_logger->error("Failed to open capture file {}: {}", m_dump_filename,
+                      m_capture.error());
+      return false;
     }
+    return true;
   }
 
-  void dumpToFile(const void *data, size_t size, const char *prefix) {
-    if (!m_enable_dump || !m_dump_file.is_open())
+  // Record one whole message (or request) into the capture file, buffered
+  void dumpToFile(const void *data, size_t size, uint32_t seq_no,
+                  uint16_t stream_id, elaeo::foundation::capture::RecordKind kind) {
+    if (!m_enable_dump || !m_capture.isOpen())
       return;
 
-    // Write a separator and prefix
-    std::string separator = "\n----------------------------------------\n";
-    m_dump_file.write(separator.c_str(), separator.length());
-    m_dump_file.write(prefix, strlen(prefix));
-    m_dump_file.write("\n", 1);
-
-    // Write the raw data
-    m_dump_file.write(static_cast<const char *>(data), size);
-    m_dump_file.flush();
-
-    // Also log hexdump if logger is available
-    if (m_logger) {
-      m_logger->debug("Dumping {} bytes to file with prefix: {}", size, prefix);
-
-      // Create hex dump
-      std::stringstream hex_dump;
-      const uint8_t *bytes = static_cast<const uint8_t *>(data);
-
-      for (size_t i = 0; i < size; i++) {
-        if (i % 16 == 0) {
-          if (i > 0)
-            hex_dump << "\n";
-          hex_dump << fmt::format("{:04x}: ", i);
-        }
-        hex_dump << fmt::format("{:02x} ", bytes[i]);
-      }
-
-      m_logger->debug("Hex dump:\n{}", hex_dump.str());
+    if (!m_capture.write(seq_no, stream_id,
+                         {static_cast<const std::byte *>(data), size}, kind)) {
+      m_logger->error("Failed to write to capture file: {}", m_capture.error());
     }
   }
 
@@ -181,7 +165,10 @@ public:
     RecoveryResult result{false, 0, ""};
 
     // Open dump file if enabled
-    openDumpFile();
+    if (!openDumpFile()) {
+      result.error_message = "Failed to open capture file";
+      return result;
+    }
 
     if (!connectToServer()) {
       result.error_message = "Failed to connect to recovery server";
@@ -192,7 +179,9 @@ public:
     if (m_enable_dump) {
       RecoveryRequestPacket req_packet{'R', request.stream_id,
                                        request.start_seq, request.end_seq};
-      dumpToFile(&req_packet, sizeof(req_packet), "RECOVERY_REQUEST");
+      dumpToFile(&req_packet, sizeof(req_packet), request.start_seq,
+                 request.stream_id,
+                 elaeo::foundation::capture::RecordKind::Request);
     }
 
     if (!sendRequest(request)) {
@@ -200,125 +189,82 @@ public:
       return result;
     }
 
-    // Modified packet reading loop
-    std::vector<uint8_t> buffer(65536); // Use a large enough buffer
+    // msg_len covers the whole message, StreamHeader included
+    std::vector<uint8_t> buffer(65536);
     while (true) {
-      // Read data in chunks
-      ssize_t bytes_read =
-          recv(m_socket, buffer.data(), sizeof(StreamHeader), 0);
-      if (bytes_read <= 0)
+      if (!readExact(buffer.data(), sizeof(StreamHeader)))
         break;
 
-      // Dump the header
-      if (m_enable_dump) {
-        dumpToFile(buffer.data(), bytes_read, "PACKET_HEADER");
+      StreamHeader hdr;
+      std::memcpy(&hdr, buffer.data(), sizeof(hdr));
+      if (hdr.msg_len < sizeof(StreamHeader)) {
+        m_logger->error("Invalid message length {} at seq {}", hdr.msg_len,
+                        hdr.seq_no);
+        break;
       }
+      if (!readExact(buffer.data() + sizeof(StreamHeader),
+                     hdr.msg_len - sizeof(StreamHeader)))
+        break;
 
-      // Parse header
-      StreamHeader *hdr = reinterpret_cast<StreamHeader *>(buffer.data());
-
-      // Read payload if there is one
-      if (hdr->msg_len > 0) {
-        bytes_read = recv(m_socket, buffer.data() + sizeof(StreamHeader),
-                          hdr->msg_len, 0);
-        if (bytes_read <= 0)
-          break;
-
-        // Dump the complete packet (header + payload)
-        if (m_enable_dump) {
-          dumpToFile(
-              buffer.data(), sizeof(StreamHeader) + hdr->msg_len,
-              fmt::format("COMPLETE_PACKET_SEQ_{}", hdr->seq_no).c_str());
-        }
-      }
+      dumpToFile(buffer.data(), hdr.msg_len, hdr.seq_no, hdr.stream_id,
+                 elaeo::foundation::capture::RecordKind::Message);
 
       result.packets_recovered++;
 
       // Check if we've reached the end sequence
-      if (hdr->seq_no >= request.end_seq) {
+      if (hdr.seq_no >= request.end_seq) {
         result.success = true;
         break;
       }
     }
 
-    // Close dump file
-    if (m_dump_file.is_open()) {
-      m_dump_file.close();
+    // Close the capture, writing its index
+    if (m_capture.isOpen() && !m_capture.close()) {
+      m_logger->error("Failed to finish capture file: {}", m_capture.error());
     }
 
     return result;
   }
 
-void parseHexDumpFile(const std::string& filename) {
+void parseCaptureFile(const std::string& filename) {
     auto parse_logger = spdlog::daily_logger_mt("parse_logger", "parsed_data.log", 0, 0);
     parse_logger->set_pattern("[%Y-%m-%d %H:%M:%S.%e] [%^%l%$] %v");
     parse_logger->set_level(spdlog::level::debug);
     parse_logger->flush_on(spdlog::level::debug);
 
-    std::ifstream file(filename, std::ios::binary);
-    if (!file) {
-        parse_logger->error("Failed to open hex dump file: {}", filename);
+    elaeo::foundation::capture::Reader reader;
+    if (!reader.open(filename)) {
+        parse_logger->error("Failed to open capture file {}: {}", filename, reader.error());
+        spdlog::drop("parse_logger");
         return;
     }
 
     parse_logger->info("===============================================");
-    parse_logger->info("Starting to parse hex dump file: {}", filename);
+    parse_logger->info("Starting to parse capture file: {} ({} records{})", filename,
+                       reader.indexed() ? std::to_string(reader.header().record_count) : "unknown",
+                       reader.indexed() ? "" : ", not closed cleanly");
     parse_logger->info("===============================================");
-    
-    std::string line;
-    std::vector<uint8_t> current_packet;
-    std::string current_section;
-    bool in_packet = false;
-
-    while (std::getline(file, line)) {
-        if (line.empty()) continue;
-
-        // Skip lines that don't contain hex data
-        if (line.length() < 10 || !std::isxdigit(line[0])) {
-            if (line.find("[") != std::string::npos) {
-                // This is a section header
-                if (!current_packet.empty()) {
-                    processPacketData(current_section, current_packet, parse_logger);
-                    current_packet.clear();
-                }
-                current_section = line;
-                parse_logger->info("Processing section: {}", line);
-            }
-            continue;
-        }
 
-        // Parse hex line
-        // Format: 00000000 50 41 43 4B 45 54 ... |ASCII...|
-        std::string hex_part = line.substr(9, 48); // Extract hex portion
-        std::istringstream hex_stream(hex_part);
-        std::string hex_byte;
-
-        while (hex_stream >> hex_byte) {
-            if (hex_byte.length() == 2) {
-                try {
-                    uint8_t byte = static_cast<uint8_t>(std::stoul(hex_byte, nullptr, 16));
-                    current_packet.push_back(byte);
-                } catch (const std::exception& e) {
-                    parse_logger->warn("Failed to parse hex byte: {}", hex_byte);
-                }
-            }
-        }
-    }
-
-    // Process final packet if any
-    if (!current_packet.empty()) {
-        processPacketData(current_section, current_packet, parse_logger);
+    // records are views into the mapped file, nothing to decode
+    for (const auto record : reader) {
+        const bool request = record.kind() == elaeo::foundation::capture::RecordKind::Request;
+        const std::string section = fmt::format("{}_SEQ_{}", request ? "RECOVERY_REQUEST" : "PACKET",
+                                                record.seqNo());
+        parse_logger->info("Processing section: {}", section);
+        processPacketData(section,
+                          {reinterpret_cast<const uint8_t*>(record.payload.data()), record.payload.size()},
+                          parse_logger);
     }
 
     parse_logger->info("===============================================");
-    parse_logger->info("Completed parsing hex dump file");
+    parse_logger->info("Completed parsing capture file");
     parse_logger->info("===============================================");
-    
+
     spdlog::drop("parse_logger");
 }
 
-void processPacketData(const std::string& section, 
-                                        const std::vector<uint8_t>& data,
+void processPacketData(const std::string& section,
+                                        std::span<const uint8_t> data,
                                         std::shared_ptr<spdlog::logger> parse_logger) {
     if (data.empty()) {
         parse_logger->warn("Empty packet data for section: {}", section);
@@ -420,7 +366,33 @@ private:
     }
   }
 
+  // Connect, retrying up to max_retries times with exponential backoff
   bool connectToServer() {
+    constexpr uint32_t kBackoffMs = 100;
+    constexpr uint32_t kBackoffMaxMs = 5000;
+
+    for (uint32_t attempt = 0;; ++attempt) {
+      if (tryConnect()) {
+        return true;
+      }
+      if (attempt >= m_config.max_retries) {
+        m_logger->error("Giving up after {} connect attempts", attempt + 1);
+        return false;
+      }
+
+      const uint32_t delay_ms =
+          std::min<uint32_t>(kBackoffMs << std::min(attempt, 16u), kBackoffMaxMs);
+      m_logger->warn("Retrying connect in {} ms ({}/{})", delay_ms, attempt + 1,
+                     m_config.max_retries);
+      std::this_thread::sleep_for(std::chrono::milliseconds(delay_ms));
+    }
+  }
+
+  bool tryConnect() {
+    if (m_socket >= 0) {
+      close(m_socket);
+      m_socket = -1;
+    }
     m_socket = socket(AF_INET, SOCK_STREAM, 0);
     if (m_socket < 0) {
       m_logger->error("Socket creation failed: {}", strerror(errno));
@@ -432,12 +404,14 @@ private:
     if (flags < 0) {
       m_logger->error("Failed to get socket flags: {}", strerror(errno));
       close(m_socket);
+      m_socket = -1;
       return false;
     }
 
     if (fcntl(m_socket, F_SETFL, flags | O_NONBLOCK) < 0) {
       m_logger->error("Failed to set non-blocking mode: {}", strerror(errno));
       close(m_socket);
+      m_socket = -1;
       return false;
     }
 
@@ -449,6 +423,7 @@ private:
         0) {
       m_logger->error("Invalid address: {}", strerror(errno));
       close(m_socket);
+      m_socket = -1;
       return false;
     }
 
@@ -461,6 +436,7 @@ private:
       if (errno != EINPROGRESS) {
         m_logger->error("Connection failed immediately: {}", strerror(errno));
         close(m_socket);
+        m_socket = -1;
         return false;
       }
 
@@ -477,6 +453,7 @@ private:
         m_logger->error("Connection timed out after {} ms",
                         m_config.timeout_ms);
         close(m_socket);
+        m_socket = -1;
         return false;
       }
 
@@ -487,6 +464,7 @@ private:
         m_logger->error("Connection failed during wait: {}",
                         error ? strerror(error) : strerror(errno));
         close(m_socket);
+        m_socket = -1;
         return false;
       }
     }
@@ -495,6 +473,7 @@ private:
     if (fcntl(m_socket, F_SETFL, flags & ~O_NONBLOCK) < 0) {
       m_logger->error("Failed to restore blocking mode: {}", strerror(errno));
       close(m_socket);
+      m_socket = -1;
       return false;
     }
 
@@ -507,6 +486,7 @@ private:
         setsockopt(m_socket, SOL_SOCKET, SO_SNDTIMEO, &tv, sizeof(tv)) < 0) {
       m_logger->error("Failed to set socket timeouts: {}", strerror(errno));
       close(m_socket);
+      m_socket = -1;
       return false;
     }
 
@@ -747,9 +727,9 @@ private:
   int m_socket = -1;
   RecoveryConfig m_config;
   std::shared_ptr<spdlog::logger> m_logger;
-  // for response's hex dump
-  std::ofstream m_dump_file;
-  bool m_enable_dump;
+  // binary capture of the recovery responses
+  elaeo::foundation::capture::Writer m_capture;
+  bool m_enable_dump = false;
   std::string m_dump_filename;
 };
 
@@ -769,11 +749,11 @@ int main() {
       217514178// end_seq
   };
 
-  // First perform recovery with hex dumping
+  // First perform recovery with capture
   std::string dump_filename = "recovery_dump_" +
                               std::to_string(request.stream_id) + "_" +
                               std::to_string(request.start_seq) + "_" +
-                              std::to_string(request.end_seq) + ".bin";
+                              std::to_string(request.end_seq) + ".cap";
 
   client.enableDumping(true, dump_filename);
 
@@ -788,7 +768,7 @@ int main() {
   //           << " packets." << std::endl;
   //
 
-  std::cout << "Starting recovery with hex dumping..." << std::endl;
+  std::cout << "Starting recovery with capture..." << std::endl;
   auto dump_result = client.performRecoveryDump(request);
 
   if (!dump_result.success) {
@@ -799,10 +779,9 @@ int main() {
 
   std::cout << "Recovery dump successful. Captured "
             << dump_result.packets_recovered << " packets." << std::endl;
-  std::cout << "Check the generated dump file for detailed hex output."
-            << std::endl;
+  std::cout << "Captured to " << dump_filename << std::endl;
 
-  std::cout << "parsing hex dump file" << std::endl;
-  client.parseHexDumpFile(dump_filename);
+  std::cout << "parsing capture file" << std::endl;
+  client.parseCaptureFile(dump_filename);
   return 0;
 }
@@ -0,0 +1,155 @@
+/**
+ * @file flat_index.h
+ * @brief open addressing uint64_t -> pointer map used for order and instrument lookup.
+ */
+
+#ifndef ELAEO_BIZ_ORDERBOOK_FLAT_INDEX_H
+#define ELAEO_BIZ_ORDERBOOK_FLAT_INDEX_H
+
+#include <cstddef>
+#include <cstdint>
+#include <vector>
+
+namespace elaeo::business::orderbook {
+
+/**
+ * @brief Linear probing hash map from a 64 bit key to a non-null T*.
+ *
+ * Slots are 16 bytes (key, value) in one flat array, a null value marks an
+ * empty slot so every key, 0 included, is usable. Erase uses backward shift
+ * deletion: the entries following the hole are moved up whenever that brings
+ * them closer to their home slot, so there are no tombstones and probe lengths
+ * don't degrade under the add/cancel churn of an order book.
+ *
+ * The table doubles once it is half full; reserve() up front to keep rehashing
+ * off the hot path.
+ */
+template <typename T>
+class FlatIndex {
+public:
+  explicit FlatIndex(std::size_t expected = 1024) { reserve(expected); }
+
+  T* find(uint64_t key) const noexcept {
+    for (std::size_t i = home(key);; i = (i + 1) & m_mask) {
+      const Slot& slot = m_slots[i];
+      if (!slot.value) {
+        return nullptr;
+      }
+      if (slot.key == key) {
+        return slot.value;
+      }
+    }
+  }
+
+  /// false, and the map is left untouched, if key is already present
+  bool insert(uint64_t key, T* value) {
+    if ((m_size + 1) * 2 > m_slots.size()) {
+      rehash(m_slots.size() * 2);
+    }
+    std::size_t i = home(key);
+    for (; m_slots[i].value; i = (i + 1) & m_mask) {
+      if (m_slots[i].key == key) {
+        return false;
+      }
+    }
+    m_slots[i] = Slot{key, value};
+    ++m_size;
+    return true;
+  }
+
+  /// the removed value, nullptr if key wasn't present
+  T* erase(uint64_t key) noexcept {
+    std::size_t hole = home(key);
+    for (;; hole = (hole + 1) & m_mask) {
+      if (!m_slots[hole].value) {
+        return nullptr;
+      }
+      if (m_slots[hole].key == key) {
+        break;
+      }
+    }
+    T* removed = m_slots[hole].value;
+
+    for (std::size_t next = (hole + 1) & m_mask; m_slots[next].value; next = (next + 1) & m_mask) {
+      // move the entry into the hole unless its home lies cyclically in (hole, next]
+      const std::size_t ideal = home(m_slots[next].key);
+      if (((next - ideal) & m_mask) >= ((next - hole) & m_mask)) {
+        m_slots[hole] = m_slots[next];
+        hole = next;
+      }
+    }
+    m_slots[hole] = Slot{};
+    --m_size;
+    return removed;
+  }
+
+  /// Size the table so count entries fit without a rehash
+  void reserve(std::size_t count) {
+    std::size_t capacity = 16;
+    while (capacity < count * 2) {
+      capacity *= 2;
+    }
+    if (capacity > m_slots.size()) {
+      rehash(capacity);
+    }
+  }
+
+  void clear() noexcept {
+    for (Slot& slot : m_slots) {
+      slot = Slot{};
+    }
+    m_size = 0;
+  }
+
+  template <typename Fn>
+  void forEach(Fn&& fn) const {
+    for (const Slot& slot : m_slots) {
+      if (slot.value) {
+        fn(slot.key, slot.value);
+      }
+    }
+  }
+
+  std::size_t size() const noexcept { return m_size; }
+  std::size_t capacity() const noexcept { return m_slots.size(); }
+
+private:
+  struct Slot {
+    uint64_t key = 0;
+    T* value = nullptr;
+  };
+
+  // murmur3 finalizer, exchange order ids carried as doubles leave the low
+  // mantissa bits all zero and would otherwise pile up in a few slots
+  std::size_t home(uint64_t key) const noexcept {
+    key ^= key >> 33;
+    key *= 0xff51afd7ed558ccdULL;
+    key ^= key >> 33;
+    key *= 0xc4ceb9fe1a85ec53ULL;
+    key ^= key >> 33;
+    return static_cast<std::size_t>(key) & m_mask;
+  }
+
+  void rehash(std::size_t capacity) {
+    std::vector<Slot> old(capacity);
+    old.swap(m_slots);
+    m_mask = capacity - 1;
+    for (const Slot& slot : old) {
+      if (slot.value) {
+        std::size_t i = home(slot.key);
+        while (m_slots[i].value) {
+          i = (i + 1) & m_mask;
+        }
+        m_slots[i] = slot;
+      }
+    }
+  }
+
+  std::vector<Slot> m_slots;
+  std::size_t m_mask = 0;
+  std::size_t m_size = 0;
+};
+
+} // namespace elaeo::business::orderbook
+
+#endif // ELAEO_BIZ_ORDERBOOK_FLAT_INDEX_H
@@ -0,0 +1,110 @@
+/**
+ * @file implied.h
+ * @brief spread prices implied by the tops of their outright legs.
+ */
+
+#ifndef ELAEO_BIZ_ORDERBOOK_IMPLIED_H
+#define ELAEO_BIZ_ORDERBOOK_IMPLIED_H
+
+#include <algorithm>
+#include <cstddef>
+#include <cstdint>
+#include <unordered_map>
+#include <vector>
+#include "orderbook/order_book.h"
+
+namespace elaeo::business::orderbook {
+
+/**
+ * @brief Implied top of book of two legged (1:1) spreads, priced as
+ * buy_leg - sell_leg: buying the spread buys buy_leg and sells sell_leg.
+ *
+ *   implied bid = buy_leg bid - sell_leg ask, size min of the two
+ *   implied ask = buy_leg ask - sell_leg bid, size min of the two
+ *
+ * Hook onTopChange() to OrderBook::setTopListener(). A spread is only repriced
+ * when the top of one of its legs moved, from the leg tops the engine already
+ * keeps, so no book is ever rescanned.
+ */
+class ImpliedSpreads {
+public:
+  explicit ImpliedSpreads(const OrderBook& books) : m_books(books) {}
+
+  /// Declare a spread and its legs, before or after their books exist
+  void define(uint32_t spread, uint32_t buy_leg, uint32_t sell_leg) {
+    const auto slot = static_cast<uint32_t>(m_spreads.size());
+    m_spreads.push_back(Spread{spread, buy_leg, sell_leg, nullptr, nullptr, Top{}});
+    m_slots[spread] = slot;
+    m_by_leg[buy_leg].push_back(slot);
+    m_by_leg[sell_leg].push_back(slot);
+    reprice(m_spreads.back());
+  }
+
+  void onTopChange(const Book& book) {
+    if (book.type != BookType::Outright) {
+      return;
+    }
+    auto legs = m_by_leg.find(book.instrument);
+    if (legs == m_by_leg.end()) {
+      return;
+    }
+    for (const uint32_t slot : legs->second) {
+      reprice(m_spreads[slot]);
+    }
+  }
+
+  /// Implied top of a spread, nullptr if it wasn't defined
+  const Top* implied(uint32_t spread) const {
+    auto it = m_slots.find(spread);
+    return it == m_slots.end() ? nullptr : &m_spreads[it->second].implied;
+  }
+
+  /// Number of times any implied top was recomputed
+  uint64_t reprices() const noexcept { return m_reprices; }
+
+private:
+  struct Spread {
+    uint32_t spread;
+    uint32_t buy_leg;
+    uint32_t sell_leg;
+    const Book* buy_book;
+    const Book* sell_book;
+    Top implied;
+  };
+
+  void reprice(Spread& spread) noexcept {
+    ++m_reprices;
+    // leg books are looked up once they exist, they stay put for the engine's lifetime
+    if (!spread.buy_book) {
+      spread.buy_book = m_books.book(spread.buy_leg);
+    }
+    if (!spread.sell_book) {
+      spread.sell_book = m_books.book(spread.sell_leg);
+    }
+
+    Top implied;
+    if (spread.buy_book && spread.sell_book) {
+      const Top& buy = spread.buy_book->top;
+      const Top& sell = spread.sell_book->top;
+      if (buy.bid_quantity && sell.ask_quantity) {
+        implied.bid_price = buy.bid_price - sell.ask_price;
+        implied.bid_quantity = std::min(buy.bid_quantity, sell.ask_quantity);
+      }
+      if (buy.ask_quantity && sell.bid_quantity) {
+        implied.ask_price = buy.ask_price - sell.bid_price;
+        implied.ask_quantity = std::min(buy.ask_quantity, sell.bid_quantity);
+      }
+    }
+    spread.implied = implied;
+  }
+
+  const OrderBook& m_books;
+  std::vector<Spread> m_spreads;
+  std::unordered_map<uint32_t, uint32_t> m_slots;               // spread -> m_spreads slot
+  std::unordered_map<uint32_t, std::vector<uint32_t>> m_by_leg; // leg -> spreads it prices
+  uint64_t m_reprices = 0;
+};
+
+} // namespace elaeo::business::orderbook
+
+#endif // ELAEO_BIZ_ORDERBOOK_IMPLIED_H
@@ -0,0 +1,244 @@
+/**
+ * @file order_book.h
+ * @brief order level (market by order) book engine over many instruments.
+ */
+
+#ifndef ELAEO_BIZ_ORDERBOOK_ORDER_BOOK_H
+#define ELAEO_BIZ_ORDERBOOK_ORDER_BOOK_H
+
+#include <cstddef>
+#include <cstdint>
+#include <functional>
+#include "orderbook/flat_index.h"
+#include "orderbook/price_ladder.h"
+#include "orderbook/slab_pool.h"
+
+namespace elaeo::business::orderbook {
+
+/// Outright and spread (combination) instruments may share numbers, each kind has its own books
+enum class BookType : uint8_t { Outright, Spread };
+
+/// Best bid and ask of a book, a zero quantity means that side is empty
+struct Top {
+  int32_t bid_price = 0;
+  int32_t ask_price = 0;
+  uint64_t bid_quantity = 0;
+  uint64_t ask_quantity = 0;
+
+  bool operator==(const Top& other) const noexcept {
+    return bid_price == other.bid_price && ask_price == other.ask_price && bid_quantity == other.bid_quantity &&
+           ask_quantity == other.ask_quantity;
+  }
+  bool operator!=(const Top& other) const noexcept { return !(*this == other); }
+};
+
+struct Book {
+  Book(uint32_t instrument, BookType type) : instrument(instrument), type(type) {}
+
+  uint32_t instrument;
+  BookType type;
+  PriceLadder bids{Side::Buy};
+  PriceLadder asks{Side::Sell};
+  Top top; ///< kept current by the engine after every event on the book
+
+  PriceLadder& ladder(Side side) noexcept { return side == Side::Buy ? bids : asks; }
+  const PriceLadder& ladder(Side side) const noexcept { return side == Side::Buy ? bids : asks; }
+};
+
+/**
+ * @brief Builds order level books from an add / modify / cancel / execute feed.
+ *
+ * Orders, levels and books come from slab pools and orders are found through a
+ * flat open addressing index keyed on the exchange order id, so steady state
+ * processing does no allocation and at most one hash probe sequence per event.
+ * Exchange specific decoding lives with the feed handler, which maps its
+ * messages onto these calls. Spread books live in the same engine, sharing
+ * its pools and order index.
+ *
+ * Every event refreshes the top of the book it touched; the top listener is
+ * only called when that actually changed, which is what derived prices such as
+ * ImpliedSpreads hang off.
+ *
+ * Single threaded: feed it from one thread and read books from that thread.
+ */
+class OrderBook {
+public:
+  enum class Result : uint8_t {
+    Ok,
+    Duplicate,    ///< add of an order id already in the book
+    UnknownOrder, ///< modify / cancel / execute of an order id that isn't
+  };
+
+  using TopListener = std::function<void(const Book&)>;
+
+  explicit OrderBook(std::size_t expected_orders = std::size_t{1} << 20, std::size_t expected_instruments = 4096)
+      : m_index(expected_orders), m_book_index(expected_instruments) {
+    m_orders.reserve(expected_orders);
+  }
+
+  OrderBook(const OrderBook&) = delete;
+  OrderBook& operator=(const OrderBook&) = delete;
+
+  // orders and levels are trivially destructible and go with their slabs, books own ladder storage
+  ~OrderBook() {
+    m_book_index.forEach([this](uint64_t, Book* book) { m_books.destroy(book); });
+  }
+
+  Result add(uint64_t id, uint32_t instrument, Side side, int32_t price, uint32_t quantity,
+             BookType type = BookType::Outright) {
+    if (m_index.find(id)) {
+      return Result::Duplicate;
+    }
+    Book& book = bookFor(instrument, type);
+    Order* order = m_orders.create(Order{id, instrument, price, quantity, side, &book, nullptr, nullptr, nullptr});
+    m_index.insert(id, order);
+    book.ladder(side).level(price, m_levels)->push(order);
+    refreshTop(book);
+    return Result::Ok;
+  }
+
+  /// add() for bulk loads, e.g. a snapshot: tops aren't refreshed per order,
+  /// call refreshTops() once the whole batch is in
+  Result load(uint64_t id, uint32_t instrument, Side side, int32_t price, uint32_t quantity,
+              BookType type = BookType::Outright) {
+    if (m_index.find(id)) {
+      return Result::Duplicate;
+    }
+    Book& book = bookFor(instrument, type);
+    Order* order = m_orders.create(Order{id, instrument, price, quantity, side, &book, nullptr, nullptr, nullptr});
+    m_index.insert(id, order);
+    book.ladder(side).level(price, m_levels)->push(order);
+    return Result::Ok;
+  }
+
+  /// Bring every book's top up to date, the listener sees those that changed
+  void refreshTops() {
+    m_book_index.forEach([this](uint64_t, Book* book) { refreshTop(*book); });
+  }
+
+  /// A price change or quantity increase loses time priority, a decrease keeps it
+  Result modify(uint64_t id, int32_t price, uint32_t quantity) {
+    Order* order = m_index.find(id);
+    if (!order) {
+      return Result::UnknownOrder;
+    }
+    Book& book = *order->book;
+    Level* level = order->level;
+    if (price == order->price && quantity <= order->quantity) {
+      level->quantity -= order->quantity - quantity;
+      order->quantity = quantity;
+      refreshTop(book);
+      return Result::Ok;
+    }
+
+    PriceLadder& ladder = book.ladder(order->side);
+    level->unlink(order);
+    order->price = price;
+    order->quantity = quantity;
+    ladder.level(price, m_levels)->push(order);
+    if (level->empty()) {
+      ladder.remove(level, m_levels);
+    }
+    refreshTop(book);
+    return Result::Ok;
+  }
+
+  Result cancel(uint64_t id) {
+    Order* order = m_index.erase(id);
+    if (!order) {
+      return Result::UnknownOrder;
+    }
+    release(order);
+    return Result::Ok;
+  }
+
+  /// A fill of quantity against a resting order, the order leaves the book once fully filled
+  Result execute(uint64_t id, uint32_t quantity) {
+    Order* order = m_index.find(id);
+    if (!order) {
+      return Result::UnknownOrder;
+    }
+    if (quantity < order->quantity) {
+      order->quantity -= quantity;
+      order->level->quantity -= quantity;
+      refreshTop(*order->book);
+      return Result::Ok;
+    }
+    m_index.erase(id);
+    release(order);
+    return Result::Ok;
+  }
+
+  const Book* book(uint32_t instrument, BookType type = BookType::Outright) const noexcept {
+    return m_book_index.find(bookKey(instrument, type));
+  }
+  const Order* order(uint64_t id) const noexcept { return m_index.find(id); }
+
+  std::size_t orders() const noexcept { return m_index.size(); }
+  std::size_t instruments() const noexcept { return m_book_index.size(); }
+
+  /// Presize pools and indexes, e.g. ahead of loading a snapshot
+  void reserve(std::size_t orders, std::size_t instruments) {
+    m_orders.reserve(orders);
+    m_index.reserve(orders);
+    m_book_index.reserve(instruments);
+  }
+
+  /// Called after any event that changed a book's best price or quantity
+  void setTopListener(TopListener listener) { m_top_listener = std::move(listener); }
+
+private:
+  static uint64_t bookKey(uint32_t instrument, BookType type) noexcept {
+    return uint64_t{static_cast<uint8_t>(type)} << 32 | instrument;
+  }
+
+  Book& bookFor(uint32_t instrument, BookType type) {
+    const uint64_t key = bookKey(instrument, type);
+    if (Book* book = m_book_index.find(key)) {
+      return *book;
+    }
+    Book* book = m_books.create(instrument, type);
+    m_book_index.insert(key, book);
+    return *book;
+  }
+
+  void refreshTop(Book& book) {
+    Top top;
+    if (const Level* bid = book.bids.best()) {
+      top.bid_price = bid->price;
+      top.bid_quantity = bid->quantity;
+    }
+    if (const Level* ask = book.asks.best()) {
+      top.ask_price = ask->price;
+      top.ask_quantity = ask->quantity;
+    }
+    if (top != book.top) {
+      book.top = top;
+      if (m_top_listener) {
+        m_top_listener(book);
+      }
+    }
+  }
+
+  void release(Order* order) {
+    Book& book = *order->book;
+    Level* level = order->level;
+    level->unlink(order);
+    if (level->empty()) {
+      book.ladder(order->side).remove(level, m_levels);
+    }
+    m_orders.destroy(order);
+    refreshTop(book);
+  }
+
+  SlabPool<Order> m_orders;
+  SlabPool<Level> m_levels;
+  SlabPool<Book, 256> m_books;
+  FlatIndex<Order> m_index;
+  FlatIndex<Book> m_book_index;
+  TopListener m_top_listener;
+};
+
+} // namespace elaeo::business::orderbook
+
+#endif // ELAEO_BIZ_ORDERBOOK_ORDER_BOOK_H
@@ -0,0 +1,138 @@
+/**
+ * @file price_ladder.h
+ * @brief order nodes, price levels and the per side ladder holding them.
+ */
+
+#ifndef ELAEO_BIZ_ORDERBOOK_PRICE_LADDER_H
+#define ELAEO_BIZ_ORDERBOOK_PRICE_LADDER_H
+
+#include <algorithm>
+#include <cstddef>
+#include <cstdint>
+#include <vector>
+#include "orderbook/slab_pool.h"
+
+namespace elaeo::business::orderbook {
+
+enum class Side : uint8_t { Buy, Sell };
+
+struct Book;
+struct Level;
+
+/**
+ * @brief A resting order. Lives in the engine's SlabPool and is linked into the
+ * FIFO of its price level, so a cancel or fill never searches for it.
+ */
+struct Order {
+  uint64_t id;
+  uint32_t instrument;
+  int32_t price;
+  uint32_t quantity;
+  Side side;
+  Book* book;
+  Level* level;
+  Order* prev;
+  Order* next;
+};
+
+/**
+ * @brief Aggregate of all orders at one price, orders kept in time priority.
+ */
+struct Level {
+  int32_t price;
+  uint32_t count;
+  uint64_t quantity;
+  Order* head;
+  Order* tail;
+
+  void push(Order* order) noexcept {
+    order->level = this;
+    order->prev = tail;
+    order->next = nullptr;
+    (tail ? tail->next : head) = order;
+    tail = order;
+    ++count;
+    quantity += order->quantity;
+  }
+
+  void unlink(Order* order) noexcept {
+    (order->prev ? order->prev->next : head) = order->next;
+    (order->next ? order->next->prev : tail) = order->prev;
+    order->prev = order->next = nullptr;
+    order->level = nullptr;
+    --count;
+    quantity -= order->quantity;
+  }
+
+  bool empty() const noexcept { return count == 0; }
+};
+
+/**
+ * @brief Price levels of one side of a book, sorted worst to best so the top of
+ * book is at the back of the vector. Book activity clusters around the touch,
+ * which makes inserting and dropping levels there a short move of pointers.
+ * Lookups binary search a parallel array of the levels' ranks, so finding a
+ * price touches contiguous memory rather than one level per probe.
+ */
+class PriceLadder {
+public:
+  explicit PriceLadder(Side side) : m_side(side) {}
+
+  Side side() const noexcept { return m_side; }
+  bool empty() const noexcept { return m_levels.empty(); }
+  std::size_t depth() const noexcept { return m_levels.size(); }
+
+  const Level* best() const noexcept { return m_levels.empty() ? nullptr : m_levels.back(); }
+
+  /// nth level from the top of book, nullptr past the last one
+  const Level* at(std::size_t n) const noexcept {
+    return n < m_levels.size() ? m_levels[m_levels.size() - 1 - n] : nullptr;
+  }
+
+  /// The level at price, created empty if there is none
+  Level* level(int32_t price, SlabPool<Level>& pool) {
+    const int64_t target = rank(price);
+    const std::size_t pos = position(target);
+    if (pos < m_ranks.size() && m_ranks[pos] == target) {
+      return m_levels[pos];
+    }
+    m_ranks.insert(m_ranks.begin() + pos, target);
+    return *m_levels.insert(m_levels.begin() + pos, pool.create(Level{price, 0, 0, nullptr, nullptr}));
+  }
+
+  /// Drop an emptied level and give it back to the pool
+  void remove(Level* level, SlabPool<Level>& pool) noexcept {
+    if (!m_levels.empty() && m_levels.back() == level) {
+      m_levels.pop_back();
+      m_ranks.pop_back();
+    } else {
+      const std::size_t pos = position(rank(level->price));
+      m_levels.erase(m_levels.begin() + pos);
+      m_ranks.erase(m_ranks.begin() + pos);
+    }
+    pool.destroy(level);
+  }
+
+  template <typename Fn>
+  void forEach(Fn&& fn) const {
+    for (auto it = m_levels.rbegin(); it != m_levels.rend(); ++it) {
+      fn(**it);
+    }
+  }
+
+private:
+  // bids rank by price, asks by negated price, larger rank is the better price
+  int64_t rank(int32_t price) const noexcept { return m_side == Side::Buy ? price : -int64_t{price}; }
+
+  std::size_t position(int64_t target) const noexcept {
+    return static_cast<std::size_t>(std::lower_bound(m_ranks.begin(), m_ranks.end(), target) - m_ranks.begin());
+  }
+
+  Side m_side;
+  std::vector<Level*> m_levels;
+  std::vector<int64_t> m_ranks; ///< rank of each level in m_levels, same order
+};
+
+} // namespace elaeo::business::orderbook
+
+#endif // ELAEO_BIZ_ORDERBOOK_PRICE_LADDER_H
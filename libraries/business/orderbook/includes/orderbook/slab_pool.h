@@ -0,0 +1,84 @@
+/**
+ * @file slab_pool.h
+ * @brief fixed size object pool carved out of large slabs.
+ */
+
+#ifndef ELAEO_BIZ_ORDERBOOK_SLAB_POOL_H
+#define ELAEO_BIZ_ORDERBOOK_SLAB_POOL_H
+
+#include <cstddef>
+#include <memory>
+#include <new>
+#include <utility>
+#include <vector>
+
+namespace elaeo::business::orderbook {
+
+/**
+ * @brief Hands out T-sized slots from slabs of SlabSize objects and keeps freed
+ * slots on an intrusive free list. Objects never move and memory is only given
+ * back when the pool is destroyed, so the hot path is a pointer pop/push with no
+ * trip to the allocator once the pool has warmed up (or was reserve()d).
+ *
+ * Not thread safe, one pool per book engine.
+ */
+template <typename T, std::size_t SlabSize = 4096>
+class SlabPool {
+public:
+  SlabPool() = default;
+  SlabPool(const SlabPool&) = delete;
+  SlabPool& operator=(const SlabPool&) = delete;
+
+  template <typename... Args>
+  T* create(Args&&... args) {
+    if (!m_free) {
+      grow();
+    }
+    Slot* slot = m_free;
+    m_free = slot->next;
+    ++m_live;
+    return ::new (static_cast<void*>(slot->storage)) T{std::forward<Args>(args)...};
+  }
+
+  void destroy(T* object) noexcept {
+    object->~T();
+    Slot* slot = reinterpret_cast<Slot*>(object);
+    slot->next = m_free;
+    m_free = slot;
+    --m_live;
+  }
+
+  /// Make sure count objects can be live without allocating again
+  void reserve(std::size_t count) {
+    while (capacity() < count) {
+      grow();
+    }
+  }
+
+  std::size_t size() const noexcept { return m_live; }
+  std::size_t capacity() const noexcept { return m_slabs.size() * SlabSize; }
+
+private:
+  union Slot {
+    Slot* next;
+    alignas(T) unsigned char storage[sizeof(T)];
+  };
+
+  void grow() {
+    m_slabs.push_back(std::make_unique<Slot[]>(SlabSize));
+    Slot* slab = m_slabs.back().get();
+    // thread the new slab in address order so fresh objects are handed out sequentially
+    for (std::size_t i = SlabSize; i-- > 0;) {
+      slab[i].next = m_free;
+      m_free = &slab[i];
+    }
+  }
+
+  std::vector<std::unique_ptr<Slot[]>> m_slabs;
+  Slot* m_free = nullptr;
+  std::size_t m_live = 0;
+};
+
+} // namespace elaeo::business::orderbook
+
+#endif // ELAEO_BIZ_ORDERBOOK_SLAB_POOL_H
@@ -15,7 +15,7 @@ namespace elaeo::comm::events{
  * @tparam  Event
  */
 template <typename Event>
-concept EventType = std::is_trivially_copyable<Event>() && std::is_move_assignable<Event>();
+concept EventType = std::is_trivially_copyable_v<Event> && std::is_move_assignable_v<Event>;
 
 // typename <EventType Event>
 // class EventCallback{
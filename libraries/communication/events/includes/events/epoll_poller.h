@@ -0,0 +1,135 @@
+/**
+ * @file epoll_poller.h
+ * @brief epoll backed poller dispatching ready FDEventSources in batches.
+ */
+
+#ifndef ELAEO_COMM_EVENTS_EPOLL_POLLER_H
+#define ELAEO_COMM_EVENTS_EPOLL_POLLER_H
+
+#include <algorithm>
+#include <cerrno>
+#include <cstddef>
+#include <cstdint>
+#include <system_error>
+#include <vector>
+#include <sys/epoll.h>
+#include <unistd.h>
+#include <events/fd_source.h>
+
+namespace elaeo::comm::events {
+
+enum class Trigger : std::uint8_t {
+    Level,   // reported for as long as the fd is ready
+    Edge     // reported once per readiness change, the source drains the fd
+};
+
+/**
+ * @brief One epoll set. poll() makes a single epoll_wait for up to
+ * max_events fds and calls read() / write() on each ready source before
+ * returning. A zero timeout never sleeps, for busy polling loops on a
+ * dedicated core; a positive one (ms) or -1 (forever) parks the thread until
+ * something is ready.
+ *
+ * Sources are referenced, not owned, and may be added or removed from inside
+ * their own callbacks. Not thread safe, one poller per loop.
+ */
+class EpollPoller {
+public:
+    explicit EpollPoller(int timeout_ms = 0, std::size_t max_events = 64)
+        : epoll_fd_(::epoll_create1(EPOLL_CLOEXEC)), timeout_ms_(timeout_ms), events_(std::max<std::size_t>(max_events, 1)) {
+        if (epoll_fd_ < 0) {
+            throw std::system_error(errno, std::generic_category(), "epoll_create1");
+        }
+    }
+    EpollPoller(const EpollPoller&) = delete;
+    EpollPoller& operator=(const EpollPoller&) = delete;
+    ~EpollPoller() { ::close(epoll_fd_); }
+
+    // Watch source for readability (and writability if asked); false with errno set on failure
+    bool add(FDEventSource& source, bool writable = false, Trigger trigger = Trigger::Level) {
+        epoll_event event = makeEvent(source, writable, trigger);
+        if (::epoll_ctl(epoll_fd_, EPOLL_CTL_ADD, source.getFD(), &event) != 0) {
+            return false;
+        }
+        ++registered_;
+        return true;
+    }
+
+    // Change what source is watched for, e.g. writability only while output is queued
+    bool modify(FDEventSource& source, bool writable, Trigger trigger = Trigger::Level) {
+        epoll_event event = makeEvent(source, writable, trigger);
+        return ::epoll_ctl(epoll_fd_, EPOLL_CTL_MOD, source.getFD(), &event) == 0;
+    }
+
+    bool remove(FDEventSource& source) {
+        if (::epoll_ctl(epoll_fd_, EPOLL_CTL_DEL, source.getFD(), nullptr) != 0) {
+            return false;
+        }
+        --registered_;
+        if (dispatching_) {
+            removed_.push_back(&source); // may still be further down the current batch
+        }
+        return true;
+    }
+
+    // One epoll_wait with the configured timeout and dispatch; true if anything was ready
+    bool poll() { return poll(timeout_ms_) > 0; }
+
+    // One epoll_wait with this timeout and dispatch; the number of ready fds
+    std::size_t poll(int timeout_ms) {
+        const int ready = ::epoll_wait(epoll_fd_, events_.data(), static_cast<int>(events_.size()), timeout_ms);
+        ready_ = ready > 0 ? static_cast<std::size_t>(ready) : 0; // EINTR counts as nothing ready
+        dispatching_ = true;
+        for (std::size_t i = 0; i < ready_; ++i) {
+            dispatch(events_[i]);
+        }
+        dispatching_ = false;
+        removed_.clear();
+        return ready_;
+    }
+
+    void setTimeout(int timeout_ms) noexcept { timeout_ms_ = timeout_ms; }
+    int timeout() const noexcept { return timeout_ms_; }
+
+    // fds reported by the last poll()
+    std::size_t readyCount() const noexcept { return ready_; }
+    std::size_t size() const noexcept { return registered_; }
+
+private:
+    static epoll_event makeEvent(FDEventSource& source, bool writable, Trigger trigger) {
+        epoll_event event{};
+        event.events = EPOLLIN | EPOLLRDHUP | (writable ? EPOLLOUT : 0u) | (trigger == Trigger::Edge ? EPOLLET : 0u);
+        event.data.ptr = &source;
+        return event;
+    }
+
+    void dispatch(const epoll_event& event) {
+        auto* source = static_cast<FDEventSource*>(event.data.ptr);
+        if (!removed_.empty() && std::find(removed_.begin(), removed_.end(), source) != removed_.end()) {
+            return;
+        }
+        bool keep = true;
+        if (event.events & (EPOLLIN | EPOLLRDHUP | EPOLLHUP | EPOLLERR)) {
+            keep = source->read();
+        }
+        if (keep && (event.events & EPOLLOUT) &&
+            (removed_.empty() || std::find(removed_.begin(), removed_.end(), source) == removed_.end())) {
+            keep = source->write();
+        }
+        if (!keep) {
+            remove(*source);
+        }
+    }
+
+    int epoll_fd_;
+    int timeout_ms_;
+    std::vector<epoll_event> events_;
+    std::size_t ready_ = 0;
+    std::size_t registered_ = 0;
+    bool dispatching_ = false;
+    std::vector<FDEventSource*> removed_;   // during this batch
+};
+
+} // namespace elaeo::comm::events
+
+#endif // ELAEO_COMM_EVENTS_EPOLL_POLLER_H
@@ -1,12 +1,29 @@
+/**
+ * @file eventslib.h
+ * @brief event sources and the event loop driving them.
+ */
+
+#ifndef ELAEO_COMM_EVENTS_EVENTSLIB_H
+#define ELAEO_COMM_EVENTS_EVENTSLIB_H
+
+#include <algorithm>
+#include <chrono>
 #include <concepts>
-#include <functional>
 #include <memory>
 #include <vector>
 #include <coroutine>
 #include <atomic>
-#include <queue>
-#include <poll.h>
-#include <boost/asio.hpp>
+#include <cerrno>
+#include <exception>
+#include <system_error>
+#include <thread>
+#include <utility>
+#include <events/epoll_poller.h>
+#include <events/fd_source.h>
+#include <events/publisher.h>
+#include <events/task.h>
+#include <events/timing_wheel.h>
+#include <events/work_queue.h>
 
 namespace elaeo::comm::events {
 
@@ -16,12 +33,6 @@ concept EventSource = requires(T t) {
     { t.poll() } -> std::same_as<bool>;
 };
 
-// Concept for event callbacks
-template <typename T, typename Event>
-concept EventCallback = requires(T t, const Event& event) {
-    { t.handleEvent(event) } -> std::same_as<void>;
-};
-
 // PollingEventSource using concepts
 class PollingEventSource {
 public:
@@ -29,80 +40,192 @@ public:
     virtual ~PollingEventSource() = default;
 };
 
-// FDEventSource using concepts
-class FDEventSource {
-public:
-    virtual int getFD() = 0;
-    virtual bool read() = 0;
-    virtual bool write() = 0;
-    virtual ~FDEventSource() = default;
-};
-
-// EventCallback using concepts
-template <typename Event>
-class EventCallbackBase {
-public:
-    virtual void handleEvent(const Event& event) = 0;
-    virtual ~EventCallbackBase() = default;
-};
-
-// LambdaCallback using concepts and modern C++
-template <typename Event, std::invocable<const Event&> Callback>
-class LambdaCallback : public EventCallbackBase<Event> {
+// BaseEventLoop using coroutines and modern C++. Each iteration polls the fd
+// sources once, through epoll by default, fires the timers that are due,
+// resumes the coroutines queued for it and runs the posted tasks. The
+// poller's timeout decides whether an idle loop spins or parks; a parked loop
+// wakes up for its next timer, or when a task is posted or the loop stopped.
+//
+// Coroutines are Tasks spawn()ed on the loop; they wait with co_await on
+// nextIteration(), sleep() and readable(). The awaiters live in the
+// coroutine's frame and the frames in the loop's arena, so suspending and
+// resuming never allocates. Everything runs on the loop's thread, except
+// post() and stop() which other threads may call.
+template <EventSource FDEventSourcePoller = EpollPoller>
+class BaseEventLoop : private TaskPromiseBase::Detacher {
 public:
-    explicit LambdaCallback(Callback&& callback) : callback_(std::move(callback)) {}
-    void handleEvent(const Event& event) override { callback_(event); }
+    // tasks posted and not run yet, beyond that post() fails
+    static constexpr std::size_t POST_CAPACITY = 1024;
 
-private:
-    Callback callback_;
-};
+    BaseEventLoop() { watchWakeup(); }
+    // arguments for the poller, e.g. the epoll timeout
+    template <typename... Args>
+    explicit BaseEventLoop(Args&&... args) : fd_event_source_poller_(std::forward<Args>(args)...) {
+        watchWakeup();
+    }
+    ~BaseEventLoop() {
+        shutdown();
+        // unwind the tasks still suspended while the timers and sources they wait on exist
+        while (detached_) {
+            TaskPromiseBase* promise = detached_;
+            unlinkDetached(*promise);
+            promise->start_.handle.destroy();
+        }
+    }
 
-// EventPublisher using modern C++
-template <typename Event>
-class EventPublisher {
-public:
-    using CallbackPtr = std::shared_ptr<EventCallbackBase<Event>>;
+    // stop_when_empty: return once an iteration finds nothing to do, no timer
+    // is armed and no coroutine or task is queued; such a loop never parks
+    // once idle. Rethrows what a spawned task threw. A stop() made before the
+    // call still applies and ends it at once.
+    void loop(bool stop_when_empty = true) {
+        FrameArena::Scope arena(frames_);
+        while (!stopped_) {
+            bool processed = pollSources(stop_when_empty);
+            processed = timers_.advance() > 0 || processed;
+            processed = resumeQueued() || processed;
+            processed = posted_.runAll() > 0 || processed;
 
-    subscription_t registerCallback(CallbackPtr callback, priority_t priority = 0) {
-        callbacks_.emplace_back(std::make_pair(priority, std::move(callback)));
-        std::sort(callbacks_.begin(), callbacks_.end(), [](const auto& a, const auto& b) {
-            return a.first > b.first;
-        });
-        return next_subscription_id_++;
+            if (failure_) {
+                std::rethrow_exception(std::exchange(failure_, nullptr));
+            }
+            if (!processed && stop_when_empty && idle()) {
+                return;
+            }
+        }
+        stopped_ = false; // the stop is used up, the loop can run again
     }
 
-    void publishEvent(const Event& event) {
-        for (const auto& [priority, callback] : callbacks_) {
-            callback->handleEvent(event);
+    // Run task on the loop, starting on the next iteration; the loop owns it
+    // from now on and frees it when it ends
+    template <typename T>
+    void spawn(Task<T> task) {
+        const auto handle = task.release();
+        if (!handle) {
+            return;
         }
+        TaskPromiseBase& promise = handle.promise();
+        promise.detached_ = this;
+        promise.next_detached_ = detached_;
+        promise.prev_detached_ = &detached_;
+        if (detached_) {
+            detached_->prev_detached_ = &promise.next_detached_;
+        }
+        detached_ = &promise;
+        promise.start_.handle = handle;
+        enqueue(promise.start_);
     }
 
-private:
-    std::vector<std::pair<priority_t, CallbackPtr>> callbacks_;
-    subscription_t next_subscription_id_{1};
-};
+    // co_await: resume on the next iteration, letting everything else ready run first
+    auto nextIteration() noexcept {
+        struct Awaiter {
+            BaseEventLoop& loop;
+            Resumable node;
+            bool await_ready() noexcept { return false; }
+            void await_suspend(std::coroutine_handle<> handle) noexcept {
+                node.handle = handle;
+                loop.enqueue(node);
+            }
+            void await_resume() noexcept {}
+        };
+        return Awaiter{*this, {}};
+    }
 
-// BaseEventLoop using coroutines and modern C++
-template <EventSource FDEventSourcePoller>
-class BaseEventLoop {
-public:
-    BaseEventLoop() = default;
-    ~BaseEventLoop() { shutdown(); }
+    // co_await: resume once delay has passed, on the loop's timing wheel
+    auto sleep(std::chrono::nanoseconds delay) noexcept {
+        class Awaiter : public Timer {
+        public:
+            Awaiter(BaseEventLoop& loop, std::chrono::nanoseconds delay) noexcept
+                : Timer(&Awaiter::fire), loop_(loop), delay_(delay) {}
+            bool await_ready() noexcept { return false; }
+            void await_suspend(std::coroutine_handle<> handle) noexcept {
+                handle_ = handle;
+                loop_.schedule(*this, delay_);
+            }
+            void await_resume() noexcept {}
 
-    void loop(bool stop_when_empty = true) {
-        while (!stopped_) {
-            bool processed = poll();
-            processed = fd_event_source_poller_.poll([this] { fireDeferreds(); }) || processed;
-            fireDeferreds();
-            executeMainThreadTasks();
+        private:
+            static void fire(Timer& timer) { static_cast<Awaiter&>(timer).handle_.resume(); }
+
+            BaseEventLoop& loop_;
+            std::chrono::nanoseconds delay_;
+            std::coroutine_handle<> handle_;
+        };
+        return Awaiter{*this, delay};
+    }
+
+    // co_await: resume once fd is readable (or hung up). Yields false, with
+    // errno set, if the fd couldn't be watched.
+    auto readable(int fd) noexcept {
+        class Awaiter : public FDEventSource {
+        public:
+            Awaiter(BaseEventLoop& loop, int fd) noexcept : loop_(loop), fd_(fd) {}
+            Awaiter(const Awaiter&) = delete;
+            Awaiter& operator=(const Awaiter&) = delete;
+            ~Awaiter() override {
+                if (watching_) {
+                    loop_.poller().remove(*this); // the coroutine was destroyed while waiting
+                }
+            }
 
-            if (!processed && stop_when_empty) {
-                stopped_ = true;
+            bool await_ready() noexcept { return false; }
+            bool await_suspend(std::coroutine_handle<> handle) noexcept {
+                handle_ = handle;
+                watching_ = loop_.poller().add(*this);
+                return watching_; // not suspending at all if it failed
             }
+            bool await_resume() noexcept { return ok_; }
+
+            int getFD() override { return fd_; }
+            bool read() override {
+                // unregister before resuming, the coroutine may end and take us with it
+                loop_.poller().remove(*this);
+                watching_ = false;
+                ok_ = true;
+                handle_.resume();
+                return true;
+            }
+            bool write() override { return true; }
+
+        private:
+            BaseEventLoop& loop_;
+            int fd_;
+            std::coroutine_handle<> handle_;
+            bool watching_ = false;
+            bool ok_ = false;
+        };
+        return Awaiter{*this, fd};
+    }
+
+    // Frames of tasks that take the loop as an argument come from here
+    FrameArena& frameArena() noexcept { return frames_; }
+
+    // Fire timer after delay on this loop, moving it if it was already armed
+    void schedule(Timer& timer, std::chrono::nanoseconds delay) noexcept { timers_.schedule(timer, delay); }
+    void cancel(Timer& timer) noexcept { timers_.cancel(timer); }
+
+    // Leave loop() after the current iteration, or as soon as it's entered if
+    // it isn't running; from any thread
+    void stop() {
+        stopped_ = true;
+        wake();
+    }
+
+    // Run task on the loop's next iteration; from any thread, without locking
+    // or allocating. The task is kept inline in the queue's slot, so what it
+    // captures must fit in 48 bytes (checked at compile time). False, and task
+    // dropped, if POST_CAPACITY tasks are already waiting.
+    template <typename F>
+    bool post(F&& task) {
+        if (!posted_.tryPush(std::forward<F>(task))) {
+            return false;
         }
-        executeMainThreadTasks();
+        wake();
+        return true;
     }
 
+    FDEventSourcePoller& poller() { return fd_event_source_poller_; }
+    TimingWheel& timers() { return timers_; }
+
     void shutdown() {
         if (background_thread_.joinable()) {
             background_thread_.join();
@@ -110,11 +233,115 @@ public:
     }
 
 private:
+    // The eventfd a parked loop is woken up by, when the poller takes fds
+    void watchWakeup() {
+        if constexpr (requires(FDEventSourcePoller& poller, FDEventSource& source) { poller.add(source); }) {
+            if (!fd_event_source_poller_.add(wakeup_)) {
+                throw std::system_error(errno, std::generic_category(), "watching the loop's wakeup eventfd");
+            }
+        }
+    }
+
+    // Ring the wakeup if the loop is, or is about to be, parked. Only the
+    // first caller for a park writes the eventfd, a loop that spins or is busy
+    // costs posters no syscall at all.
+    void wake() noexcept {
+        if (parked_.load() && parked_.exchange(false)) {
+            wakeup_.notify();
+        }
+    }
+
+    // No timer armed and nothing queued to run
+    bool idle() const noexcept { return timers_.empty() && !queued_ && posted_.empty(); }
+
+    // A blocking poll mustn't sleep past the next timer, nor at all with tasks
+    // posted or coroutines queued, or when the loop is to stop once idle
+    bool pollSources(bool stop_when_empty) {
+        if constexpr (requires(FDEventSourcePoller& poller) {
+                          { poller.timeout() } -> std::convertible_to<int>;
+                          poller.poll(0);
+                      }) {
+            const int timeout = fd_event_source_poller_.timeout();
+            if (timeout != 0) {
+                int bound = timeout;
+                if (queued_ || (stop_when_empty && idle())) {
+                    bound = 0;
+                } else if (!timers_.empty()) {
+                    const std::uint64_t ns = timers_.ticksToNext() * timers_.tickNs();
+                    const int next = static_cast<int>((ns + 999999) / 1000000); // epoll counts whole ms, round up
+                    bound = timeout < 0 ? next : std::min(timeout, next);
+                }
+                if (bound != 0) {
+                    // announce the park, then look again: a poster either sees
+                    // parked_ and rings, or its task is seen here
+                    parked_.store(true);
+                    if (!posted_.empty() || stopped_) {
+                        bound = 0;
+                    }
+                }
+                const bool ready = fd_event_source_poller_.poll(bound) > 0;
+                parked_.store(false, std::memory_order_relaxed);
+                return ready;
+            }
+        }
+        return fd_event_source_poller_.poll();
+    }
+
+    void enqueue(Resumable& node) noexcept {
+        node.next = nullptr;
+        *queued_tail_ = &node;
+        queued_tail_ = &node.next;
+        queued_ = true;
+    }
+
+    // Resume the coroutines queued so far, ones they queue wait for the next iteration
+    bool resumeQueued() {
+        if (!queued_) {
+            return false;
+        }
+        Resumable* node = queued_head_;
+        queued_head_ = nullptr;
+        queued_tail_ = &queued_head_;
+        queued_ = false;
+        while (node) {
+            Resumable* next = node->next; // node lives in the frame we resume
+            node->handle.resume();
+            node = next;
+        }
+        return true;
+    }
+
+    void unlinkDetached(TaskPromiseBase& promise) noexcept {
+        *promise.prev_detached_ = promise.next_detached_;
+        if (promise.next_detached_) {
+            promise.next_detached_->prev_detached_ = promise.prev_detached_;
+        }
+    }
+
+    void finished(TaskPromiseBase& promise) noexcept override {
+        unlinkDetached(promise);
+        if (promise.exception_ && !failure_) {
+            failure_ = promise.exception_;
+        }
+    }
+
     std::atomic<bool> stopped_{false};
     std::thread background_thread_;
     FDEventSourcePoller fd_event_source_poller_;
-    std::queue<std::function<void()>> deferred_queue_;
-    std::atomic<bool> deferred_queue_empty_{true};
+    TimingWheel timers_;
+    // posting, from other threads
+    WorkQueue<POST_CAPACITY> posted_;
+    EventFd wakeup_;
+    alignas(CACHE_LINE_SIZE) std::atomic<bool> parked_{false};
+    // coroutines
+    FrameArena frames_;
+    Resumable* queued_head_ = nullptr;
+    Resumable** queued_tail_ = &queued_head_;
+    bool queued_ = false;
+    TaskPromiseBase* detached_ = nullptr;   // spawned and not finished
+    std::exception_ptr failure_;
 };
 
 } // namespace elaeo::comm::events
+
+#endif // ELAEO_COMM_EVENTS_EVENTSLIB_H
@@ -0,0 +1,132 @@
+/**
+ * @file fd_source.h
+ * @brief file descriptor event sources: the interface, eventfd and timerfd.
+ */
+
+#ifndef ELAEO_COMM_EVENTS_FD_SOURCE_H
+#define ELAEO_COMM_EVENTS_FD_SOURCE_H
+
+#include <cerrno>
+#include <chrono>
+#include <cstdint>
+#include <functional>
+#include <system_error>
+#include <utility>
+#include <sys/eventfd.h>
+#include <sys/timerfd.h>
+#include <unistd.h>
+
+namespace elaeo::comm::events {
+
+/**
+ * @brief Something a poller watches by its fd. read() / write() are called
+ * when the fd is readable / writable (errors and hangups count as readable,
+ * so read() sees them); return false to have the source unregistered. Under
+ * edge triggering they must drain the fd until EAGAIN.
+ */
+class FDEventSource {
+public:
+    virtual int getFD() = 0;
+    virtual bool read() = 0;
+    virtual bool write() = 0;
+    virtual ~FDEventSource() = default;
+};
+
+// Owns a non blocking fd, closes it on destruction
+class OwnedFDEventSource : public FDEventSource {
+public:
+    OwnedFDEventSource(const OwnedFDEventSource&) = delete;
+    OwnedFDEventSource& operator=(const OwnedFDEventSource&) = delete;
+    ~OwnedFDEventSource() override {
+        if (fd_ >= 0) {
+            ::close(fd_);
+        }
+    }
+
+    int getFD() override { return fd_; }
+    bool write() override { return true; }
+
+protected:
+    explicit OwnedFDEventSource(int fd, const char* what) : fd_(fd) {
+        if (fd_ < 0) {
+            throw std::system_error(errno, std::generic_category(), what);
+        }
+    }
+
+    int fd_;
+};
+
+/**
+ * @brief eventfd counter, a cross thread doorbell. notify() may be called from
+ * any thread; the loop that watches it runs the callback with the number of
+ * notifications since the last time.
+ */
+class EventFd : public OwnedFDEventSource {
+public:
+    using Callback = std::function<void(std::uint64_t)>;
+
+    explicit EventFd(Callback callback = {})
+        : OwnedFDEventSource(::eventfd(0, EFD_NONBLOCK | EFD_CLOEXEC), "eventfd"), callback_(std::move(callback)) {}
+
+    void notify(std::uint64_t count = 1) noexcept {
+        [[maybe_unused]] const ssize_t written = ::write(fd_, &count, sizeof(count));
+    }
+
+    bool read() override {
+        std::uint64_t count = 0;
+        if (::read(fd_, &count, sizeof(count)) == sizeof(count) && callback_) {
+            callback_(count);
+        }
+        return true;
+    }
+
+private:
+    Callback callback_;
+};
+
+/**
+ * @brief timerfd on the monotonic clock. The callback gets the number of
+ * expirations since the last time, more than one if the loop fell behind.
+ */
+class TimerFd : public OwnedFDEventSource {
+public:
+    using Callback = std::function<void(std::uint64_t)>;
+
+    explicit TimerFd(Callback callback = {})
+        : OwnedFDEventSource(::timerfd_create(CLOCK_MONOTONIC, TFD_NONBLOCK | TFD_CLOEXEC), "timerfd"),
+          callback_(std::move(callback)) {}
+
+    // First expiry after initial, then every interval (zero = once); false on failure
+    bool arm(std::chrono::nanoseconds initial, std::chrono::nanoseconds interval = {}) noexcept {
+        // an all zero value would disarm
+        if (initial.count() <= 0) {
+            initial = std::chrono::nanoseconds(1);
+        }
+        const itimerspec spec{toTimespec(interval), toTimespec(initial)};
+        return ::timerfd_settime(fd_, 0, &spec, nullptr) == 0;
+    }
+
+    bool disarm() noexcept {
+        const itimerspec spec{};
+        return ::timerfd_settime(fd_, 0, &spec, nullptr) == 0;
+    }
+
+    bool read() override {
+        std::uint64_t expirations = 0;
+        if (::read(fd_, &expirations, sizeof(expirations)) == sizeof(expirations) && callback_) {
+            callback_(expirations);
+        }
+        return true;
+    }
+
+private:
+    static timespec toTimespec(std::chrono::nanoseconds ns) noexcept {
+        return timespec{static_cast<time_t>(ns.count() / 1000000000), static_cast<long>(ns.count() % 1000000000)};
+    }
+
+    Callback callback_;
+};
+
+} // namespace elaeo::comm::events
+
+#endif // ELAEO_COMM_EVENTS_FD_SOURCE_H
@@ -0,0 +1,94 @@
+/**
+ * @file inline_function.h
+ * @brief move only void() callable stored inline, never on the heap.
+ */
+
+#ifndef ELAEO_COMM_EVENTS_INLINE_FUNCTION_H
+#define ELAEO_COMM_EVENTS_INLINE_FUNCTION_H
+
+#include <concepts>
+#include <cstddef>
+#include <new>
+#include <type_traits>
+#include <utility>
+
+namespace elaeo::comm::events {
+
+/**
+ * @brief Like std::function<void()>, but the callable must fit in Capacity
+ * bytes (and pointer alignment), checked at compile time, so it is always
+ * stored inline. Capture less, or a pointer to the rest, when it doesn't fit.
+ */
+template <std::size_t Capacity = 48>
+class InlineFunction {
+public:
+    InlineFunction() = default;
+
+    template <typename F>
+        requires(!std::same_as<std::decay_t<F>, InlineFunction> && std::invocable<std::decay_t<F>&>)
+    InlineFunction(F&& function) {
+        emplace(std::forward<F>(function));
+    }
+
+    InlineFunction(InlineFunction&& other) noexcept { moveFrom(other); }
+    InlineFunction& operator=(InlineFunction&& other) noexcept {
+        if (this != &other) {
+            reset();
+            moveFrom(other);
+        }
+        return *this;
+    }
+    InlineFunction(const InlineFunction&) = delete;
+    InlineFunction& operator=(const InlineFunction&) = delete;
+    ~InlineFunction() { reset(); }
+
+    template <typename F>
+    void emplace(F&& function) {
+        using Function = std::decay_t<F>;
+        static_assert(sizeof(Function) <= Capacity, "callable doesn't fit, capture less or by pointer");
+        static_assert(alignof(Function) <= alignof(void*), "callable is over aligned");
+        static_assert(std::is_nothrow_move_constructible_v<Function>, "callable must be nothrow movable");
+        reset();
+        ::new (static_cast<void*>(storage_)) Function(std::forward<F>(function));
+        ops_ = &OPS<Function>;
+    }
+
+    void reset() noexcept {
+        if (ops_) {
+            ops_->destroy(storage_);
+            ops_ = nullptr;
+        }
+    }
+
+    void operator()() { ops_->invoke(storage_); }
+    explicit operator bool() const noexcept { return ops_ != nullptr; }
+
+private:
+    struct Ops {
+        void (*invoke)(void*);
+        void (*move)(void* to, void* from) noexcept;
+        void (*destroy)(void*) noexcept;
+    };
+
+    template <typename Function>
+    static constexpr Ops OPS = {
+        [](void* self) { (*static_cast<Function*>(self))(); },
+        [](void* to, void* from) noexcept { ::new (to) Function(std::move(*static_cast<Function*>(from))); },
+        [](void* self) noexcept { static_cast<Function*>(self)->~Function(); },
+    };
+
+    void moveFrom(InlineFunction& other) noexcept {
+        if (other.ops_) {
+            other.ops_->move(storage_, other.storage_);
+            ops_ = other.ops_;
+            other.reset();
+        }
+    }
+
+    const Ops* ops_ = nullptr;
+    alignas(void*) unsigned char storage_[Capacity];
+};
+
+} // namespace elaeo::comm::events
+
+#endif // ELAEO_COMM_EVENTS_INLINE_FUNCTION_H
@@ -0,0 +1,139 @@
+/**
+ * @file publisher.h
+ * @brief synchronous event publishers and their callback types.
+ */
+
+#ifndef ELAEO_COMM_EVENTS_PUBLISHER_H
+#define ELAEO_COMM_EVENTS_PUBLISHER_H
+
+#include <algorithm>
+#include <array>
+#include <concepts>
+#include <cstddef>
+#include <memory>
+#include <tuple>
+#include <utility>
+#include <vector>
+#include <events/types.h>
+
+namespace elaeo::comm::events {
+
+// Concept for event callbacks
+template <typename T, typename Event>
+concept EventCallback = requires(T t, const Event& event) {
+    { t.handleEvent(event) } -> std::same_as<void>;
+};
+
+// EventCallback using concepts
+template <typename Event>
+class EventCallbackBase {
+public:
+    virtual void handleEvent(const Event& event) = 0;
+    virtual ~EventCallbackBase() = default;
+};
+
+// LambdaCallback using concepts and modern C++
+template <typename Event, std::invocable<const Event&> Callback>
+class LambdaCallback : public EventCallbackBase<Event> {
+public:
+    explicit LambdaCallback(Callback&& callback) : callback_(std::move(callback)) {}
+    void handleEvent(const Event& event) override { callback_(event); }
+
+private:
+    Callback callback_;
+};
+
+// EventPublisher using modern C++, callbacks run on the publishing thread in
+// descending priority order
+template <typename Event>
+class EventPublisher {
+public:
+    using CallbackPtr = std::shared_ptr<EventCallbackBase<Event>>;
+
+    subscription_t registerCallback(CallbackPtr callback, priority_t priority = 0) {
+        callbacks_.emplace_back(std::make_pair(priority, std::move(callback)));
+        std::stable_sort(callbacks_.begin(), callbacks_.end(), [](const auto& a, const auto& b) {
+            return a.first > b.first;
+        });
+        return next_subscription_id_++;
+    }
+
+    void publishEvent(const Event& event) {
+        for (const auto& [priority, callback] : callbacks_) {
+            callback->handleEvent(event);
+        }
+    }
+
+private:
+    std::vector<std::pair<priority_t, CallbackPtr>> callbacks_;
+    subscription_t next_subscription_id_{1};
+};
+
+// Priority of a StaticPublisher handler, its static priority member if it has one
+template <typename Handler>
+constexpr priority_t handlerPriority() {
+    if constexpr (requires { { Handler::priority } -> std::convertible_to<priority_t>; }) {
+        return Handler::priority;
+    } else {
+        return PRIORITY_LOWEST;
+    }
+}
+
+// Give a handler type you don't own a StaticPublisher priority
+template <priority_t Priority, typename Handler>
+struct Prioritized : Handler {
+    using Handler::Handler;
+    explicit Prioritized(Handler handler) : Handler(std::move(handler)) {}
+    static constexpr priority_t priority = Priority;
+};
+
+/**
+ * @brief Publisher for subscribers known at build time. The handlers are held
+ * by value and called in descending priority order (ties keep their order in
+ * the list) through a fold over an order fixed at compile time, so
+ * publishEvent() is a straight line of direct, inlinable calls, with no
+ * virtual dispatch or pointer chasing.
+ */
+template <typename Event, EventCallback<Event>... Handlers>
+class StaticPublisher {
+public:
+    StaticPublisher() = default;
+    explicit StaticPublisher(Handlers... handlers)
+        requires(sizeof...(Handlers) > 0)
+        : handlers_(std::move(handlers)...) {}
+
+    void publishEvent(const Event& event) {
+        publish(event, std::make_index_sequence<sizeof...(Handlers)>{});
+    }
+
+    // The I'th handler as listed
+    template <std::size_t I>
+    auto& handler() noexcept { return std::get<I>(handlers_); }
+
+private:
+    // handler indexes by descending priority, stable
+    static constexpr std::array<std::size_t, sizeof...(Handlers)> order() {
+        constexpr std::array<priority_t, sizeof...(Handlers)> priorities{handlerPriority<Handlers>()...};
+        std::array<std::size_t, sizeof...(Handlers)> indexes{};
+        for (std::size_t i = 0; i < indexes.size(); ++i) {
+            std::size_t j = i;
+            for (; j > 0 && priorities[indexes[j - 1]] < priorities[i]; --j) {
+                indexes[j] = indexes[j - 1];
+            }
+            indexes[j] = i;
+        }
+        return indexes;
+    }
+    static constexpr auto ORDER = order();
+
+    template <std::size_t... I>
+    void publish(const Event& event, std::index_sequence<I...>) {
+        (std::get<ORDER[I]>(handlers_).handleEvent(event), ...);
+    }
+
+    std::tuple<Handlers...> handlers_;
+};
+
+} // namespace elaeo::comm::events
+
+#endif // ELAEO_COMM_EVENTS_PUBLISHER_H
@@ -0,0 +1,89 @@
+/**
+ * @file queued_publisher.h
+ * @brief publisher whose callbacks run on a consumer thread fed through a ring.
+ */
+
+#ifndef ELAEO_COMM_EVENTS_QUEUED_PUBLISHER_H
+#define ELAEO_COMM_EVENTS_QUEUED_PUBLISHER_H
+
+#include <atomic>
+#include <cstddef>
+#include <events/callback.h>
+#include <events/publisher.h>
+#include <events/ring_queue.h>
+#include <events/types.h>
+#include <events/wait_strategy.h>
+
+namespace elaeo::comm::events {
+
+/**
+ * @brief Hands events over to another thread. publishEvent() only copies the
+ * event into the ring, the registered callbacks run on the consumer thread,
+ * which drains the ring BatchSize events at a time from poll() or run().
+ *
+ * Ring is SpscRing (one publishing thread) or MpscRing (any number). Register
+ * callbacks before the consumer starts. The ring lives inline, so for large
+ * capacities keep the publisher itself on the heap.
+ */
+template <EventType Event, typename Ring, WaitStrategy Wait = SpinWait, std::size_t BatchSize = 64>
+class QueuedPublisher {
+public:
+    using CallbackPtr = typename EventPublisher<Event>::CallbackPtr;
+
+    subscription_t registerCallback(CallbackPtr callback, priority_t priority = 0) {
+        return subscribers_.registerCallback(std::move(callback), priority);
+    }
+
+    // Producer side; false when the ring is full and the event was dropped
+    bool publishEvent(const Event& event) noexcept {
+        if (!ring_.tryPush(event)) {
+            return false;
+        }
+        wait_.notify();
+        return true;
+    }
+
+    // Consumer side; dispatch one batch of queued events, returns how many
+    std::size_t poll() {
+        // raw storage, events need not be default constructible
+        alignas(Event) unsigned char storage[BatchSize * sizeof(Event)];
+        Event* batch = reinterpret_cast<Event*>(storage);
+        const std::size_t count = ring_.popBatch(batch, BatchSize);
+        for (std::size_t i = 0; i < count; ++i) {
+            subscribers_.publishEvent(batch[i]);
+        }
+        return count;
+    }
+
+    // Consumer side; dispatch events as they come until stop() and the ring is drained
+    void run() {
+        while (true) {
+            wait_.wait([this] { return !ring_.empty() || stopped_.load(std::memory_order_acquire); });
+            if (!poll() && stopped_.load(std::memory_order_acquire)) {
+                return;
+            }
+        }
+    }
+
+    // Any thread; run() returns once what's queued before this call is dispatched
+    void stop() noexcept {
+        stopped_.store(true, std::memory_order_release);
+        wait_.notify();
+    }
+
+private:
+    Ring ring_;
+    Wait wait_;
+    EventPublisher<Event> subscribers_;
+    std::atomic<bool> stopped_{false};
+};
+
+template <EventType Event, std::size_t Capacity, WaitStrategy Wait = SpinWait>
+using SpscPublisher = QueuedPublisher<Event, SpscRing<Event, Capacity>, Wait>;
+
+template <EventType Event, std::size_t Capacity, WaitStrategy Wait = SpinWait>
+using MpscPublisher = QueuedPublisher<Event, MpscRing<Event, Capacity>, Wait>;
+
+} // namespace elaeo::comm::events
+
+#endif // ELAEO_COMM_EVENTS_QUEUED_PUBLISHER_H
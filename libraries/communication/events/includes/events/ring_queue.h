@@ -0,0 +1,177 @@
+/**
+ * @file ring_queue.h
+ * @brief bounded lock free SPSC and MPSC rings of trivially copyable events.
+ */
+
+#ifndef ELAEO_COMM_EVENTS_RING_QUEUE_H
+#define ELAEO_COMM_EVENTS_RING_QUEUE_H
+
+#include <algorithm>
+#include <atomic>
+#include <cstddef>
+#include <cstdint>
+#include <cstring>
+#include <events/callback.h>
+#include <events/types.h>
+
+namespace elaeo::comm::events {
+
+/**
+ * @brief Single producer / single consumer ring. Events are memcpy'd in and out
+ * of raw slots, so they are never constructed or destroyed.
+ *
+ * The producer and consumer each own one index on its own cache line, and
+ * keep a private copy of the other's that is only refreshed when the ring
+ * looks full (producer) or empty (consumer), so in steady state neither side
+ * touches the line the other one writes.
+ */
+template <EventType Event, std::size_t Capacity>
+class SpscRing {
+    static_assert(Capacity >= 2 && (Capacity & (Capacity - 1)) == 0, "Capacity must be a power of two");
+
+public:
+    SpscRing() = default;
+    SpscRing(const SpscRing&) = delete;
+    SpscRing& operator=(const SpscRing&) = delete;
+
+    static constexpr std::size_t capacity() noexcept { return Capacity; }
+
+    // Producer only; false when full
+    bool tryPush(const Event& event) noexcept {
+        const std::uint64_t tail = tail_.load(std::memory_order_relaxed);
+        if (tail - cached_head_ >= Capacity) {
+            cached_head_ = head_.load(std::memory_order_acquire);
+            if (tail - cached_head_ >= Capacity) {
+                return false;
+            }
+        }
+        std::memcpy(slot(tail), &event, sizeof(Event));
+        tail_.store(tail + 1, std::memory_order_release);
+        return true;
+    }
+
+    // Consumer only; false when empty
+    bool tryPop(Event& event) noexcept {
+        return popBatch(&event, 1) == 1;
+    }
+
+    // Consumer only; moves up to max events into out and returns how many,
+    // handing the slots back with a single store
+    std::size_t popBatch(Event* out, std::size_t max) noexcept {
+        const std::uint64_t head = head_.load(std::memory_order_relaxed);
+        if (cached_tail_ == head) {
+            cached_tail_ = tail_.load(std::memory_order_acquire);
+        }
+        const std::size_t count = std::min<std::uint64_t>(cached_tail_ - head, max);
+        for (std::size_t i = 0; i < count; ++i) {
+            std::memcpy(&out[i], slot(head + i), sizeof(Event));
+        }
+        if (count) {
+            head_.store(head + count, std::memory_order_release);
+        }
+        return count;
+    }
+
+    // Either side, a snapshot
+    bool empty() const noexcept {
+        return head_.load(std::memory_order_acquire) == tail_.load(std::memory_order_acquire);
+    }
+
+private:
+    unsigned char* slot(std::uint64_t index) noexcept {
+        return slots_ + (index & (Capacity - 1)) * sizeof(Event);
+    }
+
+    // consumer line
+    alignas(CACHE_LINE_SIZE) std::atomic<std::uint64_t> head_{0};
+    std::uint64_t cached_tail_{0};
+    // producer line
+    alignas(CACHE_LINE_SIZE) std::atomic<std::uint64_t> tail_{0};
+    std::uint64_t cached_head_{0};
+    alignas(CACHE_LINE_SIZE) unsigned char slots_[Capacity * sizeof(Event)];
+};
+
+/**
+ * @brief Multi producer / single consumer ring (Vyukov's bounded queue).
+ *
+ * Producers claim a slot by a CAS on the shared tail and mark it published by
+ * storing its sequence; the consumer alone walks the head, reading a run of
+ * published slots in one go. A producer that is preempted between claim and
+ * publish holds up the consumer at its slot only, others keep enqueueing.
+ */
+template <EventType Event, std::size_t Capacity>
+class MpscRing {
+    static_assert(Capacity >= 2 && (Capacity & (Capacity - 1)) == 0, "Capacity must be a power of two");
+
+public:
+    MpscRing() noexcept {
+        for (std::size_t i = 0; i < Capacity; ++i) {
+            slots_[i].sequence.store(i, std::memory_order_relaxed);
+        }
+    }
+    MpscRing(const MpscRing&) = delete;
+    MpscRing& operator=(const MpscRing&) = delete;
+
+    static constexpr std::size_t capacity() noexcept { return Capacity; }
+
+    // Any thread; false when full
+    bool tryPush(const Event& event) noexcept {
+        std::uint64_t tail = tail_.load(std::memory_order_relaxed);
+        while (true) {
+            Slot& s = slots_[tail & (Capacity - 1)];
+            const std::uint64_t sequence = s.sequence.load(std::memory_order_acquire);
+            const auto diff = static_cast<std::int64_t>(sequence - tail);
+            if (diff == 0) {
+                if (tail_.compare_exchange_weak(tail, tail + 1, std::memory_order_relaxed)) {
+                    std::memcpy(s.storage, &event, sizeof(Event));
+                    s.sequence.store(tail + 1, std::memory_order_release);
+                    return true;
+                }
+            } else if (diff < 0) {
+                return false; // the consumer hasn't freed this slot from the previous lap yet
+            } else {
+                tail = tail_.load(std::memory_order_relaxed);
+            }
+        }
+    }
+
+    // Consumer only; false when empty
+    bool tryPop(Event& event) noexcept {
+        return popBatch(&event, 1) == 1;
+    }
+
+    // Consumer only; moves up to max consecutive published events into out
+    std::size_t popBatch(Event* out, std::size_t max) noexcept {
+        std::size_t count = 0;
+        for (; count < max; ++count) {
+            Slot& s = slots_[(head_ + count) & (Capacity - 1)];
+            if (s.sequence.load(std::memory_order_acquire) != head_ + count + 1) {
+                break;
+            }
+            std::memcpy(&out[count], s.storage, sizeof(Event));
+            // free for the producers' next lap
+            s.sequence.store(head_ + count + Capacity, std::memory_order_release);
+        }
+        head_ += count;
+        return count;
+    }
+
+    // Consumer only
+    bool empty() const noexcept {
+        return slots_[head_ & (Capacity - 1)].sequence.load(std::memory_order_acquire) != head_ + 1;
+    }
+
+private:
+    struct Slot {
+        std::atomic<std::uint64_t> sequence;
+        unsigned char storage[sizeof(Event)];
+    };
+
+    alignas(CACHE_LINE_SIZE) std::atomic<std::uint64_t> tail_{0};
+    alignas(CACHE_LINE_SIZE) std::uint64_t head_{0};
+    alignas(CACHE_LINE_SIZE) Slot slots_[Capacity];
+};
+
+} // namespace elaeo::comm::events
+
+#endif // ELAEO_COMM_EVENTS_RING_QUEUE_H
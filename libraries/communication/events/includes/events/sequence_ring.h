@@ -0,0 +1,233 @@
+/**
+ * @file sequence_ring.h
+ * @brief single producer ring multicast to consumers chained by sequence barriers.
+ */
+
+#ifndef ELAEO_COMM_EVENTS_SEQUENCE_RING_H
+#define ELAEO_COMM_EVENTS_SEQUENCE_RING_H
+
+#include <algorithm>
+#include <atomic>
+#include <cstddef>
+#include <cstdint>
+#include <cstring>
+#include <initializer_list>
+#include <memory>
+#include <new>
+#include <thread>
+#include <vector>
+#include <events/callback.h>
+#include <events/types.h>
+#include <events/wait_strategy.h>
+
+namespace elaeo::comm::events {
+
+using sequence_t = std::int64_t;
+
+// A published / consumed position on the ring, alone on its cache line
+struct alignas(CACHE_LINE_SIZE) Sequence {
+    std::atomic<sequence_t> value{-1};
+};
+
+/**
+ * @brief Disruptor style ring. One producer writes each event once, every
+ * consumer reads it in place, in order, at its own pace.
+ *
+ * Each consumer owns a Sequence, the last event it is done with. A consumer
+ * added after others (say a journal after the book builder and the stats)
+ * only sees an event once all of those are done with it; one added after no
+ * one follows the producer directly. The producer in turn never laps the
+ * consumers at the end of those chains. Everyone moves in batches: the
+ * producer claims and publishes runs of slots, a consumer takes everything
+ * available in one look and advances its sequence once per batch.
+ *
+ * Events are memcpy'd into raw slots, never constructed or destroyed. Add all
+ * consumers before the producer starts. The ring lives inline, so for large
+ * capacities keep it on the heap.
+ */
+template <EventType Event, std::size_t Capacity, WaitStrategy Wait = SpinWait>
+class SequenceRing {
+    static_assert(Capacity >= 2 && (Capacity & (Capacity - 1)) == 0, "Capacity must be a power of two");
+
+public:
+    class Consumer {
+    public:
+        Consumer(const Consumer&) = delete;
+        Consumer& operator=(const Consumer&) = delete;
+
+        // Hand every available event to handler(event, sequence, end_of_batch),
+        // returns how many; doesn't wait
+        template <typename Handler>
+        std::size_t poll(Handler&& handler) {
+            const sequence_t next = sequence_.value.load(std::memory_order_relaxed) + 1;
+            const sequence_t available = ring_.available(*this);
+            if (available < next) {
+                return 0;
+            }
+            for (sequence_t s = next; s <= available; ++s) {
+                handler(ring_.event(s), s, s == available);
+            }
+            sequence_.value.store(available, std::memory_order_release);
+            ring_.wait_.notify(); // for whoever waits on us
+            return static_cast<std::size_t>(available - next + 1);
+        }
+
+        // Keep polling until the ring is stopped and everything published before is handled
+        template <typename Handler>
+        void run(Handler&& handler) {
+            while (true) {
+                ring_.wait_.wait([this] {
+                    return ring_.available(*this) > sequence_.value.load(std::memory_order_relaxed) ||
+                           ring_.drained(*this);
+                });
+                if (!poll(handler) && ring_.drained(*this)) {
+                    return;
+                }
+            }
+        }
+
+        // the last event this consumer is done with
+        sequence_t sequence() const noexcept { return sequence_.value.load(std::memory_order_acquire); }
+
+    private:
+        friend class SequenceRing;
+
+        Consumer(SequenceRing& ring, std::vector<const Sequence*> after) : ring_(ring), after_(std::move(after)) {}
+
+        Sequence sequence_;
+        SequenceRing& ring_;
+        std::vector<const Sequence*> after_;   // empty = right behind the producer
+        bool gating_ = true;                   // nobody consumes after us
+    };
+
+    SequenceRing() = default;
+    SequenceRing(const SequenceRing&) = delete;
+    SequenceRing& operator=(const SequenceRing&) = delete;
+
+    static constexpr std::size_t capacity() noexcept { return Capacity; }
+
+    // A consumer that sees an event only after every one of after is done with it
+    Consumer& addConsumer(std::initializer_list<Consumer*> after = {}) {
+        std::vector<const Sequence*> barrier;
+        for (Consumer* consumer : after) {
+            consumer->gating_ = false;
+            barrier.push_back(&consumer->sequence_);
+        }
+        consumers_.push_back(std::unique_ptr<Consumer>(new Consumer(*this, std::move(barrier))));
+        gating_.clear();
+        for (const auto& consumer : consumers_) {
+            if (consumer->gating_) {
+                gating_.push_back(&consumer->sequence_);
+            }
+        }
+        return *consumers_.back();
+    }
+
+    // Producer; reserve the next count slots, waiting while the slowest
+    // consumer still needs them, and return the first one's sequence. More
+    // than Capacity could never be free at once, so count is clamped to it in
+    // every build: only min(count, Capacity) slots are claimed, publishBatch
+    // splits longer runs.
+    sequence_t claim(std::size_t count = 1) noexcept {
+        count = std::min(count, Capacity);
+        const sequence_t first = next_;
+        next_ += static_cast<sequence_t>(count);
+        const sequence_t wrap = next_ - 1 - static_cast<sequence_t>(Capacity);
+        while (wrap > cached_gate_) {
+            cached_gate_ = minimum(gating_, next_ - 1);
+            if (wrap > cached_gate_) {
+                std::this_thread::yield();
+            }
+        }
+        return first;
+    }
+
+    // Producer; fill a claimed slot
+    void write(sequence_t sequence, const Event& event) noexcept {
+        std::memcpy(slot(sequence), &event, sizeof(Event));
+    }
+
+    // Producer; make every claimed slot up to and including last visible
+    void publish(sequence_t last) noexcept {
+        cursor_.value.store(last, std::memory_order_release);
+        wait_.notify();
+    }
+
+    // Producer; claim, write and publish in one go
+    void publish(const Event& event) noexcept {
+        const sequence_t sequence = claim();
+        write(sequence, event);
+        publish(sequence);
+    }
+
+    // Producer; a batch larger than the ring goes out a ring's worth at a time
+    void publishBatch(const Event* events, std::size_t count) noexcept {
+        while (count) {
+            const std::size_t batch = std::min(count, Capacity);
+            const sequence_t first = claim(batch);
+            for (std::size_t i = 0; i < batch; ++i) {
+                write(first + static_cast<sequence_t>(i), events[i]);
+            }
+            publish(first + static_cast<sequence_t>(batch) - 1);
+            events += batch;
+            count -= batch;
+        }
+    }
+
+    // Consumers; a published event still held by the caller's sequence
+    const Event& event(sequence_t sequence) const noexcept {
+        return *std::launder(reinterpret_cast<const Event*>(slot(sequence)));
+    }
+
+    // the last published event
+    sequence_t cursor() const noexcept { return cursor_.value.load(std::memory_order_acquire); }
+
+    // Any thread; consumers' run() returns once they handled what's published before this call
+    void stop() noexcept {
+        stopped_.store(true, std::memory_order_release);
+        wait_.notify();
+    }
+
+private:
+    static sequence_t minimum(const std::vector<const Sequence*>& sequences, sequence_t ceiling) noexcept {
+        sequence_t lowest = ceiling;
+        for (const Sequence* sequence : sequences) {
+            lowest = std::min(lowest, sequence->value.load(std::memory_order_acquire));
+        }
+        return lowest;
+    }
+
+    // the last sequence consumer may read: published and done by all it follows
+    sequence_t available(const Consumer& consumer) const noexcept {
+        return minimum(consumer.after_, cursor_.value.load(std::memory_order_acquire));
+    }
+
+    // stopped, and consumer handled everything published before
+    bool drained(const Consumer& consumer) const noexcept {
+        return stopped_.load(std::memory_order_acquire) &&
+               consumer.sequence_.value.load(std::memory_order_relaxed) >= cursor_.value.load(std::memory_order_acquire);
+    }
+
+    unsigned char* slot(sequence_t sequence) noexcept {
+        return slots_ + (static_cast<std::size_t>(sequence) & (Capacity - 1)) * sizeof(Event);
+    }
+    const unsigned char* slot(sequence_t sequence) const noexcept {
+        return slots_ + (static_cast<std::size_t>(sequence) & (Capacity - 1)) * sizeof(Event);
+    }
+
+    // producer only
+    alignas(CACHE_LINE_SIZE) sequence_t next_ = 0;   // first unclaimed
+    sequence_t cached_gate_ = -1;                     // slowest gating consumer, last we looked
+    std::vector<const Sequence*> gating_;
+    // shared
+    Sequence cursor_;
+    Wait wait_;
+    std::atomic<bool> stopped_{false};
+    std::vector<std::unique_ptr<Consumer>> consumers_;
+    alignas(alignof(Event) > CACHE_LINE_SIZE ? alignof(Event) : CACHE_LINE_SIZE)
+        unsigned char slots_[Capacity * sizeof(Event)];
+};
+
+} // namespace elaeo::comm::events
+
+#endif // ELAEO_COMM_EVENTS_SEQUENCE_RING_H
@@ -0,0 +1,294 @@
+/**
+ * @file task.h
+ * @brief lazy coroutine task with frames allocated from a per loop arena.
+ */
+
+#ifndef ELAEO_COMM_EVENTS_TASK_H
+#define ELAEO_COMM_EVENTS_TASK_H
+
+#include <concepts>
+#include <coroutine>
+#include <cstddef>
+#include <cstdint>
+#include <exception>
+#include <memory>
+#include <new>
+#include <optional>
+#include <utility>
+#include <vector>
+
+namespace elaeo::comm::events {
+
+// A coroutine waiting in a loop's run queue, kept in whatever is suspended so queueing never allocates
+struct Resumable {
+    Resumable* next = nullptr;
+    std::coroutine_handle<> handle;
+};
+
+/**
+ * @brief Coroutine frames of one loop. Frames come in 64 byte size classes
+ * carved from 64 KB chunks and go back on the class's free list when the
+ * coroutine ends, so a protocol that keeps starting short coroutines reuses
+ * the same few frames instead of calling the allocator. Frames larger than
+ * the biggest class go to operator new.
+ *
+ * A Task takes its frame from the arena of the first of its arguments that
+ * has a frameArena() (typically the loop it runs on), else from the arena
+ * current on the thread (a loop sets its own while it runs), else from
+ * operator new. Not thread safe: frames are allocated and freed on the
+ * loop's thread.
+ */
+class FrameArena {
+public:
+    static constexpr std::size_t GRANULE = 64;
+    static constexpr std::size_t CLASSES = 64;          // pooled up to 4 KB
+    static constexpr std::size_t CHUNK_SIZE = 64 * 1024;
+
+    FrameArena() = default;
+    FrameArena(const FrameArena&) = delete;
+    FrameArena& operator=(const FrameArena&) = delete;
+
+    // arena may be null, for operator new
+    static void* allocate(std::size_t size, FrameArena* arena) {
+        const std::size_t total = size + sizeof(Header);
+        const std::size_t size_class = (total + GRANULE - 1) / GRANULE;
+        Header* header;
+        if (!arena || size_class > CLASSES) {
+            header = static_cast<Header*>(::operator new(total));
+            header->arena = nullptr;
+        } else {
+            header = arena->take(size_class);
+            header->arena = arena;
+            ++arena->live_;
+        }
+        header->size_class = size_class;
+        return header + 1;
+    }
+
+    static void deallocate(void* frame) noexcept {
+        Header* header = static_cast<Header*>(frame) - 1;
+        FrameArena* arena = header->arena;
+        if (!arena) {
+            ::operator delete(header);
+            return;
+        }
+        --arena->live_;
+        header->next = arena->free_[header->size_class - 1];
+        arena->free_[header->size_class - 1] = header;
+    }
+
+    // Frames currently handed out
+    std::size_t size() const noexcept { return live_; }
+    std::size_t chunks() const noexcept { return chunks_.size(); }
+
+    static FrameArena* current() noexcept { return currentSlot(); }
+
+    // Make arena the thread's current one for the scope's lifetime
+    class Scope {
+    public:
+        explicit Scope(FrameArena& arena) noexcept : previous_(currentSlot()) { currentSlot() = &arena; }
+        Scope(const Scope&) = delete;
+        Scope& operator=(const Scope&) = delete;
+        ~Scope() { currentSlot() = previous_; }
+
+    private:
+        FrameArena* previous_;
+    };
+
+private:
+    struct alignas(__STDCPP_DEFAULT_NEW_ALIGNMENT__) Header {
+        union {
+            FrameArena* arena;   // while handed out
+            Header* next;        // while on a free list
+        };
+        std::size_t size_class;
+    };
+
+    static FrameArena*& currentSlot() noexcept {
+        thread_local FrameArena* current = nullptr;
+        return current;
+    }
+
+    Header* take(std::size_t size_class) {
+        if (Header* header = free_[size_class - 1]) {
+            free_[size_class - 1] = header->next;
+            return header;
+        }
+        const std::size_t bytes = size_class * GRANULE;
+        if (chunks_.empty() || chunk_used_ + bytes > CHUNK_SIZE) {
+            chunks_.push_back(std::make_unique<std::byte[]>(CHUNK_SIZE));
+            chunk_used_ = 0;
+        }
+        void* block = chunks_.back().get() + chunk_used_;
+        chunk_used_ += bytes;
+        return ::new (block) Header;
+    }
+
+    Header* free_[CLASSES] = {};
+    std::vector<std::unique_ptr<std::byte[]>> chunks_;
+    std::size_t chunk_used_ = 0;
+    std::size_t live_ = 0;
+};
+
+template <typename T = void>
+class Task;
+
+// What every Task's promise shares: frame allocation, the continuation and detaching
+class TaskPromiseBase {
+public:
+    template <typename... Args>
+    static void* operator new(std::size_t size, Args&... args) {
+        FrameArena* arena = nullptr;
+        ((arena = arena ? arena : arenaOf(args)), ...);
+        return FrameArena::allocate(size, arena ? arena : FrameArena::current());
+    }
+    static void operator delete(void* frame, std::size_t) noexcept { FrameArena::deallocate(frame); }
+
+    std::suspend_always initial_suspend() noexcept { return {}; }
+
+    // Back to whoever awaited us; a detached task hands on its failure and frees itself
+    struct FinalAwaiter {
+        bool await_ready() noexcept { return false; }
+        template <typename Promise>
+        std::coroutine_handle<> await_suspend(std::coroutine_handle<Promise> handle) noexcept {
+            TaskPromiseBase& promise = handle.promise();
+            if (promise.continuation_) {
+                return promise.continuation_;
+            }
+            if (promise.detached_) {
+                promise.detached_->finished(promise);
+                handle.destroy();
+            }
+            return std::noop_coroutine();
+        }
+        void await_resume() noexcept {}
+    };
+    FinalAwaiter final_suspend() noexcept { return {}; }
+
+    void unhandled_exception() noexcept { exception_ = std::current_exception(); }
+
+    // Owner of detached tasks, told when one finishes
+    class Detacher {
+    public:
+        virtual void finished(TaskPromiseBase& promise) noexcept = 0;
+
+    protected:
+        ~Detacher() = default;
+    };
+
+    std::coroutine_handle<> continuation_;
+    std::exception_ptr exception_;
+    Detacher* detached_ = nullptr;
+    Resumable start_;                        // queues a detached task's first run
+    TaskPromiseBase* next_detached_ = nullptr;
+    TaskPromiseBase** prev_detached_ = nullptr;
+
+private:
+    template <typename Arg>
+    static FrameArena* arenaOf(Arg& arg) noexcept {
+        if constexpr (requires { { arg.frameArena() } -> std::same_as<FrameArena&>; }) {
+            return &arg.frameArena();
+        } else {
+            return nullptr;
+        }
+    }
+};
+
+template <typename T>
+class TaskPromise : public TaskPromiseBase {
+public:
+    Task<T> get_return_object() noexcept;
+
+    template <typename U>
+    void return_value(U&& value) {
+        value_.emplace(std::forward<U>(value));
+    }
+
+    T result() {
+        if (exception_) {
+            std::rethrow_exception(exception_);
+        }
+        return std::move(*value_);
+    }
+
+private:
+    std::optional<T> value_;
+};
+
+template <>
+class TaskPromise<void> : public TaskPromiseBase {
+public:
+    Task<void> get_return_object() noexcept;
+
+    void return_void() noexcept {}
+
+    void result() {
+        if (exception_) {
+            std::rethrow_exception(exception_);
+        }
+    }
+};
+
+/**
+ * @brief A coroutine that starts when first awaited (or when spawned on a
+ * loop) and resumes its awaiter directly when done, without going back
+ * through the loop. Exceptions surface from the co_await.
+ */
+template <typename T>
+class [[nodiscard]] Task {
+public:
+    using promise_type = TaskPromise<T>;
+
+    Task(Task&& other) noexcept : handle_(std::exchange(other.handle_, nullptr)) {}
+    Task& operator=(Task&& other) noexcept {
+        if (this != &other) {
+            if (handle_) {
+                handle_.destroy();
+            }
+            handle_ = std::exchange(other.handle_, nullptr);
+        }
+        return *this;
+    }
+    ~Task() {
+        if (handle_) {
+            handle_.destroy();
+        }
+    }
+
+    bool done() const noexcept { return !handle_ || handle_.done(); }
+
+    auto operator co_await() && noexcept {
+        struct Awaiter {
+            std::coroutine_handle<promise_type> handle;
+            bool await_ready() noexcept { return !handle || handle.done(); }
+            std::coroutine_handle<> await_suspend(std::coroutine_handle<> awaiting) noexcept {
+                handle.promise().continuation_ = awaiting;
+                return handle;
+            }
+            T await_resume() { return handle.promise().result(); }
+        };
+        return Awaiter{handle_};
+    }
+
+    // Give up ownership of the frame, e.g. to a loop that runs it detached
+    std::coroutine_handle<promise_type> release() noexcept { return std::exchange(handle_, nullptr); }
+
+private:
+    friend class TaskPromise<T>;
+    explicit Task(std::coroutine_handle<promise_type> handle) noexcept : handle_(handle) {}
+
+    std::coroutine_handle<promise_type> handle_;
+};
+
+template <typename T>
+Task<T> TaskPromise<T>::get_return_object() noexcept {
+    return Task<T>(std::coroutine_handle<TaskPromise<T>>::from_promise(*this));
+}
+
+inline Task<void> TaskPromise<void>::get_return_object() noexcept {
+    return Task<void>(std::coroutine_handle<TaskPromise<void>>::from_promise(*this));
+}
+
+} // namespace elaeo::comm::events
+
+#endif // ELAEO_COMM_EVENTS_TASK_H
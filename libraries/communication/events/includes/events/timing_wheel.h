@@ -0,0 +1,229 @@
+/**
+ * @file timing_wheel.h
+ * @brief hashed hierarchical timing wheel with intrusive timers.
+ */
+
+#ifndef ELAEO_COMM_EVENTS_TIMING_WHEEL_H
+#define ELAEO_COMM_EVENTS_TIMING_WHEEL_H
+
+#include <algorithm>
+#include <chrono>
+#include <cstddef>
+#include <cstdint>
+#include <type_traits>
+#include <utility>
+#include <events/tsc_clock.h>
+
+namespace elaeo::comm::events {
+
+class TimingWheel;
+
+/**
+ * @brief A timer node, embedded in whatever owns the timeout (an order's ack
+ * deadline, a session's heartbeat). The wheel only links nodes together, it
+ * never allocates. Destroying an armed timer cancels it.
+ */
+class Timer {
+public:
+    using Callback = void (*)(Timer&);
+
+    explicit Timer(Callback callback) noexcept : callback_(callback) {}
+    Timer(const Timer&) = delete;
+    Timer& operator=(const Timer&) = delete;
+    ~Timer();
+
+    bool armed() const noexcept { return prev_ != nullptr; }
+
+private:
+    friend class TimingWheel;
+
+    // the wheel's slot list heads
+    Timer() noexcept : callback_(nullptr) {}
+
+    void unlink() noexcept {
+        if (prev_) {
+            prev_->next_ = next_;
+            next_->prev_ = prev_;
+            prev_ = next_ = nullptr;
+        }
+    }
+
+    Timer* prev_ = nullptr;
+    Timer* next_ = nullptr;
+    TimingWheel* wheel_ = nullptr; // while armed
+    std::uint64_t deadline_ = 0;   // in wheel ticks
+    Callback callback_;
+};
+
+// A Timer that runs a callable kept inline, e.g. a lambda capturing its owner
+template <typename Function>
+class CallbackTimer : public Timer {
+public:
+    explicit CallbackTimer(Function function) noexcept(std::is_nothrow_move_constructible_v<Function>)
+        : Timer(&CallbackTimer::fire), function_(std::move(function)) {}
+
+private:
+    static void fire(Timer& timer) { static_cast<CallbackTimer&>(timer).function_(); }
+
+    Function function_;
+};
+
+/**
+ * @brief Four levels of 256 slots, each level's slot spanning a whole
+ * rotation of the level below, so a timer lands in its slot by a shift and a
+ * mask and unlinks from it in O(1) whatever the number of timers. Level 0
+ * slots are single ticks and expire as the wheel turns; a higher slot is
+ * cascaded (its timers redistributed below) when the wheel reaches it, so
+ * every timer moves at most three times in its life.
+ *
+ * Time is read from the TSC and the wheel turns in ticks of tick_ns; the
+ * range is 2^32 ticks, later deadlines fire at the end of it. Timers fire in
+ * tick order, in no particular order within a tick, and no earlier than
+ * their delay rounded up to a tick. Callbacks may schedule and cancel timers,
+ * including their own. Not thread safe, one wheel per loop.
+ */
+class TimingWheel {
+public:
+    static constexpr std::size_t LEVELS = 4;
+    static constexpr unsigned SLOT_BITS = 8;
+    static constexpr std::size_t SLOTS = 1 << SLOT_BITS;
+
+    explicit TimingWheel(std::chrono::nanoseconds tick = std::chrono::microseconds(100))
+        : tick_ns_(static_cast<std::uint64_t>(tick.count() > 0 ? tick.count() : 1)),
+          origin_ns_(TscClock::instance().nowNs()) {
+        for (auto& level : slots_) {
+            for (Timer& head : level) {
+                head.prev_ = head.next_ = &head;
+            }
+        }
+    }
+    TimingWheel(const TimingWheel&) = delete;
+    TimingWheel& operator=(const TimingWheel&) = delete;
+    ~TimingWheel() {
+        // leave the owners' timers disarmed rather than pointing into us
+        for (auto& level : slots_) {
+            for (Timer& head : level) {
+                while (head.next_ != &head) {
+                    head.next_->wheel_ = nullptr;
+                    head.next_->unlink();
+                }
+                head.prev_ = head.next_ = nullptr;
+            }
+        }
+    }
+
+    // Fire timer after delay, moving it if it was already armed
+    void schedule(Timer& timer, std::chrono::nanoseconds delay) noexcept {
+        const std::uint64_t ticks =
+            delay.count() > 0 ? (static_cast<std::uint64_t>(delay.count()) + tick_ns_ - 1) / tick_ns_ : 0;
+        cancel(timer);
+        timer.deadline_ = now_ + (ticks ? ticks : 1);
+        timer.wheel_ = this;
+        insert(timer);
+        ++armed_;
+    }
+
+    void cancel(Timer& timer) noexcept {
+        if (timer.armed()) {
+            timer.unlink();
+            timer.wheel_ = nullptr;
+            --armed_;
+        }
+    }
+
+    // Turn the wheel up to the clock's current tick firing what is due; how many fired
+    std::size_t advance() { return advanceTo(currentTick()); }
+
+    // Turn the wheel up to tick
+    std::size_t advanceTo(std::uint64_t tick) {
+        std::size_t fired = 0;
+        if (!armed_) {
+            now_ = std::max(now_, tick); // nothing to walk through
+            return 0;
+        }
+        while (now_ < tick) {
+            ++now_;
+            // a rotation of one level completes every slot of the next
+            for (std::size_t level = 1; level < LEVELS && !(now_ & ((std::uint64_t{1} << (SLOT_BITS * level)) - 1));
+                 ++level) {
+                cascade(level);
+            }
+            Timer& head = slots_[0][now_ & (SLOTS - 1)];
+            while (head.next_ != &head) {
+                Timer& timer = *head.next_;
+                timer.unlink();
+                timer.wheel_ = nullptr;
+                --armed_;
+                ++fired;
+                timer.callback_(timer);
+            }
+            if (!armed_) {
+                now_ = tick;
+            }
+        }
+        return fired;
+    }
+
+    // Ticks until the next level 0 slot with timers, or the next cascade, at most SLOTS;
+    // how long an idle loop may sleep without firing late
+    std::uint64_t ticksToNext() const noexcept {
+        const std::uint64_t until_cascade = SLOTS - (now_ & (SLOTS - 1));
+        for (std::uint64_t ticks = 1; ticks < until_cascade; ++ticks) {
+            const Timer& head = slots_[0][(now_ + ticks) & (SLOTS - 1)];
+            if (head.next_ != &head) {
+                return ticks;
+            }
+        }
+        return until_cascade;
+    }
+
+    std::uint64_t currentTick() const noexcept { return (TscClock::instance().nowNs() - origin_ns_) / tick_ns_; }
+    std::uint64_t now() const noexcept { return now_; }
+    std::uint64_t tickNs() const noexcept { return tick_ns_; }
+    std::size_t size() const noexcept { return armed_; }
+    bool empty() const noexcept { return armed_ == 0; }
+
+private:
+    void insert(Timer& timer) noexcept {
+        const std::uint64_t max_ticks = (std::uint64_t{1} << (SLOT_BITS * LEVELS)) - 1;
+        if (timer.deadline_ - now_ > max_ticks) {
+            timer.deadline_ = now_ + max_ticks;
+        }
+        const std::uint64_t delta = timer.deadline_ - now_;
+        std::size_t level = 0;
+        while (level + 1 < LEVELS && delta >= (std::uint64_t{1} << (SLOT_BITS * (level + 1)))) {
+            ++level;
+        }
+        Timer& head = slots_[level][(timer.deadline_ >> (SLOT_BITS * level)) & (SLOTS - 1)];
+        timer.prev_ = head.prev_;
+        timer.next_ = &head;
+        head.prev_->next_ = &timer;
+        head.prev_ = &timer;
+    }
+
+    // Redistribute the level's slot the wheel just reached over the levels below
+    void cascade(std::size_t level) noexcept {
+        Timer& head = slots_[level][(now_ >> (SLOT_BITS * level)) & (SLOTS - 1)];
+        while (head.next_ != &head) {
+            Timer& timer = *head.next_;
+            timer.unlink();
+            insert(timer);
+        }
+    }
+
+    std::uint64_t tick_ns_;
+    std::uint64_t origin_ns_;
+    std::uint64_t now_ = 0;     // last tick processed
+    std::size_t armed_ = 0;
+    Timer slots_[LEVELS][SLOTS];   // list heads, only their links are used
+};
+
+inline Timer::~Timer() {
+    if (wheel_) {
+        wheel_->cancel(*this);
+    }
+}
+
+} // namespace elaeo::comm::events
+
+#endif // ELAEO_COMM_EVENTS_TIMING_WHEEL_H
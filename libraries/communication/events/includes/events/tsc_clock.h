@@ -0,0 +1,79 @@
+/**
+ * @file tsc_clock.h
+ * @brief monotonic nanoseconds from the time stamp counter.
+ */
+
+#ifndef ELAEO_COMM_EVENTS_TSC_CLOCK_H
+#define ELAEO_COMM_EVENTS_TSC_CLOCK_H
+
+#include <chrono>
+#include <cstdint>
+#if defined(__x86_64__) || defined(__i386__)
+#include <cpuid.h>
+#include <x86intrin.h>
+#endif
+
+namespace elaeo::comm::events {
+
+/**
+ * @brief Reads the invariant TSC and scales it to nanoseconds with the rate
+ * measured against steady_clock once, on first use (about 10 ms). That is a
+ * couple of dozen cycles instead of a clock_gettime call. Falls back to
+ * steady_clock on CPUs without an invariant TSC.
+ *
+ * Both scales share steady_clock's epoch, so readings are comparable with it.
+ */
+class TscClock {
+public:
+    static const TscClock& instance() {
+        static const TscClock clock;
+        return clock;
+    }
+
+    std::uint64_t nowNs() const noexcept {
+#if defined(__x86_64__) || defined(__i386__)
+        if (invariant_) {
+            return base_ns_ + static_cast<std::uint64_t>(static_cast<double>(__rdtsc() - base_tsc_) * ns_per_tick_);
+        }
+#endif
+        return steadyNs();
+    }
+
+    bool usesTsc() const noexcept { return invariant_; }
+    double nsPerTick() const noexcept { return ns_per_tick_; }
+
+private:
+    TscClock() {
+#if defined(__x86_64__) || defined(__i386__)
+        unsigned eax, ebx, ecx, edx;
+        // CPUID 0x80000007 EDX bit 8: the TSC ticks at a constant rate in every P/C-state
+        invariant_ = __get_cpuid(0x80000007, &eax, &ebx, &ecx, &edx) && (edx & (1u << 8));
+        if (invariant_) {
+            const std::uint64_t start_ns = steadyNs();
+            const std::uint64_t start_tsc = __rdtsc();
+            std::uint64_t end_ns;
+            do {
+                end_ns = steadyNs();
+            } while (end_ns - start_ns < 10000000);
+            base_tsc_ = __rdtsc();
+            base_ns_ = end_ns;
+            ns_per_tick_ = static_cast<double>(end_ns - start_ns) / static_cast<double>(base_tsc_ - start_tsc);
+        }
+#endif
+    }
+
+    static std::uint64_t steadyNs() noexcept {
+        return static_cast<std::uint64_t>(
+            std::chrono::duration_cast<std::chrono::nanoseconds>(std::chrono::steady_clock::now().time_since_epoch())
+                .count());
+    }
+
+    bool invariant_ = false;
+    std::uint64_t base_tsc_ = 0;
+    std::uint64_t base_ns_ = 0;
+    double ns_per_tick_ = 1.0;
+};
+
+} // namespace elaeo::comm::events
+
+#endif // ELAEO_COMM_EVENTS_TSC_CLOCK_H
@@ -6,6 +6,7 @@
 #ifndef ELAEO_COMM_EVENTS_TYPES_H
 #define ELAEO_COMM_EVENTS_TYPES_H
 
+#include <cstddef>
 #include <cstdint>
 
 namespace elaeo::comm::events{
@@ -19,6 +20,9 @@ namespace elaeo::comm::events{
   constexpr priority_t PRIORITY_NORMAL = 100;
   constexpr priority_t PRIORITY_HIGH = 1000;
   constexpr priority_t PRIORITY_HIGHEST = 10000;
+
+  // Cross thread state that is written by different cores lives on lines of its own
+  constexpr std::size_t CACHE_LINE_SIZE = 64;
 }
 
 #endif // ELAEO_COMM_EVENTS_TYPES_H
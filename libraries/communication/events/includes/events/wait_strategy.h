@@ -0,0 +1,113 @@
+/**
+ * @file wait_strategy.h
+ * @brief how a queue consumer waits for its producers.
+ */
+
+#ifndef ELAEO_COMM_EVENTS_WAIT_STRATEGY_H
+#define ELAEO_COMM_EVENTS_WAIT_STRATEGY_H
+
+#include <atomic>
+#include <climits>
+#include <cstdint>
+#include <thread>
+#include <linux/futex.h>
+#include <sys/syscall.h>
+#include <unistd.h>
+#include <events/types.h>
+
+namespace elaeo::comm::events {
+
+// Tell the core we're in a spin loop, eases the pipeline and the sibling hyperthread
+inline void cpuRelax() noexcept {
+#if defined(__x86_64__) || defined(__i386__)
+    __builtin_ia32_pause();
+#elif defined(__aarch64__)
+    asm volatile("yield");
+#endif
+}
+
+/**
+ * A wait strategy is shared by the producers and the consumer of a queue.
+ * Producers call notify() after every publish; the consumer calls
+ * wait(ready), which returns once ready() is true. ready() is the consumer's
+ * own check, usually "the queue isn't empty or we were told to stop".
+ */
+template <typename T>
+concept WaitStrategy = requires(T t, bool (*ready)()) {
+    t.notify();
+    t.wait(ready);
+};
+
+// Burn the core, lowest latency; for a consumer pinned to a core of its own
+struct SpinWait {
+    void notify() noexcept {}
+
+    template <typename Ready>
+    void wait(Ready&& ready) noexcept {
+        while (!ready()) {
+            cpuRelax();
+        }
+    }
+};
+
+// Give the core away between checks, for a consumer that shares its core
+struct YieldWait {
+    void notify() noexcept {}
+
+    template <typename Ready>
+    void wait(Ready&& ready) noexcept {
+        while (!ready()) {
+            std::this_thread::yield();
+        }
+    }
+};
+
+/**
+ * @brief Spin a little, then sleep in the kernel on a futex until a producer
+ * wakes us. Producers only make the wake syscall while the consumer is
+ * actually parked, otherwise notify() is one atomic add and a load.
+ */
+template <std::uint32_t SpinCount = 1024>
+class FutexWait {
+public:
+    void notify() noexcept {
+        epoch_.fetch_add(1, std::memory_order_seq_cst);
+        if (sleepers_.load(std::memory_order_seq_cst)) {
+            syscall(SYS_futex, reinterpret_cast<std::uint32_t*>(&epoch_), FUTEX_WAKE_PRIVATE, INT_MAX, nullptr,
+                    nullptr, 0);
+        }
+    }
+
+    template <typename Ready>
+    void wait(Ready&& ready) noexcept {
+        for (std::uint32_t i = 0; i < SpinCount; ++i) {
+            if (ready()) {
+                return;
+            }
+            cpuRelax();
+        }
+        while (true) {
+            // announce ourselves before the last look, so a producer publishing
+            // after it either sees us and wakes us or bumps the epoch we sleep on
+            sleepers_.fetch_add(1, std::memory_order_seq_cst);
+            const std::uint32_t epoch = epoch_.load(std::memory_order_seq_cst);
+            if (ready()) {
+                sleepers_.fetch_sub(1, std::memory_order_relaxed);
+                return;
+            }
+            syscall(SYS_futex, reinterpret_cast<std::uint32_t*>(&epoch_), FUTEX_WAIT_PRIVATE, epoch, nullptr,
+                    nullptr, 0);
+            sleepers_.fetch_sub(1, std::memory_order_relaxed);
+        }
+    }
+
+private:
+    static_assert(sizeof(std::atomic<std::uint32_t>) == sizeof(std::uint32_t), "futex needs a plain 32 bit word");
+
+    alignas(CACHE_LINE_SIZE) std::atomic<std::uint32_t> epoch_{0};
+    std::atomic<std::uint32_t> sleepers_{0};
+};
+
+} // namespace elaeo::comm::events
+
+#endif // ELAEO_COMM_EVENTS_WAIT_STRATEGY_H
@@ -0,0 +1,126 @@
+/**
+ * @file work_queue.h
+ * @brief bounded lock free MPSC queue of inline callables.
+ */
+
+#ifndef ELAEO_COMM_EVENTS_WORK_QUEUE_H
+#define ELAEO_COMM_EVENTS_WORK_QUEUE_H
+
+#include <atomic>
+#include <cstddef>
+#include <cstdint>
+#include <type_traits>
+#include <utility>
+#include <events/inline_function.h>
+#include <events/types.h>
+
+namespace elaeo::comm::events {
+
+/**
+ * @brief Work posted to one consumer thread by any number of others, on the
+ * same sequence scheme as MpscRing: a producer claims a slot with a CAS on
+ * the tail, builds the callable right in it and publishes the slot; the
+ * consumer runs it in place and hands the slot back. Nothing is locked,
+ * allocated or copied, and with FunctionSize 48 a slot is one cache line.
+ */
+template <std::size_t Capacity, std::size_t FunctionSize = 48>
+class WorkQueue {
+    static_assert(Capacity >= 2 && (Capacity & (Capacity - 1)) == 0, "Capacity must be a power of two");
+
+public:
+    using Function = InlineFunction<FunctionSize>;
+
+    WorkQueue() noexcept {
+        for (std::size_t i = 0; i < Capacity; ++i) {
+            slots_[i].sequence.store(i, std::memory_order_relaxed);
+        }
+    }
+    WorkQueue(const WorkQueue&) = delete;
+    WorkQueue& operator=(const WorkQueue&) = delete;
+
+    static constexpr std::size_t capacity() noexcept { return Capacity; }
+
+    // Any thread; false when full, the callable is then not taken
+    template <typename F>
+    bool tryPush(F&& function) {
+        using Function = std::decay_t<F>;
+        if constexpr (std::is_nothrow_constructible_v<Function, F>) {
+            return push(std::forward<F>(function));
+        } else {
+            // a copy that may throw is made before a slot is claimed, a claimed
+            // slot must always get published or the consumer stalls at it
+            Function copy(std::forward<F>(function));
+            return push(std::move(copy));
+        }
+    }
+
+    // Consumer only; run what was published before the call, in order, and
+    // return how many ran. Work they post waits for the next call.
+    std::size_t runAll() {
+        const std::uint64_t end = tail_.load(std::memory_order_acquire);
+        std::size_t ran = 0;
+        while (head_ != end) {
+            Slot& s = slots_[head_ & (Capacity - 1)];
+            if (s.sequence.load(std::memory_order_acquire) != head_ + 1) {
+                break; // claimed but still being written, next time
+            }
+            ++ran;
+            Release release{*this, s}; // even if it throws
+            s.function();
+        }
+        return ran;
+    }
+
+    // Consumer only; also false while a pushed callable is still being
+    // written. Claiming a slot and this read are sequentially consistent, so
+    // a consumer that publishes "going to sleep" and then finds the queue
+    // empty can't miss a producer that checks the flag after pushing.
+    bool empty() const noexcept { return tail_.load(std::memory_order_seq_cst) == head_; }
+
+private:
+    // function is only moved, or copied without throwing, into the slot
+    template <typename F>
+    bool push(F&& function) noexcept {
+        std::uint64_t tail = tail_.load(std::memory_order_relaxed);
+        while (true) {
+            Slot& s = slots_[tail & (Capacity - 1)];
+            const std::uint64_t sequence = s.sequence.load(std::memory_order_acquire);
+            const auto diff = static_cast<std::int64_t>(sequence - tail);
+            if (diff == 0) {
+                if (tail_.compare_exchange_weak(tail, tail + 1, std::memory_order_seq_cst,
+                                                std::memory_order_relaxed)) {
+                    s.function.emplace(std::forward<F>(function));
+                    s.sequence.store(tail + 1, std::memory_order_release);
+                    return true;
+                }
+            } else if (diff < 0) {
+                return false;
+            } else {
+                tail = tail_.load(std::memory_order_relaxed);
+            }
+        }
+    }
+
+    struct alignas(CACHE_LINE_SIZE) Slot {
+        std::atomic<std::uint64_t> sequence;
+        Function function;
+    };
+
+    struct Release {
+        WorkQueue& queue;
+        Slot& slot;
+        ~Release() {
+            slot.function.reset();
+            slot.sequence.store(queue.head_ + Capacity, std::memory_order_release);
+            ++queue.head_;
+        }
+    };
+
+    alignas(CACHE_LINE_SIZE) std::atomic<std::uint64_t> tail_{0};
+    alignas(CACHE_LINE_SIZE) std::uint64_t head_ = 0;
+    Slot slots_[Capacity];
+};
+
+} // namespace elaeo::comm::events
+
+#endif // ELAEO_COMM_EVENTS_WORK_QUEUE_H
@@ -0,0 +1,109 @@
+/**
+ * @file publisher_bench.cpp
+ * @brief per event cost of the dynamic EventPublisher against StaticPublisher.
+ *
+ * usage: events_publisher_bench [events]
+ */
+
+#include <chrono>
+#include <cstdint>
+#include <cstdio>
+#include <cstdlib>
+#include <memory>
+#include <vector>
+#include <events/publisher.h>
+
+using namespace elaeo::comm::events;
+
+namespace {
+
+struct Tick {
+    std::uint32_t token;
+    std::int32_t price;
+    std::uint32_t quantity;
+    char side;
+};
+
+// The same four subscribers, as plain handlers and as lambdas
+struct Volume {
+    std::uint64_t total = 0;
+    void handleEvent(const Tick& tick) { total += tick.quantity; }
+};
+struct Turnover {
+    static constexpr priority_t priority = PRIORITY_HIGH;
+    std::int64_t total = 0;
+    void handleEvent(const Tick& tick) { total += static_cast<std::int64_t>(tick.price) * tick.quantity; }
+};
+struct BuyCount {
+    std::uint64_t total = 0;
+    void handleEvent(const Tick& tick) { total += tick.side == 'B'; }
+};
+struct LastPrice {
+    static constexpr priority_t priority = PRIORITY_HIGHEST;
+    std::int32_t prices[256] = {};
+    void handleEvent(const Tick& tick) { prices[tick.token & 255] = tick.price; }
+};
+
+std::vector<Tick> makeTicks(std::size_t count) {
+    std::vector<Tick> ticks(count);
+    std::uint32_t seed = 12345;
+    for (auto& tick : ticks) {
+        seed = seed * 1664525 + 1013904223;
+        tick = Tick{seed >> 20, static_cast<std::int32_t>(seed % 100000), (seed >> 8) % 500 + 1,
+                    (seed & 1) ? 'B' : 'S'};
+    }
+    return ticks;
+}
+
+template <typename Publisher>
+double nsPerEvent(Publisher& publisher, const std::vector<Tick>& ticks, int rounds) {
+    const auto start = std::chrono::steady_clock::now();
+    for (int round = 0; round < rounds; ++round) {
+        for (const Tick& tick : ticks) {
+            publisher.publishEvent(tick);
+        }
+    }
+    const double ns = std::chrono::duration<double, std::nano>(std::chrono::steady_clock::now() - start).count();
+    return ns / (static_cast<double>(ticks.size()) * rounds);
+}
+
+template <typename Handler>
+std::shared_ptr<EventCallbackBase<Tick>> lambdaFor(Handler& handler) {
+    auto callback = [&handler](const Tick& tick) { handler.handleEvent(tick); };
+    return std::make_shared<LambdaCallback<Tick, decltype(callback)>>(std::move(callback));
+}
+
+} // namespace
+
+int main(int argc, char* argv[]) {
+    const std::size_t events = argc > 1 ? std::strtoull(argv[1], nullptr, 10) : 1 << 16;
+    const int rounds = 200;
+    const std::vector<Tick> ticks = makeTicks(events);
+
+    Volume volume;
+    Turnover turnover;
+    BuyCount buys;
+    LastPrice last;
+    EventPublisher<Tick> dynamic;
+    dynamic.registerCallback(lambdaFor(volume));
+    dynamic.registerCallback(lambdaFor(turnover), Turnover::priority);
+    dynamic.registerCallback(lambdaFor(buys));
+    dynamic.registerCallback(lambdaFor(last), LastPrice::priority);
+
+    StaticPublisher<Tick, Volume, Turnover, BuyCount, LastPrice> fixed;
+
+    // warm both up before timing
+    nsPerEvent(dynamic, ticks, 1);
+    nsPerEvent(fixed, ticks, 1);
+    const double dynamicNs = nsPerEvent(dynamic, ticks, rounds);
+    const double staticNs = nsPerEvent(fixed, ticks, rounds);
+
+    std::printf("%zu events x %d rounds, 4 subscribers\n", events, rounds);
+    std::printf("EventPublisher  %6.2f ns per event\n", dynamicNs);
+    std::printf("StaticPublisher %6.2f ns per event (%.1fx)\n", staticNs, dynamicNs / staticNs);
+
+    // both saw the same events, and the work stays observable
+    const bool same = volume.total == fixed.handler<0>().total && turnover.total == fixed.handler<1>().total &&
+                      buys.total == fixed.handler<2>().total;
+    return same ? 0 : 1;
+}
@@ -0,0 +1,161 @@
+/**
+ * @file queue_bench.cpp
+ * @brief enqueue / dequeue cost, cross thread throughput and latency of the queued publishers.
+ *
+ * usage: events_queue_bench [events]
+ *
+ * Throughput floods the ring; latency sends one event at a time and waits for
+ * its callback before the next, so it measures publish to callback and not
+ * the time spent queued behind a full ring.
+ */
+
+#include <algorithm>
+#include <atomic>
+#include <chrono>
+#include <cstdint>
+#include <cstdio>
+#include <cstdlib>
+#include <memory>
+#include <thread>
+#include <vector>
+#include <events/queued_publisher.h>
+
+using namespace elaeo::comm::events;
+
+namespace {
+
+constexpr std::size_t RING_SIZE = 1 << 16;
+
+struct Tick {
+    std::uint64_t sent_ns;
+    std::uint32_t producer;
+    std::uint32_t seq;
+    double price;
+};
+
+std::uint64_t nowNs() {
+    return std::chrono::duration_cast<std::chrono::nanoseconds>(
+               std::chrono::steady_clock::now().time_since_epoch())
+        .count();
+}
+
+void report(const char* name, std::vector<std::uint64_t>& latencies) {
+    std::sort(latencies.begin(), latencies.end());
+    const auto at = [&](double q) { return latencies[static_cast<std::size_t>(q * (latencies.size() - 1))]; };
+    std::printf("%-24s p50 %7lu ns  p99 %8lu ns  p99.9 %9lu ns  max %9lu ns\n", name, at(0.5), at(0.99), at(0.999),
+                latencies.back());
+}
+
+// Single thread push + pop of one event, the bare cost of the ring
+template <typename Ring>
+void ringCost(const char* name, std::size_t events) {
+    auto ring = std::make_unique<Ring>();
+    Tick tick{};
+    const auto start = std::chrono::steady_clock::now();
+    for (std::size_t i = 0; i < events; ++i) {
+        tick.seq = static_cast<std::uint32_t>(i);
+        ring->tryPush(tick);
+        ring->tryPop(tick);
+    }
+    const double ns = std::chrono::duration<double, std::nano>(std::chrono::steady_clock::now() - start).count();
+    std::printf("%-24s %10.2f ns per push + pop\n", name, ns / events);
+}
+
+// producer threads publish events between them as fast as the ring takes
+// them, the consumer thread counts them
+template <typename Publisher>
+void throughput(const char* name, std::size_t events, std::size_t producers) {
+    auto publisher = std::make_unique<Publisher>();
+    std::size_t dispatched = 0;
+    auto callback = [&dispatched](const Tick&) { ++dispatched; };
+    publisher->registerCallback(std::make_shared<LambdaCallback<Tick, decltype(callback)>>(std::move(callback)));
+
+    const auto start = std::chrono::steady_clock::now();
+    std::thread consumer([&publisher] { publisher->run(); });
+    std::vector<std::thread> threads;
+    for (std::size_t p = 0; p < producers; ++p) {
+        threads.emplace_back([&publisher, events, producers, p] {
+            for (std::size_t i = p; i < events; i += producers) {
+                const Tick tick{0, static_cast<std::uint32_t>(p), static_cast<std::uint32_t>(i), 100.0};
+                while (!publisher->publishEvent(tick)) {
+                    std::this_thread::yield();
+                }
+            }
+        });
+    }
+    for (auto& thread : threads) {
+        thread.join();
+    }
+    publisher->stop();
+    consumer.join();
+    const double seconds = std::chrono::duration<double>(std::chrono::steady_clock::now() - start).count();
+    if (dispatched != events) {
+        std::printf("%s: %zu of %zu events dispatched\n", name, dispatched, events);
+    }
+    std::printf("%-24s %10.2f Mev/s\n", name, dispatched / seconds / 1e6);
+}
+
+// one event in flight at a time: publish, wait for the callback, repeat; the
+// consumer stamps each one's latency from publish to callback
+template <typename Publisher>
+void latency(const char* name, std::size_t samples) {
+    auto publisher = std::make_unique<Publisher>();
+    std::vector<std::uint64_t> latencies;
+    latencies.reserve(samples);
+    std::atomic<std::uint32_t> acked{0};
+    auto callback = [&latencies, &acked](const Tick& tick) {
+        latencies.push_back(nowNs() - tick.sent_ns);
+        acked.store(tick.seq + 1, std::memory_order_release);
+    };
+    publisher->registerCallback(std::make_shared<LambdaCallback<Tick, decltype(callback)>>(std::move(callback)));
+
+    std::thread consumer([&publisher] { publisher->run(); });
+    for (std::size_t i = 0; i < samples; ++i) {
+        const Tick tick{nowNs(), 0, static_cast<std::uint32_t>(i), 100.0};
+        while (!publisher->publishEvent(tick)) {
+            cpuRelax();
+        }
+        // spin a little, then yield in case the consumer shares our core
+        for (unsigned spins = 0; acked.load(std::memory_order_acquire) != i + 1; ++spins) {
+            if (spins < 1000) {
+                cpuRelax();
+            } else {
+                std::this_thread::yield();
+            }
+        }
+    }
+    publisher->stop();
+    consumer.join();
+    report(name, latencies);
+}
+
+} // namespace
+
+int main(int argc, char* argv[]) {
+    const std::size_t events = argc > 1 ? std::strtoull(argv[1], nullptr, 10) : 1000000;
+    std::printf("%zu events of %zu bytes, %u cores\n\n", events, sizeof(Tick), std::thread::hardware_concurrency());
+
+    ringCost<SpscRing<Tick, RING_SIZE>>("spsc ring", events);
+    ringCost<MpscRing<Tick, RING_SIZE>>("mpsc ring", events);
+    std::printf("\n");
+
+    std::printf("throughput, ring kept full\n");
+    throughput<SpscPublisher<Tick, RING_SIZE, SpinWait>>("spsc spin", events, 1);
+    throughput<SpscPublisher<Tick, RING_SIZE, YieldWait>>("spsc yield", events, 1);
+    throughput<SpscPublisher<Tick, RING_SIZE, FutexWait<>>>("spsc futex", events, 1);
+    throughput<MpscPublisher<Tick, RING_SIZE, SpinWait>>("mpsc spin, 2 producers", events, 2);
+    throughput<MpscPublisher<Tick, RING_SIZE, YieldWait>>("mpsc yield, 2 producers", events, 2);
+    throughput<MpscPublisher<Tick, RING_SIZE, FutexWait<>>>("mpsc futex, 2 producers", events, 2);
+    std::printf("\n");
+
+    // a round trip per sample, fewer of them
+    const std::size_t samples = std::clamp<std::size_t>(events / 10, 1, 100000);
+    std::printf("latency, one event in flight, %zu samples\n", samples);
+    latency<SpscPublisher<Tick, RING_SIZE, SpinWait>>("spsc spin", samples);
+    latency<SpscPublisher<Tick, RING_SIZE, YieldWait>>("spsc yield", samples);
+    latency<SpscPublisher<Tick, RING_SIZE, FutexWait<>>>("spsc futex", samples);
+    latency<MpscPublisher<Tick, RING_SIZE, SpinWait>>("mpsc spin", samples);
+    latency<MpscPublisher<Tick, RING_SIZE, YieldWait>>("mpsc yield", samples);
+    latency<MpscPublisher<Tick, RING_SIZE, FutexWait<>>>("mpsc futex", samples);
+    return 0;
+}
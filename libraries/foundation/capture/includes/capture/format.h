@@ -0,0 +1,71 @@
+/**
+ * @file format.h
+ * @brief on disk layout of elaeo capture files.
+ *
+ *   FileHeader                      64 bytes
+ *   RecordHeader + payload, ...     each record padded to 8 bytes
+ *   IndexEntry[record_count]        written on close
+ *
+ * Everything is little endian host layout and 8 byte aligned, so a mapped file
+ * is read in place. The header's index_offset stays 0 until the writer closes
+ * cleanly; readers then fall back to walking the records.
+ */
+
+#ifndef ELAEO_FOUND_CAPTURE_FORMAT_H
+#define ELAEO_FOUND_CAPTURE_FORMAT_H
+
+#include <cstddef>
+#include <cstdint>
+
+namespace elaeo::foundation::capture {
+
+constexpr uint64_t kMagic = 0x3152545041434c45ULL; // "ELCAPTR1"
+constexpr uint32_t kVersion = 1;
+constexpr std::size_t kAlignment = 8;
+
+/// What a record holds, free for the application to extend past User
+enum class RecordKind : uint16_t {
+  Message = 0, ///< a message received from the wire
+  Request = 1, ///< a request we sent
+  User = 256,
+};
+
+struct FileHeader {
+  uint64_t magic;
+  uint32_t version;
+  uint32_t header_size;    ///< sizeof(FileHeader), records start here
+  int64_t created_ns;      ///< wall clock, ns since epoch
+  uint64_t index_offset;   ///< 0 while the file is open for writing / wasn't closed
+  uint64_t record_count;   ///< valid once index_offset is set
+  uint64_t data_end;       ///< end of the last record, valid once index_offset is set
+  char label[16];          ///< free form, NUL padded
+};
+
+struct RecordHeader {
+  uint32_t length; ///< payload bytes, excluding this header and padding
+  uint16_t stream_id;
+  uint16_t kind;   ///< RecordKind
+  uint32_t seq_no;
+  uint32_t reserved;
+  int64_t timestamp_ns;
+};
+
+struct IndexEntry {
+  uint64_t offset; ///< of the RecordHeader
+  uint32_t seq_no;
+  uint16_t stream_id;
+  uint16_t kind;
+};
+
+static_assert(sizeof(FileHeader) == 64);
+static_assert(sizeof(RecordHeader) == 24);
+static_assert(sizeof(IndexEntry) == 16);
+
+/// Bytes a record with payload_length bytes takes in the file
+constexpr std::size_t recordSize(std::size_t payload_length) {
+  return (sizeof(RecordHeader) + payload_length + kAlignment - 1) & ~(kAlignment - 1);
+}
+
+} // namespace elaeo::foundation::capture
+
+#endif // ELAEO_FOUND_CAPTURE_FORMAT_H
@@ -0,0 +1,111 @@
+/**
+ * @file reader.h
+ * @brief memory mapped reader of capture files.
+ */
+
+#ifndef ELAEO_FOUND_CAPTURE_READER_H
+#define ELAEO_FOUND_CAPTURE_READER_H
+
+#include <cstddef>
+#include <cstdint>
+#include <iterator>
+#include <span>
+#include <string>
+#include "capture/format.h"
+
+namespace elaeo::foundation::capture {
+
+/// A record viewed in place in the mapped file
+struct Record {
+  const RecordHeader* header;
+  std::span<const std::byte> payload;
+
+  uint32_t seqNo() const { return header->seq_no; }
+  uint16_t streamId() const { return header->stream_id; }
+  RecordKind kind() const { return static_cast<RecordKind>(header->kind); }
+  int64_t timestampNs() const { return header->timestamp_ns; }
+};
+
+/**
+ * @brief Maps a capture file read only and hands out records as views into the
+ * mapping; iterating is pointer arithmetic, nothing is parsed or copied. With
+ * an index (cleanly closed file) records are also addressable by position.
+ */
+class Reader {
+public:
+  class Iterator {
+  public:
+    using iterator_category = std::forward_iterator_tag;
+    using value_type = Record;
+    using difference_type = std::ptrdiff_t;
+    using pointer = void;
+    using reference = Record;
+
+    Iterator() = default;
+    Iterator(const std::byte* position, const std::byte* end) : m_position(position), m_end(end) {}
+
+    Record operator*() const {
+      const auto* header = reinterpret_cast<const RecordHeader*>(m_position);
+      return Record{header, {m_position + sizeof(RecordHeader), header->length}};
+    }
+    Iterator& operator++() {
+      m_position += recordSize(reinterpret_cast<const RecordHeader*>(m_position)->length);
+      if (!fits()) {
+        m_position = m_end;
+      }
+      return *this;
+    }
+    Iterator operator++(int) {
+      Iterator previous = *this;
+      ++*this;
+      return previous;
+    }
+    bool operator==(const Iterator& other) const { return m_position == other.m_position; }
+
+    /// false when the bytes left can't hold the next record (torn tail of an unclosed file)
+    bool fits() const {
+      if (m_end - m_position < static_cast<std::ptrdiff_t>(sizeof(RecordHeader))) {
+        return false;
+      }
+      const auto* header = reinterpret_cast<const RecordHeader*>(m_position);
+      return static_cast<std::size_t>(m_end - m_position) >= recordSize(header->length);
+    }
+
+  private:
+    const std::byte* m_position = nullptr;
+    const std::byte* m_end = nullptr;
+  };
+
+  Reader() = default;
+  ~Reader();
+
+  Reader(const Reader&) = delete;
+  Reader& operator=(const Reader&) = delete;
+
+  /// false with error() set if path isn't a readable capture file
+  bool open(const std::string& path);
+  void close();
+
+  Iterator begin() const;
+  Iterator end() const { return Iterator(m_data_end, m_data_end); }
+
+  /// From the index, so only for cleanly closed files
+  bool indexed() const { return m_index != nullptr; }
+  std::span<const IndexEntry> index() const { return {m_index, m_index ? m_header->record_count : 0}; }
+  Record at(std::size_t position) const;
+
+  const FileHeader& header() const { return *m_header; }
+  const std::string& error() const { return m_error; }
+
+private:
+  const std::byte* m_map = nullptr;
+  std::size_t m_size = 0;
+  const FileHeader* m_header = nullptr;
+  const std::byte* m_data_end = nullptr;
+  const IndexEntry* m_index = nullptr;
+  std::string m_error;
+};
+
+} // namespace elaeo::foundation::capture
+
+#endif // ELAEO_FOUND_CAPTURE_READER_H
@@ -0,0 +1,73 @@
+/**
+ * @file writer.h
+ * @brief buffered writer of capture files.
+ */
+
+#ifndef ELAEO_FOUND_CAPTURE_WRITER_H
+#define ELAEO_FOUND_CAPTURE_WRITER_H
+
+#include <cstddef>
+#include <cstdint>
+#include <span>
+#include <string>
+#include <vector>
+#include "capture/format.h"
+
+namespace elaeo::foundation::capture {
+
+/**
+ * @brief Appends records to a capture file through batch_buffers buffers of
+ * buffer_size bytes, hitting the file only once they are all full (or on
+ * flush()/close()), never per record. A flush hands every filled buffer to a
+ * single writev, so bulk captures go out in batch_buffers * buffer_size byte
+ * syscalls without one huge contiguous allocation.
+ *
+ * close() appends the index and completes the header; a file that was never
+ * closed is still readable, just without the index.
+ *
+ * Not thread safe, one writer per file.
+ */
+class Writer {
+public:
+  explicit Writer(std::size_t buffer_size = std::size_t{1} << 20, std::size_t batch_buffers = 1);
+  ~Writer();
+
+  Writer(const Writer&) = delete;
+  Writer& operator=(const Writer&) = delete;
+
+  /// Create (truncate) path, false with error() set on failure
+  bool open(const std::string& path, const std::string& label = {});
+
+  bool write(uint32_t seq_no, uint16_t stream_id, std::span<const std::byte> payload,
+             RecordKind kind = RecordKind::Message);
+  bool write(uint32_t seq_no, uint16_t stream_id, int64_t timestamp_ns, std::span<const std::byte> payload,
+             RecordKind kind = RecordKind::Message);
+
+  /// Push buffered records to the file
+  bool flush();
+
+  /// Flush, write the index and finish the header
+  bool close();
+
+  bool isOpen() const { return m_fd >= 0; }
+  uint64_t records() const { return m_index.size(); }
+  uint64_t bytes() const { return m_offset; }
+  const std::string& error() const { return m_error; }
+
+private:
+  bool fail(const char* what);
+  bool writeAll(const void* data, std::size_t size);
+  std::byte* reserve(std::size_t size);
+
+  int m_fd = -1;
+  std::vector<std::vector<std::byte>> m_buffers;
+  std::vector<std::size_t> m_used; ///< bytes filled per buffer
+  std::size_t m_current = 0;       ///< buffer being filled
+  uint64_t m_offset = 0; ///< file offset of the next record
+  std::vector<IndexEntry> m_index;
+  std::string m_error;
+};
+
+} // namespace elaeo::foundation::capture
+
+#endif // ELAEO_FOUND_CAPTURE_WRITER_H
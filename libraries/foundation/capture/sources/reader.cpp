@@ -0,0 +1,84 @@
+#include "capture/reader.h"
+#include <cerrno>
+#include <cstring>
+#include <fcntl.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <unistd.h>
+
+namespace elaeo::foundation::capture {
+
+Reader::~Reader() { close(); }
+
+bool Reader::open(const std::string& path) {
+  close();
+  m_error.clear();
+
+  const int fd = ::open(path.c_str(), O_RDONLY);
+  if (fd < 0) {
+    m_error = "open: " + std::string(std::strerror(errno));
+    return false;
+  }
+  struct stat st{};
+  if (fstat(fd, &st) != 0 || static_cast<std::size_t>(st.st_size) < sizeof(FileHeader)) {
+    m_error = "not a capture file (too short)";
+    ::close(fd);
+    return false;
+  }
+
+  m_size = static_cast<std::size_t>(st.st_size);
+  void* map = mmap(nullptr, m_size, PROT_READ, MAP_PRIVATE, fd, 0);
+  ::close(fd);
+  if (map == MAP_FAILED) {
+    m_error = "mmap: " + std::string(std::strerror(errno));
+    return false;
+  }
+  // records are read front to back
+  madvise(map, m_size, MADV_SEQUENTIAL);
+  m_map = static_cast<const std::byte*>(map);
+  m_header = reinterpret_cast<const FileHeader*>(m_map);
+
+  if (m_header->magic != kMagic || m_header->version != kVersion || m_header->header_size < sizeof(FileHeader)) {
+    m_error = "not a version " + std::to_string(kVersion) + " capture file";
+    close();
+    return false;
+  }
+
+  const uint64_t index_bytes = m_header->record_count * sizeof(IndexEntry);
+  if (m_header->index_offset != 0 && m_header->data_end <= m_header->index_offset &&
+      m_header->index_offset + index_bytes <= m_size) {
+    m_data_end = m_map + m_header->data_end;
+    m_index = reinterpret_cast<const IndexEntry*>(m_map + m_header->index_offset);
+  } else {
+    // never closed, the records run to the end of the file
+    m_data_end = m_map + m_size;
+  }
+  return true;
+}
+
+void Reader::close() {
+  if (m_map) {
+    munmap(const_cast<std::byte*>(m_map), m_size);
+  }
+  m_map = nullptr;
+  m_size = 0;
+  m_header = nullptr;
+  m_data_end = nullptr;
+  m_index = nullptr;
+}
+
+Reader::Iterator Reader::begin() const {
+  if (!m_map) {
+    return end();
+  }
+  Iterator first(m_map + m_header->header_size, m_data_end);
+  return first.fits() ? first : end();
+}
+
+Record Reader::at(std::size_t position) const {
+  const std::byte* record = m_map + m_index[position].offset;
+  const auto* header = reinterpret_cast<const RecordHeader*>(record);
+  return Record{header, {record + sizeof(RecordHeader), header->length}};
+}
+
+} // namespace elaeo::foundation::capture
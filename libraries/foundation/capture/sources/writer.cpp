@@ -0,0 +1,174 @@
+#include "capture/writer.h"
+#include <algorithm>
+#include <cerrno>
+#include <chrono>
+#include <climits>
+#include <cstring>
+#include <fcntl.h>
+#include <sys/uio.h>
+#include <unistd.h>
+
+namespace elaeo::foundation::capture {
+
+namespace {
+int64_t nowNs() {
+  return std::chrono::duration_cast<std::chrono::nanoseconds>(std::chrono::system_clock::now().time_since_epoch())
+      .count();
+}
+} // namespace
+
+Writer::Writer(std::size_t buffer_size, std::size_t batch_buffers)
+    : m_buffers(std::clamp<std::size_t>(batch_buffers, 1, IOV_MAX)), m_used(m_buffers.size(), 0) {
+  for (auto& buffer : m_buffers) {
+    buffer.resize(std::max(buffer_size, recordSize(0xFFFF)));
+  }
+}
+
+Writer::~Writer() { close(); }
+
+bool Writer::open(const std::string& path, const std::string& label) {
+  close();
+  m_error.clear();
+  m_fd = ::open(path.c_str(), O_WRONLY | O_CREAT | O_TRUNC, 0644);
+  if (m_fd < 0) {
+    return fail("open");
+  }
+
+  FileHeader header{};
+  header.magic = kMagic;
+  header.version = kVersion;
+  header.header_size = sizeof(FileHeader);
+  header.created_ns = nowNs();
+  std::memcpy(header.label, label.data(), std::min(label.size(), sizeof(header.label)));
+  std::fill(m_used.begin(), m_used.end(), 0);
+  m_current = 0;
+  std::memcpy(reserve(sizeof(header)), &header, sizeof(header));
+  m_offset = sizeof(header);
+  m_index.clear();
+  return true;
+}
+
+bool Writer::write(uint32_t seq_no, uint16_t stream_id, std::span<const std::byte> payload, RecordKind kind) {
+  return write(seq_no, stream_id, nowNs(), payload, kind);
+}
+
+bool Writer::write(uint32_t seq_no, uint16_t stream_id, int64_t timestamp_ns, std::span<const std::byte> payload,
+                   RecordKind kind) {
+  if (m_fd < 0 || payload.size() > UINT32_MAX) {
+    return false;
+  }
+  const std::size_t size = recordSize(payload.size());
+  const RecordHeader header{static_cast<uint32_t>(payload.size()), stream_id, static_cast<uint16_t>(kind), seq_no, 0,
+                            timestamp_ns};
+
+  if (size > m_buffers.front().size()) {
+    // larger than a whole buffer, write it straight through
+    static constexpr std::byte padding[kAlignment] = {};
+    if (!flush() || !writeAll(&header, sizeof(header)) || !writeAll(payload.data(), payload.size()) ||
+        !writeAll(padding, size - sizeof(header) - payload.size())) {
+      return false;
+    }
+  } else {
+    if (m_used[m_current] + size > m_buffers[m_current].size()) {
+      if (m_current + 1 == m_buffers.size()) {
+        if (!flush()) {
+          return false;
+        }
+      } else {
+        ++m_current;
+      }
+    }
+    std::byte* out = reserve(size);
+    std::memcpy(out, &header, sizeof(header));
+    std::memcpy(out + sizeof(header), payload.data(), payload.size());
+    std::memset(out + sizeof(header) + payload.size(), 0, size - sizeof(header) - payload.size());
+  }
+
+  m_index.push_back(IndexEntry{m_offset, seq_no, stream_id, static_cast<uint16_t>(kind)});
+  m_offset += size;
+  return true;
+}
+
+std::byte* Writer::reserve(std::size_t size) {
+  std::byte* out = m_buffers[m_current].data() + m_used[m_current];
+  m_used[m_current] += size;
+  return out;
+}
+
+bool Writer::flush() {
+  if (m_fd < 0) {
+    return false;
+  }
+
+  iovec iov[IOV_MAX];
+  int count = 0;
+  for (std::size_t i = 0; i <= m_current; ++i) {
+    if (m_used[i] > 0) {
+      iov[count++] = iovec{m_buffers[i].data(), m_used[i]};
+    }
+    m_used[i] = 0;
+  }
+  m_current = 0;
+
+  // one writev for the whole batch, resumed where a short write left off
+  for (iovec* next = iov; count > 0;) {
+    const ssize_t written = ::writev(m_fd, next, count);
+    if (written < 0) {
+      if (errno == EINTR) {
+        continue;
+      }
+      return fail("writev");
+    }
+    for (auto left = static_cast<std::size_t>(written); left > 0 && count > 0;) {
+      const std::size_t step = std::min(left, next->iov_len);
+      next->iov_base = static_cast<std::byte*>(next->iov_base) + step;
+      next->iov_len -= step;
+      left -= step;
+      if (next->iov_len == 0) {
+        ++next;
+        --count;
+      }
+    }
+  }
+  return true;
+}
+
+bool Writer::close() {
+  if (m_fd < 0) {
+    return false;
+  }
+
+  bool ok = flush() && writeAll(m_index.data(), m_index.size() * sizeof(IndexEntry));
+  if (ok) {
+    // the index is in place, now point the header at it
+    const uint64_t trailer[3] = {m_offset, m_index.size(), m_offset};
+    ok = pwrite(m_fd, trailer, sizeof(trailer), offsetof(FileHeader, index_offset)) == sizeof(trailer) ||
+         fail("pwrite");
+  }
+  ::close(m_fd);
+  m_fd = -1;
+  return ok;
+}
+
+bool Writer::writeAll(const void* data, std::size_t size) {
+  const auto* bytes = static_cast<const std::byte*>(data);
+  while (size > 0) {
+    const ssize_t written = ::write(m_fd, bytes, size);
+    if (written < 0) {
+      if (errno == EINTR) {
+        continue;
+      }
+      return fail("write");
+    }
+    bytes += written;
+    size -= static_cast<std::size_t>(written);
+  }
+  return true;
+}
+
+bool Writer::fail(const char* what) {
+  m_error = std::string(what) + ": " + std::strerror(errno);
+  return false;
+}
+
+} // namespace elaeo::foundation::capture